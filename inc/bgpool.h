@@ -0,0 +1,61 @@
+/*
+ * bgpool.h
+ *
+ * Ring of precomputed items filled by background threads, shared by the
+ * keypair pool (keypool.h) and the ECDSA nonce pool (ecdsa.h). Items are
+ * opaque fixed-size records produced in batches by a callback; the ring
+ * is a bounded lock-free MPMC queue. Producers fill it up to the high
+ * water mark, then sleep until a take drops it to the low water mark.
+ * bgpool_take never blocks and never allocates, and wipes the slot it
+ * took from, so the ring may hold secrets.
+ *
+ * A pool belongs to the process that started it. In a child forked
+ * after bgpool_start the ring is a copy of the parent's, so handing out
+ * its items would give both processes the same secrets: there the pool
+ * is always empty, and bgpool_stop only wipes and frees the copy.
+ */
+
+#ifndef BGPOOL_H
+#define BGPOOL_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BGPOOL_BATCH    8   /* items per producer callback, at most */
+#define BGPOOL_MAX_ITEM 256 /* bytes */
+
+/* Fill items[0..n) (n <= BGPOOL_BATCH, item_size bytes each). Returns 0,
+ * or -1 if nothing could be produced, after which the producer waits
+ * before calling again (10 ms, doubling up to 1 s while it keeps
+ * failing). Called from producer threads. */
+typedef int (*bgpool_produce_fn)(void *ctx, void *items, size_t n);
+
+typedef struct bgpool bgpool_t;
+
+/* Start threads producers for item_size-byte items. Requires
+ * 0 <= low < high, threads >= 1 and item_size <= BGPOOL_MAX_ITEM; ctx
+ * must outlive the pool. Allocates the ring. Returns 0 or -1. */
+int bgpool_start(bgpool_t **pool, size_t item_size, size_t low, size_t high,
+                 unsigned threads, bgpool_produce_fn produce, void *ctx);
+
+/* Copy one item into item and wipe its slot. Returns 0, or -1 if the
+ * ring is empty or the pool was started in another process. Wakes parked
+ * producers when the level reaches low. */
+int bgpool_take(bgpool_t *pool, void *item);
+
+/* Number of items ready right now (a snapshot). */
+size_t bgpool_available(const bgpool_t *pool);
+
+/* Join the producers, wipe the ring and free the pool. In a forked child
+ * there are no producers, and only the copy is wiped and freed. NULL is
+ * ignored. */
+void bgpool_stop(bgpool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BGPOOL_H */
@@ -38,6 +38,16 @@ extern "C" {
 int ec_point_to_bytes(const ec_domain_params_t *curve, const ec_point_t *P,
                       int compressed, uint8_t *out, size_t out_len);
 
+/* Encode n points (affine or Jacobian) back to back: point i occupies
+ * out[i * len .. i * len + len - 1], where len is the size of the chosen
+ * form. All Z coordinates are inverted together with a single field
+ * inversion, so this is much cheaper than n calls to ec_point_to_bytes.
+ * out_len must be at least n * len. Returns 0 on success, or -1 on error
+ * (any point at infinity, buffer too small); on error the contents of out
+ * are unspecified. */
+int ec_points_to_bytes(const ec_domain_params_t *curve, const ec_point_t *P, size_t n,
+                       int compressed, uint8_t *out, size_t out_len);
+
 /* Decode and validate a SEC1 point. Accepts the 65-byte uncompressed and
  * 33-byte compressed forms. Returns 0 on success, -1 if the encoding is
  * malformed, a coordinate is out of range, or the point is not on the
@@ -45,6 +55,14 @@ int ec_point_to_bytes(const ec_domain_params_t *curve, const ec_point_t *P,
 int ec_point_from_bytes(const ec_domain_params_t *curve,
                         const uint8_t *in, size_t in_len, ec_point_t *P);
 
+/* Decode only the x coordinate of a SEC1 point, for x-only ECDH (see
+ * ec3dh_compute_shared_secret_x_dk). The compressed form is validated
+ * with ec_x_on_curve, which needs no square root; the uncompressed form
+ * is validated exactly as in ec_point_from_bytes. Returns 0 on success,
+ * -1 on any validation failure. */
+int ec_point_x_from_bytes(const ec_domain_params_t *curve,
+                          const uint8_t *in, size_t in_len, uint256_t *x);
+
 /* Encode a scalar as 32 big-endian bytes. */
 void ec_scalar_to_bytes(const uint256_t *k, uint8_t out[32]);
 
@@ -0,0 +1,31 @@
+/*
+ * cpu_features.h
+ *
+ * Runtime CPU feature detection for the optional assembly code paths.
+ * Every accelerated routine has a portable fallback; these flags only
+ * decide which one is installed.
+ */
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    EC_CPU_BMI2 = 1 << 0, /* MULX */
+    EC_CPU_ADX  = 1 << 1, /* ADCX / ADOX */
+    EC_CPU_AVX2 = 1 << 2, /* AVX2, with YMM state enabled by the OS */
+    EC_CPU_IFMA = 1 << 3, /* AVX-512F and AVX512-IFMA, with ZMM state enabled */
+};
+
+/* Bitmask of EC_CPU_* flags supported by the running CPU. Always 0 on
+ * non-x86-64 targets. */
+unsigned ec_cpu_features(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CPU_FEATURES_H */
@@ -0,0 +1,43 @@
+/*
+ * ct_select.h
+ *
+ * Constant-time lookup in the precomputed point tables. Every call reads
+ * every entry of the table, whatever the index, and no branch or address
+ * depends on it. On x86-64 the scan runs on AVX2 when the CPU and OS
+ * support it and on SSE2 otherwise; other targets use plain 64-bit masks.
+ *
+ * Tables are arrays of n entries of `words` 64-bit words each. The table
+ * must be EC_TABLE_ALIGN-byte aligned and `words` a multiple of 4 no
+ * larger than EC_TABLE_MAX_WORDS, so every entry starts on a 32-byte
+ * boundary.
+ */
+
+#ifndef CT_SELECT_H
+#define CT_SELECT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EC_TABLE_ALIGN     64
+#define EC_TABLE_MAX_WORDS 16
+
+/* out[0..words) = table entry idx, or all zeros if idx >= n. */
+void ec_table_select(uint64_t *out, const uint64_t *table, size_t n, size_t words, uint64_t idx);
+
+/* Re-run backend selection: level 0 pins the scalar code, 1 allows SSE2,
+ * 2 anything the CPU supports. Level 2 is chosen automatically at load
+ * time, so this is for tests. Not thread safe. */
+void ec_table_select_init(int level);
+
+/* Name of the active backend ("avx2", "sse2" or "scalar"). */
+const char *ec_table_select_backend(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CT_SELECT_H */
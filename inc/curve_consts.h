@@ -0,0 +1,54 @@
+/*
+ * curve_consts.h
+ *
+ * Constants derived from the domain parameters, so the arithmetic does
+ * not rebuild them on every call. Built-in curves point at a static block
+ * through ec_domain_params_t.consts; curves defined at run time leave
+ * consts NULL and get a block filled in on demand (ec_curve_consts).
+ *
+ * A block keeps the parameters it was derived from, and is only used for
+ * a curve whose p, a, b, G and n match them. A copy of a built-in curve
+ * that was modified but still carries the original consts pointer thus
+ * falls back to the on-demand block instead of using stale constants.
+ * Library code reaches the block only through ec_curve_consts_lookup or
+ * ec_curve_consts, never through curve->consts directly.
+ */
+
+#ifndef CURVE_CONSTS_H
+#define CURVE_CONSTS_H
+
+#include "ec.h"
+#include "scalar.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ec_curve_consts {
+    uint256_t p, a, b;     /* the parameters the block was derived from; */
+    uint256_t gx, gy;      /* n is n_mont.n */
+    uint256_t b3;          /* 3b mod p, for the complete addition formulas */
+    uint256_t sqrt_exp;    /* (p + 1) / 4 if p == 3 (mod 4), else 0 */
+    scalar_mont_t n_mont;  /* Montgomery arithmetic mod n */
+    uint8_t a_is_minus3;   /* a == p - 3: cheaper Jacobian doubling */
+    uint8_t g_table;       /* G has the static fixed-base table in gtable.h */
+} ec_curve_consts_t;
+
+/* Compute the block for any curve. */
+void ec_curve_consts_init(const ec_domain_params_t *curve, ec_curve_consts_t *c);
+
+/* curve->consts if it is set and was derived from curve's parameters,
+ * otherwise NULL. A few 32-byte comparisons. */
+const ec_curve_consts_t *ec_curve_consts_lookup(const ec_domain_params_t *curve);
+
+/* ec_curve_consts_lookup(curve) if not NULL, otherwise
+ * ec_curve_consts_init(curve, tmp) and tmp. */
+const ec_curve_consts_t *ec_curve_consts(const ec_domain_params_t *curve, ec_curve_consts_t *tmp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CURVE_CONSTS_H */
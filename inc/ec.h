@@ -2,6 +2,7 @@
 #define EC_H
 
 #include <modplus.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,6 +15,28 @@ typedef struct {
     uint8_t infinity;
 } ec_point_t;
 
+#ifdef __cplusplus
+#define EC_ALIGNAS(n) alignas(n)
+#else
+#define EC_ALIGNAS(n) _Alignas(n)
+#endif
+
+/* Compact point forms for tables and bulk arrays; ec_point_t pads to 104
+ * bytes. ec_affine_t is (x, y) in one 64-byte cache line and cannot hold
+ * the identity. ec_proj_t is homogeneous projective (X : Y : Z), meaning
+ * x = X/Z and y = Y/Z (not Jacobian), with the identity (0 : 1 : 0); it
+ * is 96 bytes, 32-byte aligned so arrays of it stay packed. */
+typedef struct {
+    EC_ALIGNAS(64) uint256_t x;
+    uint256_t y;
+} ec_affine_t;
+
+typedef struct {
+    EC_ALIGNAS(32) uint256_t x;
+    uint256_t y;
+    uint256_t z;
+} ec_proj_t;
+
 typedef struct {
     uint256_t p;
     uint256_t a;
@@ -21,8 +44,21 @@ typedef struct {
     ec_point_t G;
     uint256_t n;
     uint8_t h;
+    /* Derived constants (curve_consts.h). Built-in curves point at a
+     * static block; leave NULL for curves set up at run time. A block is
+     * ignored when its recorded parameters differ from the curve's, so a
+     * modified copy of a built-in curve is safe either way. */
+    const struct ec_curve_consts *consts;
 } ec_domain_params_t;
 
+/* Conversions to and from ec_point_t (affine or Jacobian, as accepted
+ * everywhere else). ec_affine_from_point returns -1, and zeroes A, if P
+ * is the point at infinity. */
+int ec_affine_from_point(const ec_domain_params_t *curve, const ec_point_t *P, ec_affine_t *A);
+void ec_affine_to_point(const ec_affine_t *A, ec_point_t *P);
+void ec_proj_from_point(const ec_domain_params_t *curve, const ec_point_t *P, ec_proj_t *Q);
+void ec_proj_to_point(const ec_domain_params_t *curve, const ec_proj_t *Q, ec_point_t *P);
+
 void ec_negate_point(const ec_domain_params_t *curve, const ec_point_t *P, ec_point_t *R);
 void ec_add_point(const ec_domain_params_t *curve, const ec_point_t *P, const ec_point_t *Q, ec_point_t *R);
 void ec_scalar_multiply(const ec_domain_params_t *curve, const uint256_t *k, const ec_point_t *P, ec_point_t *R);
@@ -30,6 +66,67 @@ void ec_jacobian_to_affine(const ec_domain_params_t *curve, const ec_point_t *P,
 void ec_double_point(const ec_domain_params_t *curve, const ec_point_t *P, ec_point_t *R);
 int ec_point_on_curve(const ec_domain_params_t *curve, const ec_point_t *P);
 
+/* R = P + Q where Q is affine: Q->z is not read and taken as 1. Cheaper
+ * than ec_add_point for Jacobian accumulators fed from affine tables.
+ * Variable time, like ec_add_point and ec_double_point. */
+void ec_add_point_mixed(const ec_domain_params_t *curve, const ec_point_t *P, const ec_point_t *Q, ec_point_t *R);
+
+/* R = k * P like ec_scalar_multiply, but with a sliding-window NAF that
+ * skips zero digits, Jacobian doubling, and additions of affine table
+ * entries. Runs in VARIABLE TIME: only for public k and P (signature
+ * verification, key directory checks, tests). Result is affine. */
+void ec_scalar_multiply_vartime(const ec_domain_params_t *curve, const uint256_t *k,
+                                const ec_point_t *P, ec_point_t *R);
+
+/* R = k[0] * P[0] + ... + k[n-1] * P[n-1]. The result is a Jacobian
+ * point, not normalized (pass it to ec_jacobian_to_affine if needed);
+ * n == 0 gives infinity. Inputs may be affine or Jacobian. No heap use.
+ *
+ * ec_multi_scalar_multiply is constant time in the scalars: it runs
+ * interleaved (Straus) ladders of up to 16 points sharing one set of
+ * doublings. The _vartime variant is for public scalars only and uses
+ * Straus with wNAF for n <= 16 and the Pippenger bucket method above. */
+void ec_multi_scalar_multiply(const ec_domain_params_t *curve, const uint256_t *k,
+                              const ec_point_t *P, size_t n, ec_point_t *R);
+void ec_multi_scalar_multiply_vartime(const ec_domain_params_t *curve, const uint256_t *k,
+                                      const ec_point_t *P, size_t n, ec_point_t *R);
+
+/* R[i] = k[i] * P[i] for i < n, each with the same constant-time ladder as
+ * ec_scalar_multiply; results are affine (z == 1) and are normalized in
+ * groups sharing one field inversion. P and R may be the same array. */
+void ec_scalar_multiply_batch(const ec_domain_params_t *curve, const uint256_t *k,
+                              const ec_point_t *P, ec_point_t *R, size_t n);
+
+/* Projective variants for chained computations (multi-DH, key tweaking,
+ * aggregation): inputs are not normalized and results are left
+ * homogeneous, so a chain of operations pays for one inversion at the
+ * end (ec_proj_to_affine or ec_proj_to_point) instead of one per step.
+ * All are constant time; the identity is (0 : 1 : 0) and is accepted
+ * everywhere. Outputs may alias inputs.
+ *
+ * ec_scalar_multiply_proj: R = k * P, same ladder as ec_scalar_multiply.
+ * ec_add_proj:             R = P + Q, complete addition.
+ * ec_add_proj_mixed:       R = P + Q for an affine Q.
+ * ec_proj_to_affine:       normalize; returns -1 (A zeroed) for the identity. */
+void ec_scalar_multiply_proj(const ec_domain_params_t *curve, const uint256_t *k,
+                             const ec_proj_t *P, ec_proj_t *R);
+void ec_add_proj(const ec_domain_params_t *curve, const ec_proj_t *P, const ec_proj_t *Q, ec_proj_t *R);
+void ec_add_proj_mixed(const ec_domain_params_t *curve, const ec_proj_t *P, const ec_affine_t *Q,
+                       ec_proj_t *R);
+void ec_proj_from_affine(const ec_affine_t *A, ec_proj_t *P);
+int ec_proj_to_affine(const ec_domain_params_t *curve, const ec_proj_t *P, ec_affine_t *A);
+
+/* 1 if x < p and x is the affine x coordinate of a curve point (one of
+ * +-P), 0 otherwise. Variable time; meant for public keys. */
+int ec_x_on_curve(const ec_domain_params_t *curve, const uint256_t *x);
+
+/* x-only constant-time ladder: x_out = x(k * P) for the curve point P
+ * with affine x coordinate x (the sign of y is irrelevant). k must be in
+ * [1, n-1] and x must pass ec_x_on_curve. Returns 0, or -1 if k is out
+ * of range or the result is the point at infinity. */
+int ec_scalar_multiply_x(const ec_domain_params_t *curve, const uint256_t *k,
+                         const uint256_t *x, uint256_t *x_out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -19,12 +19,33 @@ enum {
     EC3DH_ERR_PUBKEY_INVALID  = -3, /* peer/own public key not a valid curve point */
     EC3DH_ERR_SHARED_INFINITY = -4, /* shared point is the point at infinity */
     EC3DH_ERR_KDF             = -5, /* key derivation failed */
+    EC3DH_ERR_POOL            = -6, /* keypool.h: bad parameters, out of memory or no threads */
 };
 
 int ec3dh_generate_keypair(const ec_domain_params_t *curve, uint256_t *private_key, ec_point_t *pubkey);
+/* Generate n keypairs at once. The scalar multiplications share their
+ * final normalization (see ec_scalar_multiply_batch), which makes bulk key
+ * generation cheaper than n calls to ec3dh_generate_keypair. On error no
+ * private key is left behind. */
+int ec3dh_generate_keypairs(const ec_domain_params_t *curve, uint256_t *private_keys, ec_point_t *pubkeys, size_t n);
 int ec3dh_compute_shared_secret_dk(const ec_domain_params_t *curve, const uint256_t *private_key, const ec_point_t *peer_pubkey,
                                    uint8_t *encryption_key, size_t enc_key_len, uint8_t *mac_key, size_t mac_key_len);
 
+/* Same as ec3dh_compute_shared_secret_dk, but takes only the peer's affine
+ * x coordinate (see ec_point_x_from_bytes), so a compressed peer key never
+ * has to be decompressed. */
+int ec3dh_compute_shared_secret_x_dk(const ec_domain_params_t *curve, const uint256_t *private_key, const uint256_t *peer_x,
+                                     uint8_t *encryption_key, size_t enc_key_len, uint8_t *mac_key, size_t mac_key_len);
+
+/* Same as ec3dh_compute_shared_secret_dk for a peer key that has already
+ * been validated, such as a record of an ec_keystore_t (keystore.h): the
+ * curve membership check is skipped. Keys straight from the wire must go
+ * through codec.h or the checked call instead. */
+int ec3dh_compute_shared_secret_trusted_dk(const ec_domain_params_t *curve, const uint256_t *private_key,
+                                           const ec_affine_t *peer_pubkey,
+                                           uint8_t *encryption_key, size_t enc_key_len,
+                                           uint8_t *mac_key, size_t mac_key_len);
+
 #ifdef __cplusplus
 }
 #endif
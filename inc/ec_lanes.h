@@ -0,0 +1,67 @@
+/*
+ * ec_lanes.h
+ *
+ * Lane-parallel constant-time scalar multiplication for the P-256 field,
+ * used by ec_scalar_multiply_batch. Each SIMD lane runs the ladder of
+ * wnaf_mul_const in ec.c for its own point and scalar: the same 257
+ * complete doublings and mixed complete additions, the same table scan
+ * (every entry read, selected by a per-lane mask) and the same
+ * discarded sum for zero digits. Lanes never branch on their data.
+ *
+ * Backends, picked at load time from cpu_features.h:
+ *   "avx512-ifma"  8 lanes, five 52-bit limbs, VPMADD52LUQ/HUQ products
+ *   "avx2"         4 lanes, ten 26-bit limbs, VPMULUDQ products
+ * Both use Montgomery multiplication with R = 2^260, which for P-256
+ * needs no per-product multiplier since p = -1 mod 2^52. Elsewhere there
+ * is no backend and ec_lanes_width() is 0.
+ */
+
+#ifndef EC_LANES_H
+#define EC_LANES_H
+
+#include "ec.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EC_LANES_MAX    8
+#define EC_LANES_TABLE  8   /* odd multiples 1P .. 15P per lane (TABLE_SIZE in ec.c) */
+#define EC_LANES_DIGITS 257 /* signed window digits per scalar (L in ec.c) */
+
+/* One ladder digit: |d| in bits 0..6, the sign in bit 7. */
+#define EC_LANES_DIGIT(abs_val, sign) ((uint8_t)((abs_val) | ((sign) << 7)))
+
+/* Run ec_lanes_width() ladders at once, on a curve over the P-256 prime
+ * with coefficient a and b3 = 3b mod p. Lane i reads its affine table
+ * T[i * EC_LANES_TABLE ..] and its digits[i * EC_LANES_DIGITS ..] (least
+ * significant first) and writes the projective Q[i], with coordinates
+ * fully reduced. Does nothing when ec_lanes_width() is 0. */
+void ec_lanes_ladder(const uint256_t *a, const uint256_t *b3, const ec_affine_t *T,
+                     const uint8_t *digits, ec_proj_t *Q);
+
+/* Lanes of the active backend, 0 when there is none. */
+unsigned ec_lanes_width(void);
+
+/* Re-run backend selection: level 0 disables the lanes, 1 allows AVX2,
+ * 2 anything the CPU supports. Level 2 is chosen automatically at load
+ * time, so this is for tests. Not thread safe. */
+void ec_lanes_select(int level);
+
+/* Name of the active backend ("avx512-ifma", "avx2" or "none"). */
+const char *ec_lanes_backend(void);
+
+/* Backend entry points, for ec_lanes.c. */
+void ec_lanes_ladder_avx2(const uint256_t *a, const uint256_t *b3, const ec_affine_t *T,
+                          const uint8_t *digits, ec_proj_t *Q);
+void ec_lanes_ladder_ifma(const uint256_t *a, const uint256_t *b3, const ec_affine_t *T,
+                          const uint8_t *digits, ec_proj_t *Q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EC_LANES_H */
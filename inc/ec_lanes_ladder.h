@@ -0,0 +1,310 @@
+/*
+ * ec_lanes_ladder.h
+ *
+ * Body of the lane-parallel ladder, shared by src/ec_lanes_avx2.c and
+ * src/ec_lanes_ifma.c. Not an ordinary header: a backend defines its
+ * vector primitives and field product, then includes this file once.
+ * It must provide
+ *
+ *   LANES, NLIMB, RADIX   lanes per vector, limbs per element, bits per limb
+ *   LANES_TARGET          attribute enabling the instruction set
+ *   LANES_LADDER          name of the ladder function to define
+ *   vec_t                 one limb of LANES elements, in 64-bit lanes
+ *   v_zero v_set1 v_load v_store v_add v_sub v_and v_or v_andnot (~a & b)
+ *   v_srli (a macro, literal shift count) v_eq (all ones where equal)
+ *   lfe_t, lfe_mont_mul   r = a b / 2^(NLIMB RADIX) mod p
+ *   P_LIMBS, P2_LIMBS     p and 2p in radix 2^RADIX
+ *
+ * Field elements keep every limb below 2^RADIX and the value below 2p,
+ * the range lfe_mont_mul takes and returns. Coordinates stay in the
+ * Montgomery domain for the whole ladder and are never converted back:
+ * all three carry the same factor R, so (XR : YR : ZR) is already the
+ * projective result. Only the final full reduction remains.
+ */
+
+#include "secure_wipe.h"
+
+#include <string.h>
+
+#define LMASK ((1ULL << RADIX) - 1)
+
+typedef struct {
+    lfe_t x, y, z;
+} lpt_t;
+
+typedef struct {
+    lfe_t x, y;
+} laff_t;
+
+/* 2^520 mod p: lfe_mont_mul by it enters the Montgomery domain */
+static const uint256_t LANES_R2 = {{
+    0x0000000000000300ULL, 0xfffffbffffffff00ULL,
+    0xfffffffffffffeffULL, 0x000004fffffffdffULL
+}};
+
+static inline LANES_TARGET void lfe_splat(lfe_t *r, const uint64_t limbs[NLIMB]) {
+    for (int i = 0; i < NLIMB; i++) r->v[i] = v_set1(limbs[i]);
+}
+
+/* r = a - b mod 2^(NLIMB RADIX); returns all ones in the lanes that borrowed */
+static inline LANES_TARGET vec_t lfe_sub_raw(lfe_t *r, const lfe_t *a, const lfe_t *b) {
+    vec_t m = v_set1(LMASK), borrow = v_zero();
+
+    for (int i = 0; i < NLIMB; i++) {
+        vec_t t = v_sub(v_sub(a->v[i], b->v[i]), borrow);
+        borrow = v_srli(t, 63);
+        r->v[i] = v_and(t, m);
+    }
+    return v_sub(v_zero(), borrow);
+}
+
+static inline LANES_TARGET void lfe_add_raw(lfe_t *r, const lfe_t *a, const lfe_t *b) {
+    vec_t m = v_set1(LMASK), carry = v_zero();
+
+    for (int i = 0; i < NLIMB; i++) {
+        vec_t t = v_add(v_add(a->v[i], b->v[i]), carry);
+        carry = v_srli(t, RADIX);
+        r->v[i] = v_and(t, m);
+    }
+}
+
+/* r = mask ? a : b, lane by lane */
+static inline LANES_TARGET void lfe_blend(lfe_t *r, vec_t mask, const lfe_t *a, const lfe_t *b) {
+    for (int i = 0; i < NLIMB; i++) {
+        r->v[i] = v_or(v_and(mask, a->v[i]), v_andnot(mask, b->v[i]));
+    }
+}
+
+static inline LANES_TARGET void lfe_add(lfe_t *r, const lfe_t *a, const lfe_t *b) {
+    lfe_t s, d, p2;
+
+    lfe_splat(&p2, P2_LIMBS);
+    lfe_add_raw(&s, a, b);
+    lfe_blend(r, lfe_sub_raw(&d, &s, &p2), &s, &d);
+}
+
+static inline LANES_TARGET void lfe_sub(lfe_t *r, const lfe_t *a, const lfe_t *b) {
+    lfe_t d, p2;
+    vec_t borrow = lfe_sub_raw(&d, a, b);
+
+    for (int i = 0; i < NLIMB; i++) p2.v[i] = v_and(borrow, v_set1(P2_LIMBS[i]));
+    lfe_add_raw(r, &d, &p2);
+}
+
+/* [0, 2p) -> [0, p) */
+static inline LANES_TARGET void lfe_reduce(lfe_t *r, const lfe_t *a) {
+    lfe_t d, p;
+
+    lfe_splat(&p, P_LIMBS);
+    lfe_blend(r, lfe_sub_raw(&d, a, &p), a, &d);
+}
+
+static LANES_TARGET void lfe_from_u256(lfe_t *r, const uint256_t *const v[LANES]) {
+    uint64_t l[LANES];
+
+    for (int i = 0; i < NLIMB; i++) {
+        int bit = i * RADIX, w = bit / 64, sh = bit % 64;
+        for (int j = 0; j < LANES; j++) {
+            uint64_t x = w < 4 ? v[j]->limb[w] >> sh : 0;
+            if (sh + RADIX > 64 && w + 1 < 4) x |= v[j]->limb[w + 1] << (64 - sh);
+            l[j] = x & LMASK;
+        }
+        r->v[i] = v_load(l);
+    }
+}
+
+/* a must be fully reduced */
+static LANES_TARGET void lfe_to_u256(uint256_t *const v[LANES], const lfe_t *a) {
+    uint64_t l[LANES];
+
+    for (int j = 0; j < LANES; j++) memset(v[j], 0, sizeof(*v[j]));
+    for (int i = 0; i < NLIMB; i++) {
+        int bit = i * RADIX, w = bit / 64, sh = bit % 64;
+        v_store(l, a->v[i]);
+        for (int j = 0; j < LANES; j++) {
+            if (w < 4) v[j]->limb[w] |= l[j] << sh;
+            if (sh + RADIX > 64 && w + 1 < 4) v[j]->limb[w + 1] |= l[j] >> (64 - sh);
+        }
+    }
+}
+
+/* Complete addition, RCB Algorithm 1: ec_complete_add in ec.c, lane-wise. */
+static LANES_TARGET void lpt_add(lpt_t *R, const lpt_t *P, const lpt_t *Q, const lfe_t *a,
+                                 const lfe_t *b3) {
+    lfe_t t0, t1, t2, t3, t4, t5, X3, Y3, Z3;
+
+    lfe_mont_mul(&t0, &P->x, &Q->x);
+    lfe_mont_mul(&t1, &P->y, &Q->y);
+    lfe_mont_mul(&t2, &P->z, &Q->z);
+    lfe_add(&t3, &P->x, &P->y);
+    lfe_add(&t4, &Q->x, &Q->y);
+    lfe_mont_mul(&t3, &t3, &t4);
+    lfe_add(&t4, &t0, &t1);
+    lfe_sub(&t3, &t3, &t4);
+    lfe_add(&t4, &P->x, &P->z);
+    lfe_add(&t5, &Q->x, &Q->z);
+    lfe_mont_mul(&t4, &t4, &t5);
+    lfe_add(&t5, &t0, &t2);
+    lfe_sub(&t4, &t4, &t5);
+    lfe_add(&t5, &P->y, &P->z);
+    lfe_add(&X3, &Q->y, &Q->z);
+    lfe_mont_mul(&t5, &t5, &X3);
+    lfe_add(&X3, &t1, &t2);
+    lfe_sub(&t5, &t5, &X3);
+    lfe_mont_mul(&Z3, a, &t4);
+    lfe_mont_mul(&X3, b3, &t2);
+    lfe_add(&Z3, &X3, &Z3);
+    lfe_sub(&X3, &t1, &Z3);
+    lfe_add(&Z3, &t1, &Z3);
+    lfe_mont_mul(&Y3, &X3, &Z3);
+    lfe_add(&t1, &t0, &t0);
+    lfe_add(&t1, &t1, &t0);
+    lfe_mont_mul(&t2, a, &t2);
+    lfe_mont_mul(&t4, b3, &t4);
+    lfe_add(&t1, &t1, &t2);
+    lfe_sub(&t2, &t0, &t2);
+    lfe_mont_mul(&t2, a, &t2);
+    lfe_add(&t4, &t4, &t2);
+    lfe_mont_mul(&t0, &t1, &t4);
+    lfe_add(&Y3, &Y3, &t0);
+    lfe_mont_mul(&t0, &t5, &t4);
+    lfe_mont_mul(&X3, &t3, &X3);
+    lfe_sub(&X3, &X3, &t0);
+    lfe_mont_mul(&t0, &t3, &t1);
+    lfe_mont_mul(&Z3, &t5, &Z3);
+    lfe_add(&Z3, &Z3, &t0);
+
+    R->x = X3;
+    R->y = Y3;
+    R->z = Z3;
+}
+
+/* Mixed complete addition, RCB Algorithm 2: ec_complete_add_mixed in ec.c. */
+static LANES_TARGET void lpt_add_mixed(lpt_t *R, const lpt_t *P, const laff_t *Q, const lfe_t *a,
+                                       const lfe_t *b3) {
+    lfe_t t0, t1, t2, t3, t4, t5, X3, Y3, Z3;
+
+    lfe_mont_mul(&t0, &P->x, &Q->x);
+    lfe_mont_mul(&t1, &P->y, &Q->y);
+    lfe_add(&t3, &Q->x, &Q->y);
+    lfe_add(&t4, &P->x, &P->y);
+    lfe_mont_mul(&t3, &t3, &t4);
+    lfe_add(&t4, &t0, &t1);
+    lfe_sub(&t3, &t3, &t4);
+    lfe_mont_mul(&t4, &Q->x, &P->z);
+    lfe_add(&t4, &t4, &P->x);
+    lfe_mont_mul(&t5, &Q->y, &P->z);
+    lfe_add(&t5, &t5, &P->y);
+    lfe_mont_mul(&Z3, a, &t4);
+    lfe_mont_mul(&X3, b3, &P->z);
+    lfe_add(&Z3, &X3, &Z3);
+    lfe_sub(&X3, &t1, &Z3);
+    lfe_add(&Z3, &t1, &Z3);
+    lfe_mont_mul(&Y3, &X3, &Z3);
+    lfe_add(&t1, &t0, &t0);
+    lfe_add(&t1, &t1, &t0);
+    lfe_mont_mul(&t2, a, &P->z);
+    lfe_mont_mul(&t4, b3, &t4);
+    lfe_add(&t1, &t1, &t2);
+    lfe_sub(&t2, &t0, &t2);
+    lfe_mont_mul(&t2, a, &t2);
+    lfe_add(&t4, &t4, &t2);
+    lfe_mont_mul(&t0, &t1, &t4);
+    lfe_add(&Y3, &Y3, &t0);
+    lfe_mont_mul(&t0, &t5, &t4);
+    lfe_mont_mul(&X3, &t3, &X3);
+    lfe_sub(&X3, &X3, &t0);
+    lfe_mont_mul(&t0, &t3, &t1);
+    lfe_mont_mul(&Z3, &t5, &Z3);
+    lfe_add(&Z3, &Z3, &t0);
+
+    R->x = X3;
+    R->y = Y3;
+    R->z = Z3;
+}
+
+/* S = tab[idx] in each lane; every entry is read */
+static inline LANES_TARGET void laff_select(laff_t *S, const laff_t *tab, vec_t idx) {
+    memset(S, 0, sizeof(*S));
+    for (int e = 0; e < EC_LANES_TABLE; e++) {
+        vec_t mask = v_eq(idx, v_set1((uint64_t)e));
+        for (int i = 0; i < NLIMB; i++) {
+            S->x.v[i] = v_or(S->x.v[i], v_and(mask, tab[e].x.v[i]));
+            S->y.v[i] = v_or(S->y.v[i], v_and(mask, tab[e].y.v[i]));
+        }
+    }
+}
+
+LANES_TARGET void LANES_LADDER(const uint256_t *a, const uint256_t *b3, const ec_affine_t *T,
+                               const uint8_t *digits, ec_proj_t *Q) {
+    laff_t tab[EC_LANES_TABLE], S;
+    lpt_t acc, sum;
+    lfe_t A, B3, R2, zero, neg_y;
+    const uint256_t *in[LANES];
+    uint256_t *out[LANES];
+    uint64_t idx[LANES], neg[LANES], nonzero[LANES];
+
+    for (int j = 0; j < LANES; j++) in[j] = &LANES_R2;
+    lfe_from_u256(&R2, in);
+    for (int j = 0; j < LANES; j++) in[j] = a;
+    lfe_from_u256(&A, in);
+    lfe_mont_mul(&A, &A, &R2);
+    for (int j = 0; j < LANES; j++) in[j] = b3;
+    lfe_from_u256(&B3, in);
+    lfe_mont_mul(&B3, &B3, &R2);
+
+    for (int e = 0; e < EC_LANES_TABLE; e++) {
+        for (int j = 0; j < LANES; j++) in[j] = &T[j * EC_LANES_TABLE + e].x;
+        lfe_from_u256(&tab[e].x, in);
+        lfe_mont_mul(&tab[e].x, &tab[e].x, &R2);
+        for (int j = 0; j < LANES; j++) in[j] = &T[j * EC_LANES_TABLE + e].y;
+        lfe_from_u256(&tab[e].y, in);
+        lfe_mont_mul(&tab[e].y, &tab[e].y, &R2);
+    }
+
+    /* identity (0 : 1 : 0) */
+    memset(&acc, 0, sizeof(acc));
+    memset(&zero, 0, sizeof(zero));
+    acc.y.v[0] = v_set1(1);
+
+    for (int i = EC_LANES_DIGITS - 1; i >= 0; --i) {
+        lpt_add(&acc, &acc, &acc, &A, &B3);
+
+        /* as AddSignedDigit: a zero digit selects entry 0 and drops the sum */
+        for (int j = 0; j < LANES; j++) {
+            uint64_t d = digits[j * EC_LANES_DIGITS + i];
+            uint64_t abs_val = d & 0x7f, sign = d >> 7;
+            uint64_t nz = (abs_val | (0 - abs_val)) >> 63;
+            idx[j] = ((abs_val | (1 - nz)) - 1) >> 1;
+            neg[j] = 0 - (sign & nz);
+            nonzero[j] = 0 - nz;
+        }
+
+        laff_select(&S, tab, v_load(idx));
+        lfe_sub(&neg_y, &zero, &S.y);
+        lfe_blend(&S.y, v_load(neg), &neg_y, &S.y);
+        lpt_add_mixed(&sum, &acc, &S, &A, &B3);
+        lfe_blend(&acc.x, v_load(nonzero), &sum.x, &acc.x);
+        lfe_blend(&acc.y, v_load(nonzero), &sum.y, &acc.y);
+        lfe_blend(&acc.z, v_load(nonzero), &sum.z, &acc.z);
+    }
+
+    lfe_reduce(&acc.x, &acc.x);
+    lfe_reduce(&acc.y, &acc.y);
+    lfe_reduce(&acc.z, &acc.z);
+    for (int j = 0; j < LANES; j++) out[j] = &Q[j].x;
+    lfe_to_u256(out, &acc.x);
+    for (int j = 0; j < LANES; j++) out[j] = &Q[j].y;
+    lfe_to_u256(out, &acc.y);
+    for (int j = 0; j < LANES; j++) out[j] = &Q[j].z;
+    lfe_to_u256(out, &acc.z);
+
+    secure_wipe(tab, sizeof(tab));
+    secure_wipe(&S, sizeof(S));
+    secure_wipe(&sum, sizeof(sum));
+    secure_wipe(&acc, sizeof(acc));
+    secure_wipe(&neg_y, sizeof(neg_y));
+    secure_wipe(idx, sizeof(idx));
+    secure_wipe(neg, sizeof(neg));
+    secure_wipe(nonzero, sizeof(nonzero));
+}
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "ec.h"
+#include "sha256.h"
 
 /*
  * ECDSA sign using RFC 6979 deterministic k.
@@ -32,4 +33,173 @@ int ecdsa_verify(const ec_domain_params_t *curve,
                  const uint8_t             sig_r[32],
                  const uint8_t             sig_s[32]);
 
+/*
+ * Pre-hashed variants: digest is the 32-byte SHA-256 of the message,
+ * computed by the caller. ecdsa_sign_digest(curve, d, SHA-256(msg), ...)
+ * gives exactly the signature of ecdsa_sign(curve, d, msg, ...), and the
+ * same holds for verification.
+ */
+int ecdsa_sign_digest(const ec_domain_params_t *curve,
+                      const uint256_t          *private_key,
+                      const uint8_t             digest[32],
+                      uint8_t                   sig_r[32],
+                      uint8_t                   sig_s[32]);
+
+int ecdsa_verify_digest(const ec_domain_params_t *curve,
+                        const ec_point_t         *public_key,
+                        const uint8_t             digest[32],
+                        const uint8_t             sig_r[32],
+                        const uint8_t             sig_s[32]);
+
+/*
+ * Verification with a public key that has already been validated, such
+ * as a record of an ec_keystore_t (keystore.h): the curve membership
+ * check of ecdsa_verify is skipped, the results are otherwise the same.
+ * Keys straight from the wire must use ecdsa_verify.
+ */
+int ecdsa_verify_trusted(const ec_domain_params_t *curve,
+                         const ec_affine_t        *public_key,
+                         const uint8_t            *msg,
+                         size_t                    msg_len,
+                         const uint8_t             sig_r[32],
+                         const uint8_t             sig_s[32]);
+
+int ecdsa_verify_digest_trusted(const ec_domain_params_t *curve,
+                                const ec_affine_t        *public_key,
+                                const uint8_t             digest[32],
+                                const uint8_t             sig_r[32],
+                                const uint8_t             sig_s[32]);
+
+/*
+ * Streaming variants for messages that are not in one buffer (files,
+ * pipes, mappings): init, then update with the message in pieces of any
+ * size, then final, which signs or verifies as ecdsa_sign / ecdsa_verify
+ * would on the concatenated message. Memory use is one SHA256_ctx_t.
+ * ecdsa_sign_final wipes the context; both finals leave it unusable
+ * until the next init.
+ */
+void ecdsa_sign_init(SHA256_ctx_t *ctx);
+void ecdsa_sign_update(SHA256_ctx_t *ctx, const uint8_t *data, size_t len);
+int  ecdsa_sign_final(SHA256_ctx_t             *ctx,
+                      const ec_domain_params_t *curve,
+                      const uint256_t          *private_key,
+                      uint8_t                   sig_r[32],
+                      uint8_t                   sig_s[32]);
+
+void ecdsa_verify_init(SHA256_ctx_t *ctx);
+void ecdsa_verify_update(SHA256_ctx_t *ctx, const uint8_t *data, size_t len);
+int  ecdsa_verify_final(SHA256_ctx_t             *ctx,
+                        const ec_domain_params_t *curve,
+                        const ec_point_t         *public_key,
+                        const uint8_t             sig_r[32],
+                        const uint8_t             sig_s[32]);
+
+/*
+ * Sign msgs[i] (msg_lens[i] bytes, hashed with SHA-256) into sig_r[i],
+ * sig_s[i] for i < n, with the same key and the same deterministic
+ * output as n ecdsa_sign calls. Messages are processed in groups whose
+ * k·G share one field inversion and whose nonce inverses share one
+ * scalar inversion, which makes bulk signing much cheaper per message.
+ * Returns 0, or -1 on a bad key or if any signature failed (outputs are
+ * then unspecified).
+ */
+int ecdsa_sign_batch(const ec_domain_params_t *curve,
+                     const uint256_t          *private_key,
+                     const uint8_t *const     *msgs,
+                     const size_t             *msg_lens,
+                     size_t                    n,
+                     uint8_t                 (*sig_r)[32],
+                     uint8_t                 (*sig_s)[32]);
+
+/*
+ * Reusable signing key.
+ *
+ * Validates the private key and derives its per-key signing state once
+ * (Montgomery form, int2octets encoding, the key-only prefix of the
+ * RFC 6979 HMAC chain), so repeated signing with the same key skips that
+ * setup. Signatures are identical to ecdsa_sign. The object lives on the
+ * heap and is wiped by ecdsa_signing_key_free; signing calls do not
+ * allocate and may run concurrently on one key.
+ */
+typedef struct ecdsa_signing_key ecdsa_signing_key_t;
+
+/* Returns 0 and sets *key, or -1 if private_key is not in [1, n-1] or
+ * memory is unavailable. curve must outlive the key. */
+int ecdsa_signing_key_new(ecdsa_signing_key_t     **key,
+                          const ec_domain_params_t *curve,
+                          const uint256_t          *private_key);
+
+/* Same as ecdsa_sign with the key's curve and private key. */
+int ecdsa_signing_key_sign(const ecdsa_signing_key_t *key,
+                           const uint8_t             *msg,
+                           size_t                     msg_len,
+                           uint8_t                    sig_r[32],
+                           uint8_t                    sig_s[32]);
+
+/* Sign a precomputed 32-byte SHA-256 digest of the message. */
+int ecdsa_signing_key_sign_digest(const ecdsa_signing_key_t *key,
+                                  const uint8_t              digest[32],
+                                  uint8_t                    sig_r[32],
+                                  uint8_t                    sig_s[32]);
+
+/* ecdsa_sign_batch with the key's curve and private key. */
+int ecdsa_signing_key_sign_batch(const ecdsa_signing_key_t *key,
+                                 const uint8_t *const      *msgs,
+                                 const size_t              *msg_lens,
+                                 size_t                     n,
+                                 uint8_t                  (*sig_r)[32],
+                                 uint8_t                  (*sig_s)[32]);
+
+/* Wipe and free the key. NULL is ignored. */
+void ecdsa_signing_key_free(ecdsa_signing_key_t *key);
+
+/*
+ * Offline/online signing with randomized nonces.
+ *
+ * A nonce pool precomputes (r = x(kG) mod n, k^-1) pairs on background
+ * threads, with k drawn from the library RNG (rng.h): the nonce cannot
+ * be derived from the message as in RFC 6979 because the message is not
+ * known yet. ecdsa_sign_pooled then only hashes and does a few mod-n
+ * multiplications. Every nonce is used once and wiped when taken; an
+ * empty pool falls back to computing a nonce inline. The pool holds
+ * secrets (a leaked k^-1 reveals the key of the signature that used it)
+ * and is wiped on stop. Signatures verify with ecdsa_verify as usual.
+ *
+ * A pool serves only the process that started it. A child forked later
+ * gets a copy of the ring, whose nonces the parent still uses, and two
+ * signatures with one nonce reveal the private key. In the child
+ * ecdsa_sign_pooled therefore never reads the ring and always computes
+ * its nonce inline, and ecdsa_nonce_pool_stop just wipes and frees the
+ * copy. Start a new pool in the child to get pooled nonces there.
+ */
+typedef struct ecdsa_nonce_pool ecdsa_nonce_pool_t;
+
+/* Keep between low and high nonces ready for curve, produced by threads
+ * threads (0 <= low < high, threads >= 1; curve must outlive the pool).
+ * Allocates the pool. Returns 0, or -1 on bad parameters or if memory
+ * or threads are unavailable. */
+int ecdsa_nonce_pool_start(ecdsa_nonce_pool_t     **pool,
+                           const ec_domain_params_t *curve,
+                           size_t                    low,
+                           size_t                    high,
+                           unsigned                  threads);
+
+/* Sign msg (hashed with SHA-256) with a pooled nonce, or an inline one
+ * when the pool is empty or was started in another process. Thread safe,
+ * never blocks and does not allocate. Returns 0, or -1 on a bad key or
+ * if the inline fallback could not get random bytes. */
+int ecdsa_sign_pooled(ecdsa_nonce_pool_t *pool,
+                      const uint256_t    *private_key,
+                      const uint8_t      *msg,
+                      size_t              msg_len,
+                      uint8_t             sig_r[32],
+                      uint8_t             sig_s[32]);
+
+/* Nonces ready right now (a snapshot); 0 in a forked child. */
+size_t ecdsa_nonce_pool_available(const ecdsa_nonce_pool_t *pool);
+
+/* Join the producers, wipe unused nonces and free the pool. NULL is
+ * ignored. No ecdsa_sign_pooled call may be in progress or follow. */
+void ecdsa_nonce_pool_stop(ecdsa_nonce_pool_t *pool);
+
 #endif
@@ -0,0 +1,144 @@
+/*
+ * field.h
+ *
+ * Field multiplication used by the point formulas. For secp256r1 it runs
+ * specialized P-256 code (4x4-limb product plus the NIST fast reduction),
+ * with a MULX/ADCX/ADOX assembly product selected at load time on CPUs
+ * that have BMI2 and ADX. Every other curve goes through libmodplus.
+ *
+ * Operands and results are fully reduced uint256_t values, exactly what
+ * mod_mul takes and returns, so the two are interchangeable. Results may
+ * alias inputs.
+ *
+ * The fe52_* functions are a second, unsaturated P-256 representation
+ * for portable builds; see the block further down.
+ */
+
+#ifndef FIELD_H
+#define FIELD_H
+
+#include "ec.h"
+
+#include <modplus.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* r = a * b mod p256 and r = a^2 mod p256. Constant time. */
+void p256_mul(const uint256_t *a, const uint256_t *b, uint256_t *r);
+void p256_sqr(const uint256_t *a, uint256_t *r);
+
+/* Re-run backend selection; allow_asm = 0 pins the portable C code.
+ * The choice is made automatically at load time, so this only exists so
+ * tests can cover both paths. Not thread safe. */
+void p256_field_select(int allow_asm);
+
+/* Name of the active backend ("mulx-adx" or "portable"). */
+const char *p256_field_backend(void);
+
+/* r = t mod p256 for a 576-bit t (t[8] is the top word). Shared with the
+ * 5x52 code; fully reduced output. */
+void p256_reduce_wide(const uint64_t t[9], uint256_t *r);
+
+static inline int p256_is_prime(const uint256_t *p) {
+    return p->limb[0] == 0xffffffffffffffffULL && p->limb[1] == 0x00000000ffffffffULL &&
+           p->limb[2] == 0x0000000000000000ULL && p->limb[3] == 0xffffffff00000001ULL;
+}
+
+static inline void fe_mul(const ec_domain_params_t *curve, const uint256_t *a, const uint256_t *b,
+                          uint256_t *r) {
+    if (p256_is_prime(&curve->p)) {
+        p256_mul(a, b, r);
+    } else {
+        mod_mul(a, b, &curve->p, r);
+    }
+}
+
+static inline void fe_sqr(const ec_domain_params_t *curve, const uint256_t *a, uint256_t *r) {
+    if (p256_is_prime(&curve->p)) {
+        p256_sqr(a, r);
+    } else {
+        mod_mul(a, a, &curve->p, r);
+    }
+}
+
+/* ── 5x52 unsaturated representation ──
+ *
+ * value = n[0] + n[1] 2^52 + n[2] 2^104 + n[3] 2^156 + n[4] 2^208 (mod p)
+ *
+ * An element has magnitude m when every limb is below m * 2^52. Sums and
+ * differences are formed limb by limb without carries, so magnitudes grow
+ * until the next multiplication, which resolves the carries and reduces
+ * back to magnitude 1 (limbs below 2^52, not necessarily below p).
+ *
+ * fe52_mul and fe52_sqr are Montgomery products: they return
+ * a b 2^-260 mod p. Values that are multiplied together therefore live in
+ * the domain x 2^260, entered with fe52_to_mont. Projective coordinates
+ * need no conversion at all, since scaling X, Y and Z by the same 2^260
+ * leaves the point unchanged; curve coefficients and affine coordinates
+ * (whose Z = 1 is implied) do. The bounds below are exercised at their
+ * limits by the tests:
+ *
+ *   fe52_from_u256   any 256-bit input           -> 1
+ *   fe52_add         m_a + m_b
+ *   fe52_sub         m_a + 2 m_b,  m_b <= FE52_MAX_MAG
+ *   fe52_mul_small   k m_a
+ *   fe52_mul/sqr     inputs <= FE52_MAX_MAG      -> 1
+ *   fe52_to_mont     input  <= FE52_MAX_MAG      -> 1
+ *   fe52_to_u256     input  <= FE52_MAX_MAG      -> fully reduced
+ *
+ * Callers keep every operand of mul, sqr, to_mont and to_u256 at or below
+ * FE52_MAX_MAG. Needs a 128-bit integer type for the products. */
+
+#if defined(__SIZEOF_INT128__)
+#define FE52_AVAILABLE 1
+
+#define FE52_MAX_MAG 256
+
+typedef struct {
+    uint64_t n[5];
+} fe52_t;
+
+void fe52_from_u256(fe52_t *r, const uint256_t *a);
+void fe52_to_u256(uint256_t *r, const fe52_t *a);
+void fe52_mul(fe52_t *r, const fe52_t *a, const fe52_t *b);
+void fe52_sqr(fe52_t *r, const fe52_t *a);
+void fe52_to_mont(fe52_t *r, const fe52_t *a); /* r = a 2^260 mod p */
+
+static inline void fe52_add(fe52_t *r, const fe52_t *a, const fe52_t *b) {
+    for (int i = 0; i < 5; i++) r->n[i] = a->n[i] + b->n[i];
+}
+
+/* r = a - b, computed as a + mb * 32p - b with 32p spread so that each of
+ * its limbs lies in [2^52, 2^53): mb must be at least b's magnitude. */
+static inline void fe52_sub(fe52_t *r, const fe52_t *a, const fe52_t *b, uint64_t mb) {
+    r->n[0] = a->n[0] + mb * 0x1fffffffffffe0ULL - b->n[0];
+    r->n[1] = a->n[1] + mb * 0x11fffffffffffeULL - b->n[1];
+    r->n[2] = a->n[2] + mb * 0x1fffffffffffffULL - b->n[2];
+    r->n[3] = a->n[3] + mb * 0x1001fffffffffeULL - b->n[3];
+    r->n[4] = a->n[4] + mb * 0x1fffffffdfffffULL - b->n[4];
+}
+
+static inline void fe52_mul_small(fe52_t *r, const fe52_t *a, uint64_t k) {
+    for (int i = 0; i < 5; i++) r->n[i] = a->n[i] * k;
+}
+
+/* 1 iff every limb of a is below m * 2^52. */
+static inline int fe52_has_magnitude(const fe52_t *a, uint64_t m) {
+    for (int i = 0; i < 5; i++) {
+        if (a->n[i] >= (m << 52)) return 0;
+    }
+    return 1;
+}
+#endif
+
+#if defined(EC_FIELD_5X52) && !defined(FE52_AVAILABLE)
+#error "EC_FIELD_5X52 needs a compiler with 128-bit integers"
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FIELD_H */
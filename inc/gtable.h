@@ -0,0 +1,32 @@
+/*
+ * gtable.h
+ *
+ * Fixed-base table for the secp256r1 generator. It is not written by
+ * hand: tools/gen_gtable.c computes it at build time and the Makefile
+ * compiles the output (build/p256_gtable.c) into the library, so it is
+ * ready at load time and sits in shared read-only pages.
+ *
+ * Entry [i][j] is (j + 1) * 16^i * G as an ec_affine_t. A 256-bit
+ * scalar recoded into signed radix-16 digits in [-8, 8] has 64 digits
+ * plus a final carry, hence 65 windows.
+ */
+
+#ifndef GTABLE_H
+#define GTABLE_H
+
+#include "ec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define P256_GTABLE_WINDOWS 65
+#define P256_GTABLE_ENTRIES 8
+
+extern const ec_affine_t p256_gtable[P256_GTABLE_WINDOWS][P256_GTABLE_ENTRIES];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GTABLE_H */
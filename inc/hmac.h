@@ -1,6 +1,8 @@
 #ifndef HMAC_H
 #define HMAC_H
 
+#include "sha256.h"
+
 #include <stdint.h>
 #include <stddef.h>
 
@@ -10,6 +12,29 @@ extern "C" {
 
 void hmac_sha256(const uint8_t *key, size_t key_len, const uint8_t *data, size_t data_len, uint8_t output[32]);
 
+/* Incremental HMAC-SHA256. After hmac_sha256_init the context holds the
+ * keyed inner and outer hash states; a copy of it (hmac_sha256_clone)
+ * starts another MAC under the same key without hashing the key pads
+ * again. Wipe contexts that hold secret keys when done. */
+typedef struct {
+    SHA256_ctx_t inner;
+    SHA256_ctx_t outer;
+} hmac_sha256_ctx_t;
+
+void hmac_sha256_init(hmac_sha256_ctx_t *ctx, const uint8_t *key, size_t key_len);
+void hmac_sha256_update(hmac_sha256_ctx_t *ctx, const uint8_t *data, size_t data_len);
+void hmac_sha256_final(hmac_sha256_ctx_t *ctx, uint8_t output[32]);
+void hmac_sha256_clone(hmac_sha256_ctx_t *dst, const hmac_sha256_ctx_t *src);
+
+/* The same for the n contexts ctx[0 .. n) at once, on the multi-buffer
+ * SHA-256 of sha256.h. Every key is key_len bytes long; the message
+ * pieces may differ in length. */
+void hmac_sha256_init_lanes(hmac_sha256_ctx_t *ctx, const uint8_t *const *key, size_t key_len,
+                            size_t n);
+void hmac_sha256_update_lanes(hmac_sha256_ctx_t *ctx, const uint8_t *const *data,
+                              const size_t *data_len, size_t n);
+void hmac_sha256_final_lanes(hmac_sha256_ctx_t *ctx, uint8_t (*output)[32], size_t n);
+
 #ifdef __cplusplus
 }
 #endif
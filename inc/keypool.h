@@ -0,0 +1,66 @@
+/*
+ * keypool.h
+ *
+ * Opt-in pool of ephemeral keypairs generated ahead of time on background
+ * threads, so a handshake takes a ready keypair instead of paying for a
+ * scalar multiplication on the accept path.
+ *
+ * Keypairs sit in a bounded lock-free ring (multi-producer,
+ * multi-consumer). Producer threads fill it up to the high water mark,
+ * then sleep until a take drops it to the low water mark, and refill in
+ * batches (ec3dh_generate_keypairs). ec3dh_take_keypair never blocks:
+ * it pops a keypair, wipes the slot, and falls back to generating one
+ * inline when the ring is empty. Taking does not allocate or lock except
+ * to wake sleeping producers when the low water mark is crossed.
+ *
+ * Each keypair is handed out exactly once. Private keys in the ring live
+ * in process memory until taken; ec3dh_pool_stop wipes whatever is left.
+ *
+ * A pool serves only the process that started it. A child forked later
+ * (a pre-fork server) gets a copy of the ring, whose keys the parent
+ * still hands out, and no producers: in the child ec3dh_take_keypair
+ * never reads the ring and always generates inline, and
+ * ec3dh_pool_stop just wipes and frees the copy. Start a new pool in the
+ * child to get pooled keys there.
+ */
+
+#ifndef KEYPOOL_H
+#define KEYPOOL_H
+
+#include "ec.h"
+
+#include <stddef.h>
+#include <uint256.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ec3dh_pool ec3dh_pool_t;
+
+/* Start threads producer threads that keep between low and high keypairs
+ * for curve in a ring of at least high slots. Requires
+ * 0 <= low < high and threads >= 1; curve must outlive the pool. This
+ * call allocates the ring. Returns EC3DH_OK and sets *pool, or
+ * EC3DH_ERR_POOL (bad parameters, out of memory, thread start failed). */
+int ec3dh_pool_start(ec3dh_pool_t **pool, const ec_domain_params_t *curve,
+                     size_t low, size_t high, unsigned threads);
+
+/* Hand out one keypair, as ec3dh_generate_keypair would. Safe to call
+ * from any number of threads. Generates inline when the ring is empty or
+ * the pool was started in another process (see above). Returns the
+ * ec3dh_generate_keypair error codes; errors only occur inline. */
+int ec3dh_take_keypair(ec3dh_pool_t *pool, uint256_t *private_key, ec_point_t *pubkey);
+
+/* Number of keypairs ready right now (a snapshot); 0 in a forked child. */
+size_t ec3dh_pool_available(const ec3dh_pool_t *pool);
+
+/* Join the producers, wipe the remaining keys and free the pool. No take
+ * may be in progress or follow. NULL is ignored. */
+void ec3dh_pool_stop(ec3dh_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYPOOL_H */
@@ -0,0 +1,96 @@
+/*
+ * keystore.h
+ *
+ * On-disk store of validated public keys that is mapped into memory
+ * instead of decoded. ec_keystore_write checks every key once (range,
+ * curve membership, not infinity) and writes it as an ec_affine_t;
+ * ec_keystore_open maps the file read-only and hands back a pointer to
+ * those records, which go straight to ec3dh_compute_shared_secret_trusted_dk
+ * and ecdsa_verify_trusted: those skip the curve check that was done at
+ * write time. Opening costs one mmap and, unless skipped, one SHA-256
+ * pass; the pages are shared between every process that maps the same
+ * file.
+ *
+ * Layout (all fields in host byte order):
+ *
+ *   offset  size  field
+ *        0     8  magic "EC3DHKS1"
+ *        8     4  format version (EC_KEYSTORE_VERSION)
+ *       12     4  curve id (EC_KEYSTORE_CURVE_*)
+ *       16     4  record size, sizeof(ec_affine_t) = 64
+ *       20     4  byte-order mark 0x01020304
+ *       24     8  number of keys
+ *       32    32  SHA-256 of the records
+ *       64     -  records
+ *
+ * Records are raw ec_affine_t values, one cache line each and aligned as
+ * the type requires, since the header is 64 bytes and maps start on a
+ * page. A file only opens on hosts with the writer's byte order; anything
+ * else is rejected as EC_KEYSTORE_ERR_FORMAT. Version 1 stores, which
+ * held 104-byte ec_point_t records, are rejected the same way. The
+ * checksum guards against truncation and corruption, not against a
+ * malicious writer: the store is meant to be a trusted local artifact
+ * built from keys that arrived through codec.h.
+ */
+
+#ifndef KEYSTORE_H
+#define KEYSTORE_H
+
+#include "ec.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EC_KEYSTORE_VERSION    2
+#define EC_KEYSTORE_HEADER_LEN 64
+
+enum {
+    EC_KEYSTORE_CURVE_SECP256R1 = 1,
+};
+
+enum {
+    EC_KEYSTORE_OK            = 0,
+    EC_KEYSTORE_ERR_IO        = -1, /* open, read, write, map or rename failed */
+    EC_KEYSTORE_ERR_FORMAT    = -2, /* bad magic, version, layout or size */
+    EC_KEYSTORE_ERR_CHECKSUM  = -3, /* records do not match the stored digest */
+    EC_KEYSTORE_ERR_CURVE     = -4, /* curve not supported, or not the file's curve */
+    EC_KEYSTORE_ERR_KEY       = -5, /* writer: a key is infinity or not on the curve */
+};
+
+/* ec_keystore_open flags */
+#define EC_KEYSTORE_NO_CHECKSUM 0x1 /* skip the SHA-256 pass over the records */
+
+typedef struct {
+    const ec_affine_t *keys; /* count validated affine points, read-only */
+    size_t count;
+    void *map;              /* internal */
+    size_t map_len;         /* internal */
+} ec_keystore_t;
+
+/* Validate keys[0..n) and write them to path as affine points. The data
+ * goes to a new, uniquely named file in path's directory, is synced to
+ * disk, and is renamed over path, so processes that still map an older
+ * version keep a consistent view and a crash leaves either version
+ * whole. Returns EC_KEYSTORE_OK or a negative error; on error path is
+ * left untouched. */
+int ec_keystore_write(const char *path, const ec_domain_params_t *curve,
+                      const ec_point_t *keys, size_t n);
+
+/* Map the store at path. curve must be the curve the store was written
+ * for. On success ks->keys / ks->count describe the keys until
+ * ec_keystore_close; on error ks is zeroed. */
+int ec_keystore_open(const char *path, const ec_domain_params_t *curve,
+                     unsigned flags, ec_keystore_t *ks);
+
+/* Unmap the store. Safe on a zeroed or already closed ks. */
+void ec_keystore_close(ec_keystore_t *ks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KEYSTORE_H */
@@ -0,0 +1,54 @@
+/*
+ * rng.h
+ *
+ * Random bytes for key generation. By default every thread runs its own
+ * ChaCha20 generator, seeded from the OS (kp_getrandom_bytes) on first
+ * use and reseeded after EC_RNG_RESEED_BYTES of output, so generating a
+ * key costs no system call in the common case. After each refill of the
+ * internal buffer the ChaCha20 key is replaced by fresh keystream (fast
+ * key erasure): a later compromise of the state does not reveal bytes
+ * that were already handed out. A forked child reseeds before producing
+ * output, so parent and child never share a stream.
+ *
+ * ec_rng_set_callback replaces the generator with a caller-supplied
+ * source (an HSM, a test vector, another DRBG) for all threads.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EC_RNG_RESEED_BYTES (1u << 20)
+
+/* Fill buf with len random bytes. Returns 0, or -1 if the source failed
+ * (buf is wiped in that case). */
+typedef int (*ec_rng_fn)(void *ctx, uint8_t *buf, size_t len);
+
+/* Fill buf[0..len) from the active source. Returns 0 or -1; on failure
+ * buf is wiped. */
+int ec_rng_bytes(void *buf, size_t len);
+
+/* Use fn(ctx, ...) instead of the built-in generator; NULL restores it.
+ * Not synchronized with concurrent ec_rng_bytes calls: set it before
+ * other threads use the library. */
+void ec_rng_set_callback(ec_rng_fn fn, void *ctx);
+
+/* Make the calling thread's generator reseed from the OS before its next
+ * output. */
+void ec_rng_reseed(void);
+
+/* The RFC 8439 block function, exposed for the known-answer tests. */
+void chacha20_block(const uint32_t key[8], uint32_t counter, const uint32_t nonce[3],
+                    uint8_t out[64]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNG_H */
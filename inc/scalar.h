@@ -0,0 +1,56 @@
+/*
+ * scalar.h
+ *
+ * Arithmetic modulo the group order n, for ECDSA. Values are uint256_t
+ * and multiplication is Montgomery (R = 2^256): convert with
+ * scalar_to_mont, compute, convert back with scalar_from_mont. Addition
+ * and subtraction work the same in either domain. Everything is constant
+ * time in the operands; n is public. Results may alias inputs.
+ *
+ * The modulus must be odd. Built-in curves carry a ready scalar_mont_t
+ * in their constant block (curve_consts.h).
+ */
+
+#ifndef SCALAR_H
+#define SCALAR_H
+
+#include <modplus.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint256_t n;
+    uint256_t rr; /* 2^512 mod n */
+    uint64_t n0;  /* -n^-1 mod 2^64 */
+} scalar_mont_t;
+
+void scalar_mont_init(scalar_mont_t *m, const uint256_t *n);
+
+/* r = a R mod n for any 256-bit a (a >= n is reduced). */
+void scalar_to_mont(const scalar_mont_t *m, const uint256_t *a, uint256_t *r);
+/* r = a R^-1 mod n, fully reduced. */
+void scalar_from_mont(const scalar_mont_t *m, const uint256_t *a, uint256_t *r);
+/* r = a mod n for any 256-bit a. */
+void scalar_reduce(const scalar_mont_t *m, const uint256_t *a, uint256_t *r);
+
+/* Montgomery domain: r = a b R^-1 mod n. a, b < n. */
+void scalar_mul(const scalar_mont_t *m, const uint256_t *a, const uint256_t *b, uint256_t *r);
+/* Montgomery domain: r = a^-1 (Fermat, a^(n-2)); r = 0 for a = 0. n prime. */
+void scalar_inv(const scalar_mont_t *m, const uint256_t *a, uint256_t *r);
+/* Montgomery domain: r[i] = a[i]^-1 for i < n with one scalar_inv
+ * (Montgomery's trick). All a[i] must be non-zero; r must not overlap a. */
+void scalar_inv_batch(const scalar_mont_t *m, const uint256_t *a, uint256_t *r, size_t n);
+
+/* r = a + b, r = a - b mod n. a, b < n. */
+void scalar_add(const scalar_mont_t *m, const uint256_t *a, const uint256_t *b, uint256_t *r);
+void scalar_sub(const scalar_mont_t *m, const uint256_t *a, const uint256_t *b, uint256_t *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCALAR_H */
@@ -20,6 +20,43 @@ void sha256_update(SHA256_ctx_t *ctx, const uint8_t data[], size_t len);
 void sha256_final(SHA256_ctx_t *ctx, uint8_t hash[32]);
 void sha256(const uint8_t *data, size_t len, uint8_t hash[32]);
 
+/* Snapshot and resume. Hash a common prefix once, then sha256_clone the
+ * context for every message that continues it; the source is left
+ * untouched and either copy may be updated or finalized. */
+void sha256_clone(SHA256_ctx_t *dst, const SHA256_ctx_t *src);
+
+/* Portable midstate: the eight state words and the number of bytes hashed
+ * so far (big-endian), then the unprocessed tail of the last partial
+ * block, zero-padded to 64 bytes. Byte-identical across platforms, so a
+ * prefix can be hashed once and the state shipped or stored. A midstate
+ * of a secret prefix is as secret as the prefix. */
+#define SHA256_STATE_LEN 104
+
+void sha256_export_state(const SHA256_ctx_t *ctx, uint8_t out[SHA256_STATE_LEN]);
+
+/* Returns 0, or -1 (ctx untouched) if in is not a valid midstate: the
+ * length is out of range or the padding after the tail is not zero. */
+int sha256_import_state(SHA256_ctx_t *ctx, const uint8_t in[SHA256_STATE_LEN]);
+
+/* Multi-buffer hashing. Up to SHA256_LANES independent contexts advance
+ * together: their blocks are compressed by one lane-interleaved transform
+ * (word i of every lane side by side) whose loops over the lanes the
+ * compiler turns into 4- or 8-wide vector code, AVX2 when the CPU has it.
+ * ctx[l] consumes data[l][0 .. len[l]); lengths may differ, a lane that
+ * runs out of blocks simply sits out the remaining transforms. The result
+ * is the same as sha256_update / sha256_final on each context. */
+#define SHA256_LANES 8
+
+void sha256_update_lanes(SHA256_ctx_t *const *ctx, const uint8_t *const *data,
+                         const size_t *len, size_t n);
+void sha256_final_lanes(SHA256_ctx_t *const *ctx, uint8_t (*hash)[32], size_t n);
+
+/* Transform backend: level 0 is plain C, 1 allows AVX2. The best one is
+ * chosen when the library is loaded, so this is for tests. Not thread
+ * safe. */
+void sha256_lanes_select(int level);
+const char *sha256_lanes_backend(void);
+
 #ifdef __cplusplus
 }
 #endif
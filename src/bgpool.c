@@ -0,0 +1,388 @@
+/*
+ * bgpool.c
+ *
+ * Background item pool. The ring is the bounded MPMC queue with
+ * per-slot sequence numbers (D. Vyukov): a slot whose sequence equals
+ * the enqueue position is free, one whose sequence is position + 1 is
+ * full, and claiming a position is a single compare-and-swap. The mutex
+ * and condition variable only park idle producers. See bgpool.h.
+ */
+
+#include "bgpool.h"
+#include "secure_wipe.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#include <windows.h>
+typedef HANDLE             pool_thread_t;
+typedef SRWLOCK            pool_mutex_t;
+typedef CONDITION_VARIABLE pool_cond_t;
+#else
+#include <pthread.h>
+typedef pthread_t          pool_thread_t;
+typedef pthread_mutex_t    pool_mutex_t;
+typedef pthread_cond_t     pool_cond_t;
+#endif
+
+/* a slot is its sequence number followed by the item, padded to a
+ * cache line so neighbouring slots are not falsely shared */
+#define SLOT_ALIGN 64
+#define SLOT_ITEM_OFFSET sizeof(atomic_size_t)
+
+/* after a failed produce, wait this long before retrying, doubling up
+ * to the maximum while the source stays down */
+#define RETRY_MIN_MS 10
+#define RETRY_MAX_MS 1000
+
+struct bgpool {
+    unsigned char *slots;
+    size_t stride;
+    size_t item_size;
+    size_t mask;
+    size_t low, high;
+    bgpool_produce_fn produce;
+    void *ctx;
+
+    atomic_size_t enq;
+    atomic_size_t deq;
+
+    atomic_int stop;
+    atomic_uint idle;        /* producers parked on cond */
+    pool_mutex_t lock;
+    pool_cond_t cond;
+
+    unsigned nthreads;
+    pool_thread_t *threads;
+    unsigned fork_gen;       /* fork_gen when started */
+};
+
+/* ---------- thin threading layer ---------- */
+
+#if defined(_WIN32)
+static void pool_sync_init(bgpool_t *p) {
+    InitializeSRWLock(&p->lock);
+    InitializeConditionVariable(&p->cond);
+}
+static void pool_sync_destroy(bgpool_t *p) { (void)p; }
+static void pool_lock(bgpool_t *p) { AcquireSRWLockExclusive(&p->lock); }
+static void pool_unlock(bgpool_t *p) { ReleaseSRWLockExclusive(&p->lock); }
+static void pool_wait(bgpool_t *p) { SleepConditionVariableSRW(&p->cond, &p->lock, INFINITE, 0); }
+static void pool_wait_ms(bgpool_t *p, unsigned ms) {
+    ULONGLONG end = GetTickCount64() + ms, now;
+    while (!atomic_load(&p->stop) && (now = GetTickCount64()) < end) {
+        SleepConditionVariableSRW(&p->cond, &p->lock, (DWORD)(end - now), 0);
+    }
+}
+static void pool_wake_all(bgpool_t *p) { WakeAllConditionVariable(&p->cond); }
+
+static DWORD WINAPI pool_producer_main(LPVOID arg);
+static int pool_thread_start(pool_thread_t *t, bgpool_t *p) {
+    *t = CreateThread(NULL, 0, pool_producer_main, p, 0, NULL);
+    return *t ? 0 : -1;
+}
+static void pool_thread_join(pool_thread_t t) {
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+}
+#else
+static void pool_sync_init(bgpool_t *p) {
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+}
+static void pool_sync_destroy(bgpool_t *p) {
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+}
+static void pool_lock(bgpool_t *p) { pthread_mutex_lock(&p->lock); }
+static void pool_unlock(bgpool_t *p) { pthread_mutex_unlock(&p->lock); }
+static void pool_wait(bgpool_t *p) { pthread_cond_wait(&p->cond, &p->lock); }
+static void pool_wait_ms(bgpool_t *p, unsigned ms) {
+    struct timespec end;
+    clock_gettime(CLOCK_REALTIME, &end);
+    end.tv_sec += ms / 1000;
+    end.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (end.tv_nsec >= 1000000000L) {
+        end.tv_sec++;
+        end.tv_nsec -= 1000000000L;
+    }
+    while (!atomic_load(&p->stop) &&
+           pthread_cond_timedwait(&p->cond, &p->lock, &end) != ETIMEDOUT) {
+    }
+}
+static void pool_wake_all(bgpool_t *p) { pthread_cond_broadcast(&p->cond); }
+
+static void *pool_producer_main(void *arg);
+static int pool_thread_start(pool_thread_t *t, bgpool_t *p) {
+    return pthread_create(t, NULL, pool_producer_main, p) == 0 ? 0 : -1;
+}
+static void pool_thread_join(pool_thread_t t) { pthread_join(t, NULL); }
+#endif
+
+/* ---------- fork ---------- */
+
+/* Bumped in every forked child. There the ring is a copy of the parent's:
+ * the same items, which the parent hands out too, no producer threads,
+ * and a lock that one of them may have held. A pool started under an
+ * older value is foreign and is never read or locked. */
+static atomic_uint fork_gen;
+
+#if !defined(_WIN32)
+static pthread_once_t fork_once = PTHREAD_ONCE_INIT;
+
+/* runs in the child, whose only thread is the one that forked */
+static void pool_atfork_child(void) {
+    atomic_fetch_add(&fork_gen, 1);
+}
+
+static void pool_atfork_register(void) {
+    pthread_atfork(NULL, NULL, pool_atfork_child);
+}
+#endif
+
+static int pool_foreign(const bgpool_t *p) {
+    return atomic_load_explicit(&fork_gen, memory_order_relaxed) != p->fork_gen;
+}
+
+/* ---------- ring ---------- */
+
+static atomic_size_t *slot_seq(const bgpool_t *p, size_t pos) {
+    return (atomic_size_t *)(p->slots + (pos & p->mask) * p->stride);
+}
+
+static unsigned char *slot_item(const bgpool_t *p, size_t pos) {
+    return p->slots + (pos & p->mask) * p->stride + SLOT_ITEM_OFFSET;
+}
+
+static size_t pool_level(const bgpool_t *p) {
+    size_t d = atomic_load((atomic_size_t *)&p->deq);
+    size_t e = atomic_load((atomic_size_t *)&p->enq);
+    return e - d;
+}
+
+/* Returns 0, or -1 if the ring is full. */
+static int pool_push(bgpool_t *p, const void *item) {
+    size_t pos = atomic_load_explicit(&p->enq, memory_order_relaxed);
+
+    for (;;) {
+        size_t seq = atomic_load_explicit(slot_seq(p, pos), memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak(&p->enq, &pos, pos + 1)) break;
+        } else if (dif < 0) {
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&p->enq, memory_order_relaxed);
+        }
+    }
+
+    memcpy(slot_item(p, pos), item, p->item_size);
+    atomic_store_explicit(slot_seq(p, pos), pos + 1, memory_order_release);
+    return 0;
+}
+
+/* Returns 0, or -1 if the ring is empty. The slot is wiped. */
+static int pool_pop(bgpool_t *p, void *item) {
+    size_t pos = atomic_load_explicit(&p->deq, memory_order_relaxed);
+
+    for (;;) {
+        size_t seq = atomic_load_explicit(slot_seq(p, pos), memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak(&p->deq, &pos, pos + 1)) break;
+        } else if (dif < 0) {
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&p->deq, memory_order_relaxed);
+        }
+    }
+
+    memcpy(item, slot_item(p, pos), p->item_size);
+    secure_wipe(slot_item(p, pos), p->item_size);
+    atomic_store_explicit(slot_seq(p, pos), pos + p->mask + 1, memory_order_release);
+    return 0;
+}
+
+/* ---------- producers ---------- */
+
+#if defined(_WIN32)
+static DWORD WINAPI pool_producer_main(LPVOID arg)
+#else
+static void *pool_producer_main(void *arg)
+#endif
+{
+    bgpool_t *p = (bgpool_t *)arg;
+    unsigned char items[BGPOOL_BATCH * BGPOOL_MAX_ITEM];
+    unsigned retry_ms = RETRY_MIN_MS;
+
+    while (!atomic_load(&p->stop)) {
+        size_t level = pool_level(p);
+        size_t n = level < p->high ? p->high - level : 0;
+
+        if (n > BGPOOL_BATCH) n = BGPOOL_BATCH;
+        if (n && p->produce(p->ctx, items, n) != 0) {
+            /* the source is down (RNG, callback, device): back off rather
+             * than retry at once, waking early only to stop */
+            pool_lock(p);
+            pool_wait_ms(p, retry_ms);
+            pool_unlock(p);
+            retry_ms = retry_ms < RETRY_MAX_MS / 2 ? 2 * retry_ms : RETRY_MAX_MS;
+            continue;
+        }
+        if (n) {
+            retry_ms = RETRY_MIN_MS;
+            /* a full ring (another producer got there first) drops the rest */
+            for (size_t i = 0; i < n; i++) {
+                if (pool_push(p, items + i * p->item_size) < 0) break;
+            }
+            secure_wipe(items, n * p->item_size);
+            if (pool_level(p) < p->high) continue;
+        }
+
+        /* full: park until a take crosses low. idle is raised before the
+         * level is re-read, and takers lower the level before reading
+         * idle, so no wakeup is lost. */
+        pool_lock(p);
+        atomic_fetch_add(&p->idle, 1);
+        while (!atomic_load(&p->stop) && pool_level(p) > p->low) pool_wait(p);
+        atomic_fetch_sub(&p->idle, 1);
+        pool_unlock(p);
+    }
+
+#if defined(_WIN32)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/* ---------- slot memory ---------- */
+
+/* Zeroed ring of n slots of stride bytes on a SLOT_ALIGN boundary, so
+ * that every slot really starts a cache line. stride is a multiple of
+ * SLOT_ALIGN, as aligned_alloc wants. NULL on failure or overflow. */
+static unsigned char *slots_alloc(size_t n, size_t stride) {
+    unsigned char *s;
+
+    if (n > (size_t)-1 / stride) return NULL;
+#if defined(_WIN32)
+    s = (unsigned char *)_aligned_malloc(n * stride, SLOT_ALIGN);
+#else
+    s = (unsigned char *)aligned_alloc(SLOT_ALIGN, n * stride);
+#endif
+    if (s) memset(s, 0, n * stride);
+    return s;
+}
+
+static void slots_free(unsigned char *s) {
+#if defined(_WIN32)
+    _aligned_free(s);
+#else
+    free(s);
+#endif
+}
+
+/* ---------- API ---------- */
+
+int bgpool_start(bgpool_t **pool, size_t item_size, size_t low, size_t high,
+                 unsigned threads, bgpool_produce_fn produce, void *ctx) {
+    bgpool_t *p;
+    size_t cap = 1;
+
+    if (!pool) return -1;
+    *pool = NULL;
+    if (!produce || item_size == 0 || item_size > BGPOOL_MAX_ITEM || low >= high ||
+        threads == 0 || high > ((size_t)-1 >> 2)) {
+        return -1;
+    }
+    while (cap < high) cap <<= 1;
+
+#if !defined(_WIN32)
+    if (pthread_once(&fork_once, pool_atfork_register) != 0) return -1;
+#endif
+    p = (bgpool_t *)calloc(1, sizeof(*p));
+    if (!p) return -1;
+    p->stride = (SLOT_ITEM_OFFSET + item_size + SLOT_ALIGN - 1) / SLOT_ALIGN * SLOT_ALIGN;
+    p->slots = slots_alloc(cap, p->stride);
+    p->threads = (pool_thread_t *)calloc(threads, sizeof(*p->threads));
+    if (!p->slots || !p->threads) {
+        slots_free(p->slots);
+        free(p->threads);
+        free(p);
+        return -1;
+    }
+
+    p->item_size = item_size;
+    p->mask = cap - 1;
+    p->low = low;
+    p->high = high;
+    p->produce = produce;
+    p->ctx = ctx;
+    p->fork_gen = atomic_load(&fork_gen);
+    for (size_t i = 0; i < cap; i++) atomic_init(slot_seq(p, i), i);
+    atomic_init(&p->enq, 0);
+    atomic_init(&p->deq, 0);
+    atomic_init(&p->stop, 0);
+    atomic_init(&p->idle, 0);
+    pool_sync_init(p);
+
+    for (unsigned i = 0; i < threads; i++) {
+        if (pool_thread_start(&p->threads[i], p) != 0) {
+            p->nthreads = i;
+            bgpool_stop(p);
+            return -1;
+        }
+    }
+    p->nthreads = threads;
+
+    *pool = p;
+    return 0;
+}
+
+int bgpool_take(bgpool_t *pool, void *item) {
+    int ret;
+
+    if (pool_foreign(pool)) return -1;
+    ret = pool_pop(pool, item);
+
+    if (atomic_load(&pool->idle) && pool_level(pool) <= pool->low) {
+        pool_lock(pool);
+        pool_wake_all(pool);
+        pool_unlock(pool);
+    }
+    return ret;
+}
+
+size_t bgpool_available(const bgpool_t *pool) {
+    return pool_foreign(pool) ? 0 : pool_level(pool);
+}
+
+void bgpool_stop(bgpool_t *pool) {
+    int foreign;
+
+    if (!pool) return;
+
+    /* a forked child has no producers to join and must not touch the lock */
+    foreign = pool_foreign(pool);
+    if (!foreign) {
+        pool_lock(pool);
+        atomic_store(&pool->stop, 1);
+        pool_wake_all(pool);
+        pool_unlock(pool);
+        for (unsigned i = 0; i < pool->nthreads; i++) pool_thread_join(pool->threads[i]);
+    }
+
+    secure_wipe(pool->slots, (pool->mask + 1) * pool->stride);
+    if (!foreign) pool_sync_destroy(pool);
+    free(pool->threads);
+    slots_free(pool->slots);
+    free(pool);
+}
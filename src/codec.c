@@ -5,6 +5,8 @@
  */
 
 #include "codec.h"
+#include "field.h"
+#include "curve_consts.h"
 #include "secure_wipe.h"
 
 #include <modplus.h>
@@ -30,13 +32,25 @@ static void u256_from_be_bytes(const uint8_t in[32], uint256_t *v) {
 /* Right-hand side of the curve equation: x^3 + a*x + b (mod p). */
 static void curve_rhs(const ec_domain_params_t *curve, const uint256_t *x, uint256_t *rhs) {
     uint256_t x2, x3, ax;
-    mod_mul(x, x, &curve->p, &x2);
-    mod_mul(x, &x2, &curve->p, &x3);
-    mod_mul(&curve->a, x, &curve->p, &ax);
+    fe_sqr(curve, x, &x2);
+    fe_mul(curve, x, &x2, &x3);
+    fe_mul(curve, &curve->a, x, &ax);
     mod_add(&x3, &ax, &curve->p, rhs);
     mod_add(rhs, &curve->b, &curve->p, rhs);
 }
 
+/* SEC1-encode affine coordinates; out must hold the chosen form. */
+static void encode_affine(const uint256_t *x, const uint256_t *y, int compressed, uint8_t *out) {
+    if (compressed) {
+        out[0] = (uint8_t)(0x02 | (y->limb[0] & 1));
+        u256_to_be_bytes(x, out + 1);
+    } else {
+        out[0] = 0x04;
+        u256_to_be_bytes(x, out + 1);
+        u256_to_be_bytes(y, out + 33);
+    }
+}
+
 int ec_point_to_bytes(const ec_domain_params_t *curve, const ec_point_t *P,
                       int compressed, uint8_t *out, size_t out_len) {
     ec_point_t A;
@@ -51,18 +65,65 @@ int ec_point_to_bytes(const ec_domain_params_t *curve, const ec_point_t *P,
         return -1;
     }
 
-    if (compressed) {
-        out[0] = (uint8_t)(0x02 | (A.y.limb[0] & 1));
-        u256_to_be_bytes(&A.x, out + 1);
-    } else {
-        out[0] = 0x04;
-        u256_to_be_bytes(&A.x, out + 1);
-        u256_to_be_bytes(&A.y, out + 33);
-    }
+    encode_affine(&A.x, &A.y, compressed, out);
 
     return (int)need;
 }
 
+int ec_points_to_bytes(const ec_domain_params_t *curve, const ec_point_t *P, size_t n,
+                       int compressed, uint8_t *out, size_t out_len) {
+    size_t need = compressed ? EC_POINT_COMPRESSED_LEN : EC_POINT_UNCOMPRESSED_LEN;
+    const uint256_t *prime = &curve->p;
+    uint256_t acc, inv, z_inv, z2, z3, x, y;
+
+    if (n == 0) {
+        return 0;
+    }
+    if (P == NULL || out == NULL || out_len / need < n) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (P[i].infinity || uint256_is_zero(&P[i].z)) {
+            return -1;
+        }
+    }
+
+    /* Montgomery's trick: invert z_0 * ... * z_{n-1} once and peel the
+     * individual inverses off on the way back. The running products are
+     * parked in the output slots (each slot is at least 33 bytes), so no
+     * scratch memory is needed; slot i is overwritten with its encoding
+     * only after the product stored there has been consumed. */
+    acc = P[0].z;
+    memcpy(out, &acc, sizeof(acc));
+    for (size_t i = 1; i < n; i++) {
+        fe_mul(curve, &acc, &P[i].z, &acc);
+        memcpy(out + i * need, &acc, sizeof(acc));
+    }
+
+    mod_inv(&acc, prime, &inv);
+
+    for (size_t i = n; i-- > 0;) {
+        if (i > 0) {
+            memcpy(&acc, out + (i - 1) * need, sizeof(acc));
+            fe_mul(curve, &inv, &acc, &z_inv);     /* 1 / z_i */
+            fe_mul(curve, &inv, &P[i].z, &inv);    /* 1 / (z_0 * ... * z_{i-1}) */
+        } else {
+            z_inv = inv;
+        }
+
+        /* Jacobian -> affine: (X / Z^2, Y / Z^3) */
+        fe_sqr(curve, &z_inv, &z2);
+        fe_mul(curve, &z2, &z_inv, &z3);
+        fe_mul(curve, &P[i].x, &z2, &x);
+        fe_mul(curve, &P[i].y, &z3, &y);
+
+        encode_affine(&x, &y, compressed, out + i * need);
+    }
+
+    return 0;
+}
+
 int ec_point_from_bytes(const ec_domain_params_t *curve,
                         const uint8_t *in, size_t in_len, ec_point_t *P) {
     uint256_t x, y;
@@ -81,6 +142,7 @@ int ec_point_from_bytes(const ec_domain_params_t *curve,
     } else if (in_len == EC_POINT_COMPRESSED_LEN && (in[0] == 0x02 || in[0] == 0x03)) {
         uint256_t rhs, exp, y2;
         uint256_t one = {{1, 0, 0, 0}};
+        const ec_curve_consts_t *consts;
 
         /* sqrt via y = rhs^((p+1)/4) requires p == 3 (mod 4) */
         if ((curve->p.limb[0] & 3) != 3) {
@@ -94,15 +156,20 @@ int ec_point_from_bytes(const ec_domain_params_t *curve,
 
         curve_rhs(curve, &x, &rhs);
 
-        /* exp = (p + 1) / 4; p + 1 cannot overflow since p < 2^256 - 1 */
-        uint256_add(&curve->p, &one, &exp);
-        uint256_rshift1(&exp);
-        uint256_rshift1(&exp);
+        /* exp = (p + 1) / 4, precomputed for built-in curves; p + 1
+         * cannot overflow since p < 2^256 - 1 */
+        if ((consts = ec_curve_consts_lookup(curve)) != NULL) {
+            exp = consts->sqrt_exp;
+        } else {
+            uint256_add(&curve->p, &one, &exp);
+            uint256_rshift1(&exp);
+            uint256_rshift1(&exp);
+        }
 
         mod_exp(&rhs, &exp, &curve->p, &y);
 
         /* if rhs is a non-residue, the "square root" fails this check */
-        mod_mul(&y, &y, &curve->p, &y2);
+        fe_sqr(curve, &y, &y2);
         if (uint256_cmp(&y2, &rhs) != 0) {
             return -1;
         }
@@ -130,6 +197,31 @@ int ec_point_from_bytes(const ec_domain_params_t *curve,
     return 0;
 }
 
+int ec_point_x_from_bytes(const ec_domain_params_t *curve,
+                          const uint8_t *in, size_t in_len, uint256_t *x) {
+    ec_point_t P;
+
+    if (in == NULL || x == NULL) {
+        return -1;
+    }
+
+    if (in_len == EC_POINT_COMPRESSED_LEN && (in[0] == 0x02 || in[0] == 0x03)) {
+        u256_from_be_bytes(in + 1, x);
+        if (!ec_x_on_curve(curve, x)) {
+            memset(x, 0, sizeof(*x));
+            return -1;
+        }
+        return 0;
+    }
+
+    if (ec_point_from_bytes(curve, in, in_len, &P) < 0) {
+        return -1;
+    }
+    *x = P.x;
+
+    return 0;
+}
+
 void ec_scalar_to_bytes(const uint256_t *k, uint8_t out[32]) {
     u256_to_be_bytes(k, out);
 }
@@ -0,0 +1,55 @@
+/*
+ * cpu_features.c
+ *
+ * CPUID-based feature detection. See cpu_features.h.
+ */
+
+#include "cpu_features.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <stddef.h>
+
+/* XCR0 bits the OS sets when it saves the vector state on context
+ * switch: 1 and 2 for XMM and YMM, 5 to 7 for the AVX-512 opmask and ZMM
+ * registers. Returns 0 without OSXSAVE or AVX. */
+static unsigned os_xcr0(void) {
+    unsigned eax, ebx, ecx, edx, lo, hi;
+
+    __cpuid(1, eax, ebx, ecx, edx);
+    if (!(ecx & (1u << 27)) || !(ecx & (1u << 28))) { /* OSXSAVE, AVX */
+        return 0;
+    }
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    (void)hi;
+    return lo;
+}
+
+unsigned ec_cpu_features(void) {
+    unsigned eax, ebx, ecx, edx, xcr0;
+    unsigned features = 0;
+
+    if (__get_cpuid_max(0, NULL) < 7) {
+        return 0;
+    }
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    if (ebx & (1u << 8))  features |= EC_CPU_BMI2;
+    if (ebx & (1u << 19)) features |= EC_CPU_ADX;
+    xcr0 = os_xcr0();
+    if ((ebx & (1u << 5)) && (xcr0 & 0x06) == 0x06) features |= EC_CPU_AVX2;
+    /* AVX512F (bit 16) and AVX512_IFMA (bit 21) */
+    if ((ebx & (1u << 16)) && (ebx & (1u << 21)) && (xcr0 & 0xe6) == 0xe6) {
+        features |= EC_CPU_IFMA;
+    }
+
+    return features;
+}
+
+#else
+
+unsigned ec_cpu_features(void) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * ct_select.c
+ *
+ * Constant-time table scans. Each entry is ANDed with an all-ones or
+ * all-zeros mask derived from (i == idx) without branching and ORed into
+ * the accumulator, so a lookup costs n * words / lanes vector loads no
+ * matter which entry is wanted. See ct_select.h.
+ */
+
+#include "ct_select.h"
+#include "cpu_features.h"
+
+#include <string.h>
+
+typedef void (*select_fn)(uint64_t *out, const uint64_t *table, size_t n, size_t words,
+                          uint64_t idx);
+
+/* all ones iff a == b */
+static inline uint64_t ct_eq_mask(uint64_t a, uint64_t b) {
+    uint64_t x = a ^ b;
+    return ((x | (0 - x)) >> 63) - 1;
+}
+
+static void select_scalar(uint64_t *out, const uint64_t *table, size_t n, size_t words,
+                          uint64_t idx) {
+    uint64_t acc[EC_TABLE_MAX_WORDS] = {0};
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t mask = ct_eq_mask(i, idx);
+        const uint64_t *e = table + i * words;
+        for (size_t w = 0; w < words; w++) acc[w] |= e[w] & mask;
+    }
+    memcpy(out, acc, words * sizeof(uint64_t));
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HAVE_X86_SIMD 1
+#include <immintrin.h>
+
+/* SSE2 is part of the x86-64 baseline, so no target attribute is needed. */
+static void select_sse2(uint64_t *out, const uint64_t *table, size_t n, size_t words,
+                        uint64_t idx) {
+    __m128i acc[EC_TABLE_MAX_WORDS / 2];
+    size_t lanes = words / 2;
+
+    for (size_t w = 0; w < lanes; w++) acc[w] = _mm_setzero_si128();
+    for (size_t i = 0; i < n; i++) {
+        __m128i mask = _mm_set1_epi64x((long long)ct_eq_mask(i, idx));
+        const __m128i *e = (const __m128i *)(table + i * words);
+        for (size_t w = 0; w < lanes; w++) {
+            acc[w] = _mm_or_si128(acc[w], _mm_and_si128(_mm_load_si128(e + w), mask));
+        }
+    }
+    for (size_t w = 0; w < lanes; w++) _mm_storeu_si128((__m128i *)out + w, acc[w]);
+}
+
+__attribute__((target("avx2")))
+static void select_avx2(uint64_t *out, const uint64_t *table, size_t n, size_t words,
+                        uint64_t idx) {
+    __m256i acc[EC_TABLE_MAX_WORDS / 4];
+    size_t lanes = words / 4;
+
+    for (size_t w = 0; w < lanes; w++) acc[w] = _mm256_setzero_si256();
+    for (size_t i = 0; i < n; i++) {
+        __m256i mask = _mm256_set1_epi64x((long long)ct_eq_mask(i, idx));
+        const __m256i *e = (const __m256i *)(table + i * words);
+        for (size_t w = 0; w < lanes; w++) {
+            acc[w] = _mm256_or_si256(acc[w], _mm256_and_si256(_mm256_load_si256(e + w), mask));
+        }
+    }
+    for (size_t w = 0; w < lanes; w++) _mm256_storeu_si256((__m256i *)out + w, acc[w]);
+}
+#endif
+
+static select_fn select_impl = select_scalar;
+
+void ec_table_select_init(int level) {
+    select_impl = select_scalar;
+
+#ifdef HAVE_X86_SIMD
+    if (level >= 1) {
+        select_impl = select_sse2;
+    }
+    if (level >= 2 && (ec_cpu_features() & EC_CPU_AVX2)) {
+        select_impl = select_avx2;
+    }
+#else
+    (void)level;
+#endif
+}
+
+const char *ec_table_select_backend(void) {
+#ifdef HAVE_X86_SIMD
+    if (select_impl == select_avx2) return "avx2";
+    if (select_impl == select_sse2) return "sse2";
+#endif
+    return "scalar";
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((constructor)) static void ec_table_select_load(void) {
+    ec_table_select_init(2);
+}
+#endif
+
+void ec_table_select(uint64_t *out, const uint64_t *table, size_t n, size_t words, uint64_t idx) {
+    select_impl(out, table, n, words, idx);
+}
@@ -0,0 +1,64 @@
+/*
+ * curve_consts.c
+ *
+ * Run-time construction of the derived constant block for curves that
+ * do not carry a static one. See curve_consts.h.
+ */
+
+#include "curve_consts.h"
+
+#include <modplus.h>
+#include <string.h>
+
+void ec_curve_consts_init(const ec_domain_params_t *curve, ec_curve_consts_t *c) {
+    uint256_t one = {{1, 0, 0, 0}}, three = {{3, 0, 0, 0}}, pm3;
+
+    memset(c, 0, sizeof(*c));
+    c->p = curve->p;
+    c->a = curve->a;
+    c->b = curve->b;
+    c->gx = curve->G.x;
+    c->gy = curve->G.y;
+
+    mod_add(&curve->b, &curve->b, &curve->p, &c->b3);
+    mod_add(&c->b3, &curve->b, &curve->p, &c->b3);
+
+    /* p + 1 cannot overflow since p < 2^256 - 1 */
+    if ((curve->p.limb[0] & 3) == 3) {
+        uint256_add(&curve->p, &one, &c->sqrt_exp);
+        uint256_rshift1(&c->sqrt_exp);
+        uint256_rshift1(&c->sqrt_exp);
+    }
+
+    scalar_mont_init(&c->n_mont, &curve->n);
+
+    uint256_sub(&curve->p, &three, &pm3);
+    c->a_is_minus3 = uint256_cmp(&curve->a, &pm3) == 0;
+
+    /* the fixed-base table is only linked to built-in blocks */
+    c->g_table = 0;
+}
+
+static int u256_eq(const uint256_t *a, const uint256_t *b) {
+    return memcmp(a->limb, b->limb, sizeof(a->limb)) == 0;
+}
+
+/* Domain parameters are public, so plain comparisons are fine. */
+const ec_curve_consts_t *ec_curve_consts_lookup(const ec_domain_params_t *curve) {
+    const ec_curve_consts_t *c = curve->consts;
+
+    if (c && u256_eq(&c->n_mont.n, &curve->n) && u256_eq(&c->p, &curve->p) &&
+        u256_eq(&c->b, &curve->b) && u256_eq(&c->a, &curve->a) &&
+        u256_eq(&c->gx, &curve->G.x) && u256_eq(&c->gy, &curve->G.y)) {
+        return c;
+    }
+    return NULL;
+}
+
+const ec_curve_consts_t *ec_curve_consts(const ec_domain_params_t *curve, ec_curve_consts_t *tmp) {
+    const ec_curve_consts_t *c = ec_curve_consts_lookup(curve);
+
+    if (c) return c;
+    ec_curve_consts_init(curve, tmp);
+    return tmp;
+}
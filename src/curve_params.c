@@ -7,49 +7,92 @@
 
 #include "ec.h"
 #include "curve_params.h"
+#include "curve_consts.h"
 
-const ec_domain_params_t secp256r1 = {
-    .p = { .limb = { 
-        0xffffffffffffffffULL,
-        0x00000000ffffffffULL,
-        0x0000000000000000ULL,
-        0xffffffff00000001ULL
+/* secp256r1 parameters, shared by the curve and the copy its constant
+ * block keeps (curve_consts.h) */
+#define SECP256R1_P { .limb = {     \
+        0xffffffffffffffffULL,      \
+        0x00000000ffffffffULL,      \
+        0x0000000000000000ULL,      \
+        0xffffffff00000001ULL       \
+    }}
+#define SECP256R1_A { .limb = {     \
+        0xfffffffffffffffcULL,      \
+        0x00000000ffffffffULL,      \
+        0x0000000000000000ULL,      \
+        0xffffffff00000001ULL       \
+    }}
+#define SECP256R1_B { .limb = {     \
+        0x3bce3c3e27d2604bULL,      \
+        0x651d06b0cc53b0f6ULL,      \
+        0xb3ebbd55769886bcULL,      \
+        0x5ac635d8aa3a93e7ULL       \
+    }}
+#define SECP256R1_GX { .limb = {    \
+        0xf4a13945d898c296ULL,      \
+        0x77037d812deb33a0ULL,      \
+        0xf8bce6e563a440f2ULL,      \
+        0x6b17d1f2e12c4247ULL       \
+    }}
+#define SECP256R1_GY { .limb = {    \
+        0xcbb6406837bf51f5ULL,      \
+        0x2bce33576b315eceULL,      \
+        0x8ee7eb4a7c0f9e16ULL,      \
+        0x4fe342e2fe1a7f9bULL       \
+    }}
+#define SECP256R1_N { .limb = {     \
+        0xf3b9cac2fc632551ULL,      \
+        0xbce6faada7179e84ULL,      \
+        0xffffffffffffffffULL,      \
+        0xffffffff00000000ULL       \
+    }}
+
+static const ec_curve_consts_t secp256r1_consts = {
+    .p = SECP256R1_P,
+    .a = SECP256R1_A,
+    .b = SECP256R1_B,
+    .gx = SECP256R1_GX,
+    .gy = SECP256R1_GY,
+    .b3 = { .limb = {
+        0xb36ab4ba777720e2ULL,
+        0x2f57141164fb12e2ULL,
+        0x1bc3380063c99435ULL,
+        0x1052a18afeafbbb6ULL
     }},
-    .a = { .limb = { 
-        0xfffffffffffffffcULL, 
-        0x00000000ffffffffULL,
+    .sqrt_exp = { .limb = {         // (p + 1) / 4
         0x0000000000000000ULL,
-        0xffffffff00000001ULL  
+        0x0000000040000000ULL,
+        0x4000000000000000ULL,
+        0x3fffffffc0000000ULL
     }},
-    .b = { .limb = { 
-        0x3bce3c3e27d2604bULL,
-        0x651d06b0cc53b0f6ULL,
-        0xb3ebbd55769886bcULL,
-        0x5ac635d8aa3a93e7ULL
-    }},
-    .G = {
-        { .limb = { 
-            0xf4a13945d898c296ULL, //Gx
-            0x77037d812deb33a0ULL,
-            0xf8bce6e563a440f2ULL,
-            0x6b17d1f2e12c4247ULL
-        }},
-        { .limb = { 
-            0xcbb6406837bf51f5ULL, // Gy
-            0x2bce33576b315eceULL,
-            0x8ee7eb4a7c0f9e16ULL,
-            0x4fe342e2fe1a7f9bULL 
+    .n_mont = {
+        .n = SECP256R1_N,
+        .rr = { .limb = {           // 2^512 mod n
+            0x83244c95be79eea2ULL,
+            0x4699799c49bd6fa6ULL,
+            0x2845b2392b6bec59ULL,
+            0x66e12d94f3d95620ULL
         }},
+        .n0 = 0xccd1c8aaee00bc4fULL // -n^-1 mod 2^64
+    },
+    .a_is_minus3 = 1,
+    .g_table = 1
+};
+
+const ec_domain_params_t secp256r1 = {
+    .p = SECP256R1_P,
+    .a = SECP256R1_A,
+    .b = SECP256R1_B,
+    .G = {
+        SECP256R1_GX,
+        SECP256R1_GY,
         { .limb = {
             0x1                     // Gz
         }},
         .infinity = 0
     },
-    .n = { .limb = { 
-        0xf3b9cac2fc632551ULL,
-        0xbce6faada7179e84ULL,
-        0xffffffffffffffffULL,
-        0xffffffff00000000ULL
-    }},
-    .h = 1
+    .n = SECP256R1_N,
+    .h = 1,
+    .consts = &secp256r1_consts
 };
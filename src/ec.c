@@ -7,6 +7,12 @@
 
 #include "ec.h"
 #include "curve_params.h"
+#include "curve_consts.h"
+#include "field.h"
+#include "ct_select.h"
+#include "ec_lanes.h"
+#include "gtable.h"
+#include "secure_wipe.h"
 
 #include <modplus.h>
 #include <string.h>
@@ -16,24 +22,18 @@
  * extra digit, so 257 digits are required to be lossless. */
 #define L 257
 #define TABLE_SIZE  (1 << (W - 2))
+/* Results normalized together by ec_scalar_multiply_batch (one inversion each). */
+#define BATCH_CHUNK 32
 
+/* Ladder table entries are ec_affine_t: affine X and Y, exactly one cache
+ * line, so that the vector scan in ct_select.c runs on aligned loads. */
+#define ENTRY_WORDS (sizeof(ec_affine_t) / sizeof(uint64_t))
 
-static void ec_calculate_coordinates(const ec_domain_params_t *curve, const uint256_t *lambda, const ec_point_t *P, const ec_point_t *Q, ec_point_t *R) {
+_Static_assert(sizeof(ec_affine_t) == 64 && _Alignof(ec_affine_t) == EC_TABLE_ALIGN,
+               "ladder table entries must be one aligned cache line");
+_Static_assert(EC_LANES_TABLE == TABLE_SIZE && EC_LANES_DIGITS == L,
+               "the lane ladder runs the same tables and digits");
 
-    uint256_t lambda2, tmp, mx;
-
-
-    // Calculate xR
-    mod_mul(lambda, lambda, &curve->p, &lambda2);
-    mod_sub(&lambda2, &P->x, &curve->p, &tmp);
-    mod_sub(&tmp, &Q->x, &curve->p, &R->x);
-
-    // Calculate yR
-    mod_sub(&P->x, &R->x, &curve->p, &tmp);
-    mod_mul(lambda, &tmp, &curve->p, &mx);
-    mod_sub(&mx, &P->y, &curve->p, &R->y);
-
-}
 
 static inline uint64_t ct_mask_u64(uint64_t b) { return (uint64_t) (-(int64_t)b); }
 
@@ -58,114 +58,428 @@ static inline uint64_t ct_eq_u64(uint64_t a, uint64_t b) {
  * the secret-dependent control flow the Jacobian add/double have.
  * The identity is (0 : 1 : 0). */
 
-static void PointSetIdentity(ec_point_t *P) {
+static void PointSetIdentity(ec_proj_t *P) {
     memset(&P->x, 0, sizeof(uint256_t));
     memset(&P->y, 0, sizeof(uint256_t)); P->y.limb[0] = 1;
     memset(&P->z, 0, sizeof(uint256_t));
-    P->infinity = 1;
 }
 
+#ifdef EC_FIELD_5X52
+/* Points on the P-256 5x52 representation, in the Montgomery domain of
+ * field.h. A ladder converts its table and the curve coefficients once
+ * and keeps the accumulator in this form until it returns. The affine
+ * entry is padded to a multiple of four words for ec_table_select. */
+typedef struct {
+    fe52_t x, y, z;
+} proj52_t;
+
+typedef struct {
+    fe52_t x, y;
+    uint64_t pad[2];
+} affine52_t;
+
+typedef struct {
+    fe52_t a, b3;
+} coef52_t;
+
+#define ENTRY52_WORDS (sizeof(affine52_t) / sizeof(uint64_t))
+
+static void Coef52(const ec_domain_params_t *curve, const uint256_t *b3, coef52_t *c) {
+    fe52_from_u256(&c->a, &curve->a);
+    fe52_to_mont(&c->a, &c->a);
+    fe52_from_u256(&c->b3, b3);
+    fe52_to_mont(&c->b3, &c->b3);
+}
+
+static void Affine52FromAffine(const ec_affine_t *A, affine52_t *R) {
+    fe52_from_u256(&R->x, &A->x);
+    fe52_to_mont(&R->x, &R->x);
+    fe52_from_u256(&R->y, &A->y);
+    fe52_to_mont(&R->y, &R->y);
+    R->pad[0] = R->pad[1] = 0;
+}
+
+/* Projective coordinates enter and leave without a domain change: all
+ * three carry the same factor 2^260. */
+static void Proj52FromProj(const ec_proj_t *P, proj52_t *R) {
+    fe52_from_u256(&R->x, &P->x);
+    fe52_from_u256(&R->y, &P->y);
+    fe52_from_u256(&R->z, &P->z);
+}
+
+static void ProjFromProj52(const proj52_t *P, ec_proj_t *R) {
+    fe52_to_u256(&R->x, &P->x);
+    fe52_to_u256(&R->y, &P->y);
+    fe52_to_u256(&R->z, &P->z);
+}
+
+/* The formula of ec_complete_add on the 5x52 representation. Sums and
+ * differences stay unreduced; the trailing comments give each value's
+ * magnitude for inputs of magnitude at most 3, which covers the outputs
+ * (3, 2, 2) fed back by a ladder. No multiplication sees more than 6. */
+static void ec_complete_add52(const coef52_t *c, const proj52_t *P, const proj52_t *Q,
+                              proj52_t *R) {
+    fe52_t t0, t1, t2, t3, t4, t5, X3, Y3, Z3;
+
+    fe52_mul(&t0, &P->x, &Q->x);
+    fe52_mul(&t1, &P->y, &Q->y);
+    fe52_mul(&t2, &P->z, &Q->z);
+    fe52_add(&t3, &P->x, &P->y);        /* 6 */
+    fe52_add(&t4, &Q->x, &Q->y);        /* 6 */
+    fe52_mul(&t3, &t3, &t4);
+    fe52_add(&t4, &t0, &t1);            /* 2 */
+    fe52_sub(&t3, &t3, &t4, 2);         /* 5 */
+    fe52_add(&t4, &P->x, &P->z);        /* 6 */
+    fe52_add(&t5, &Q->x, &Q->z);        /* 6 */
+    fe52_mul(&t4, &t4, &t5);
+    fe52_add(&t5, &t0, &t2);            /* 2 */
+    fe52_sub(&t4, &t4, &t5, 2);         /* 5 */
+    fe52_add(&t5, &P->y, &P->z);        /* 6 */
+    fe52_add(&X3, &Q->y, &Q->z);        /* 6 */
+    fe52_mul(&t5, &t5, &X3);
+    fe52_add(&X3, &t1, &t2);            /* 2 */
+    fe52_sub(&t5, &t5, &X3, 2);         /* 5 */
+    fe52_mul(&Z3, &c->a, &t4);
+    fe52_mul(&X3, &c->b3, &t2);
+    fe52_add(&Z3, &X3, &Z3);            /* 2 */
+    fe52_sub(&X3, &t1, &Z3, 2);         /* 5 */
+    fe52_add(&Z3, &t1, &Z3);            /* 3 */
+    fe52_mul(&Y3, &X3, &Z3);
+    fe52_mul_small(&t1, &t0, 3);        /* 3 */
+    fe52_mul(&t2, &c->a, &t2);
+    fe52_mul(&t4, &c->b3, &t4);
+    fe52_add(&t1, &t1, &t2);            /* 4 */
+    fe52_sub(&t2, &t0, &t2, 1);         /* 3 */
+    fe52_mul(&t2, &c->a, &t2);
+    fe52_add(&t4, &t4, &t2);            /* 2 */
+    fe52_mul(&t0, &t1, &t4);
+    fe52_add(&Y3, &Y3, &t0);            /* 2 */
+    fe52_mul(&t0, &t5, &t4);
+    fe52_mul(&X3, &t3, &X3);
+    fe52_sub(&X3, &X3, &t0, 1);         /* 3 */
+    fe52_mul(&t0, &t3, &t1);
+    fe52_mul(&Z3, &t5, &Z3);
+    fe52_add(&Z3, &Z3, &t0);            /* 2 */
+
+    R->x = X3;
+    R->y = Y3;
+    R->z = Z3;
+}
+
+static void ec_complete_add_5x52(const ec_domain_params_t *curve, const uint256_t *b3,
+                                 const ec_proj_t *P, const ec_proj_t *Q, ec_proj_t *R) {
+    coef52_t c;
+    proj52_t P52, Q52;
+
+    Coef52(curve, b3, &c);
+    Proj52FromProj(P, &P52);
+    Proj52FromProj(Q, &Q52);
+    ec_complete_add52(&c, &P52, &Q52, &P52);
+    ProjFromProj52(&P52, R);
+}
+#endif
+
 /* Complete addition, homogeneous projective coordinates, any curve a.
  * b3 = 3*b mod p must be supplied by the caller. No branches. */
 static void ec_complete_add(const ec_domain_params_t *curve, const uint256_t *b3,
-                            const ec_point_t *P, const ec_point_t *Q, ec_point_t *R) {
+                            const ec_proj_t *P, const ec_proj_t *Q, ec_proj_t *R) {
     const uint256_t *prime = &curve->p;
     uint256_t t0, t1, t2, t3, t4, t5;
     uint256_t X3, Y3, Z3;
 
-    mod_mul(&P->x, &Q->x, prime, &t0);
-    mod_mul(&P->y, &Q->y, prime, &t1);
-    mod_mul(&P->z, &Q->z, prime, &t2);
+#ifdef EC_FIELD_5X52
+    if (p256_is_prime(prime)) {
+        ec_complete_add_5x52(curve, b3, P, Q, R);
+        return;
+    }
+#endif
+
+    fe_mul(curve, &P->x, &Q->x, &t0);
+    fe_mul(curve, &P->y, &Q->y, &t1);
+    fe_mul(curve, &P->z, &Q->z, &t2);
     mod_add(&P->x, &P->y, prime, &t3);
     mod_add(&Q->x, &Q->y, prime, &t4);
-    mod_mul(&t3, &t4, prime, &t3);
+    fe_mul(curve, &t3, &t4, &t3);
     mod_add(&t0, &t1, prime, &t4);
     mod_sub(&t3, &t4, prime, &t3);
     mod_add(&P->x, &P->z, prime, &t4);
     mod_add(&Q->x, &Q->z, prime, &t5);
-    mod_mul(&t4, &t5, prime, &t4);
+    fe_mul(curve, &t4, &t5, &t4);
     mod_add(&t0, &t2, prime, &t5);
     mod_sub(&t4, &t5, prime, &t4);
     mod_add(&P->y, &P->z, prime, &t5);
     mod_add(&Q->y, &Q->z, prime, &X3);
-    mod_mul(&t5, &X3, prime, &t5);
+    fe_mul(curve, &t5, &X3, &t5);
     mod_add(&t1, &t2, prime, &X3);
     mod_sub(&t5, &X3, prime, &t5);
-    mod_mul(&curve->a, &t4, prime, &Z3);
-    mod_mul(b3, &t2, prime, &X3);
+    fe_mul(curve, &curve->a, &t4, &Z3);
+    fe_mul(curve, b3, &t2, &X3);
+    mod_add(&X3, &Z3, prime, &Z3);
+    mod_sub(&t1, &Z3, prime, &X3);
+    mod_add(&t1, &Z3, prime, &Z3);
+    fe_mul(curve, &X3, &Z3, &Y3);
+    mod_add(&t0, &t0, prime, &t1);
+    mod_add(&t1, &t0, prime, &t1);
+    fe_mul(curve, &curve->a, &t2, &t2);
+    fe_mul(curve, b3, &t4, &t4);
+    mod_add(&t1, &t2, prime, &t1);
+    mod_sub(&t0, &t2, prime, &t2);
+    fe_mul(curve, &curve->a, &t2, &t2);
+    mod_add(&t4, &t2, prime, &t4);
+    fe_mul(curve, &t1, &t4, &t0);
+    mod_add(&Y3, &t0, prime, &Y3);
+    fe_mul(curve, &t5, &t4, &t0);
+    fe_mul(curve, &t3, &X3, &X3);
+    mod_sub(&X3, &t0, prime, &X3);
+    fe_mul(curve, &t3, &t1, &t0);
+    fe_mul(curve, &t5, &Z3, &Z3);
+    mod_add(&Z3, &t0, prime, &Z3);
+
+    R->x = X3;
+    R->y = Y3;
+    R->z = Z3;
+}
+
+
+#ifdef EC_FIELD_5X52
+/* Mixed addition on the 5x52 representation. Q's y may be a negated
+ * table entry, of magnitude 2; the rest as above. */
+static void ec_complete_add_mixed52(const coef52_t *c, const proj52_t *P, const affine52_t *Q,
+                                    proj52_t *R) {
+    fe52_t t0, t1, t2, t3, t4, t5, X3, Y3, Z3;
+
+    fe52_mul(&t0, &P->x, &Q->x);
+    fe52_mul(&t1, &P->y, &Q->y);
+    fe52_add(&t3, &Q->x, &Q->y);        /* 3 */
+    fe52_add(&t4, &P->x, &P->y);        /* 6 */
+    fe52_mul(&t3, &t3, &t4);
+    fe52_add(&t4, &t0, &t1);            /* 2 */
+    fe52_sub(&t3, &t3, &t4, 2);         /* 5 */
+    fe52_mul(&t4, &Q->x, &P->z);
+    fe52_add(&t4, &t4, &P->x);          /* 4 */
+    fe52_mul(&t5, &Q->y, &P->z);
+    fe52_add(&t5, &t5, &P->y);          /* 4 */
+    fe52_mul(&Z3, &c->a, &t4);
+    fe52_mul(&X3, &c->b3, &P->z);
+    fe52_add(&Z3, &X3, &Z3);            /* 2 */
+    fe52_sub(&X3, &t1, &Z3, 2);         /* 5 */
+    fe52_add(&Z3, &t1, &Z3);            /* 3 */
+    fe52_mul(&Y3, &X3, &Z3);
+    fe52_mul_small(&t1, &t0, 3);        /* 3 */
+    fe52_mul(&t2, &c->a, &P->z);
+    fe52_mul(&t4, &c->b3, &t4);
+    fe52_add(&t1, &t1, &t2);            /* 4 */
+    fe52_sub(&t2, &t0, &t2, 1);         /* 3 */
+    fe52_mul(&t2, &c->a, &t2);
+    fe52_add(&t4, &t4, &t2);            /* 2 */
+    fe52_mul(&t0, &t1, &t4);
+    fe52_add(&Y3, &Y3, &t0);            /* 2 */
+    fe52_mul(&t0, &t5, &t4);
+    fe52_mul(&X3, &t3, &X3);
+    fe52_sub(&X3, &X3, &t0, 1);         /* 3 */
+    fe52_mul(&t0, &t3, &t1);
+    fe52_mul(&Z3, &t5, &Z3);
+    fe52_add(&Z3, &Z3, &t0);            /* 2 */
+
+    R->x = X3;
+    R->y = Y3;
+    R->z = Z3;
+}
+
+static void ec_complete_add_mixed_5x52(const ec_domain_params_t *curve, const uint256_t *b3,
+                                       const ec_proj_t *P, const ec_affine_t *Q, ec_proj_t *R) {
+    coef52_t c;
+    proj52_t P52;
+    affine52_t Q52;
+
+    Coef52(curve, b3, &c);
+    Proj52FromProj(P, &P52);
+    Affine52FromAffine(Q, &Q52);
+    ec_complete_add_mixed52(&c, &P52, &Q52, &P52);
+    ProjFromProj52(&P52, R);
+}
+
+static void CMoveProj52(proj52_t *dest, const proj52_t *src, uint64_t sel) {
+    uint64_t mask = ct_mask_u64(sel);
+    for (int i = 0; i < 5; ++i) {
+        dest->x.n[i] = (dest->x.n[i] & ~mask) | (src->x.n[i] & mask);
+        dest->y.n[i] = (dest->y.n[i] & ~mask) | (src->y.n[i] & mask);
+        dest->z.n[i] = (dest->z.n[i] & ~mask) | (src->z.n[i] & mask);
+    }
+}
+
+/* (x, y) -> (x, -y) when sign is 1. y leaves with magnitude at most 2. */
+static void ConditionalNegateAffine52(affine52_t *A, uint64_t sign) {
+    uint64_t mask = ct_mask_u64(sign);
+    fe52_t zero = {{0}}, neg_y;
+
+    fe52_sub(&neg_y, &zero, &A->y, 1);
+    for (int i = 0; i < 5; ++i) {
+        A->y.n[i] = (A->y.n[i] & ~mask) | (neg_y.n[i] & mask);
+    }
+}
+#endif
+
+/* Mixed complete addition (RCB Algorithm 2): P projective, Q affine
+ * (Z2 = 1 implied). Complete except that Q must not be
+ * the identity, which has no affine form. b3 = 3*b mod p. No branches. */
+static void ec_complete_add_mixed(const ec_domain_params_t *curve, const uint256_t *b3,
+                                  const ec_proj_t *P, const ec_affine_t *Q, ec_proj_t *R) {
+    const uint256_t *prime = &curve->p;
+    uint256_t t0, t1, t2, t3, t4, t5;
+    uint256_t X3, Y3, Z3;
+
+#ifdef EC_FIELD_5X52
+    if (p256_is_prime(prime)) {
+        ec_complete_add_mixed_5x52(curve, b3, P, Q, R);
+        return;
+    }
+#endif
+
+    fe_mul(curve, &P->x, &Q->x, &t0);
+    fe_mul(curve, &P->y, &Q->y, &t1);
+    mod_add(&Q->x, &Q->y, prime, &t3);
+    mod_add(&P->x, &P->y, prime, &t4);
+    fe_mul(curve, &t3, &t4, &t3);
+    mod_add(&t0, &t1, prime, &t4);
+    mod_sub(&t3, &t4, prime, &t3);
+    fe_mul(curve, &Q->x, &P->z, &t4);
+    mod_add(&t4, &P->x, prime, &t4);
+    fe_mul(curve, &Q->y, &P->z, &t5);
+    mod_add(&t5, &P->y, prime, &t5);
+    fe_mul(curve, &curve->a, &t4, &Z3);
+    fe_mul(curve, b3, &P->z, &X3);
     mod_add(&X3, &Z3, prime, &Z3);
     mod_sub(&t1, &Z3, prime, &X3);
     mod_add(&t1, &Z3, prime, &Z3);
-    mod_mul(&X3, &Z3, prime, &Y3);
+    fe_mul(curve, &X3, &Z3, &Y3);
     mod_add(&t0, &t0, prime, &t1);
     mod_add(&t1, &t0, prime, &t1);
-    mod_mul(&curve->a, &t2, prime, &t2);
-    mod_mul(b3, &t4, prime, &t4);
+    fe_mul(curve, &curve->a, &P->z, &t2);
+    fe_mul(curve, b3, &t4, &t4);
     mod_add(&t1, &t2, prime, &t1);
     mod_sub(&t0, &t2, prime, &t2);
-    mod_mul(&curve->a, &t2, prime, &t2);
+    fe_mul(curve, &curve->a, &t2, &t2);
     mod_add(&t4, &t2, prime, &t4);
-    mod_mul(&t1, &t4, prime, &t0);
+    fe_mul(curve, &t1, &t4, &t0);
     mod_add(&Y3, &t0, prime, &Y3);
-    mod_mul(&t5, &t4, prime, &t0);
-    mod_mul(&t3, &X3, prime, &X3);
+    fe_mul(curve, &t5, &t4, &t0);
+    fe_mul(curve, &t3, &X3, &X3);
     mod_sub(&X3, &t0, prime, &X3);
-    mod_mul(&t3, &t1, prime, &t0);
-    mod_mul(&t5, &Z3, prime, &Z3);
+    fe_mul(curve, &t3, &t1, &t0);
+    fe_mul(curve, &t5, &Z3, &Z3);
     mod_add(&Z3, &t0, prime, &Z3);
 
     R->x = X3;
     R->y = Y3;
     R->z = Z3;
-    R->infinity = 0; /* identity is represented by Z == 0; flag fixed up by caller */
 }
 
 
-static void CMovePoint(ec_point_t *dest, const ec_point_t *src, uint64_t sel) {
+static void CMoveProj(ec_proj_t *dest, const ec_proj_t *src, uint64_t sel) {
     uint64_t mask = ct_mask_u64(sel); // 0xFF.. if sel==1 else 0
     for (int i = 0; i < 4; ++i) {
         dest->x.limb[i] = (dest->x.limb[i] & ~mask) | (src->x.limb[i] & mask);
         dest->y.limb[i] = (dest->y.limb[i] & ~mask) | (src->y.limb[i] & mask);
         dest->z.limb[i] = (dest->z.limb[i] & ~mask) | (src->z.limb[i] & mask);
     }
+}
+
+/* Branch-free negation of a table entry in place: (x, y) -> (x, p - y). */
+static void ConditionalNegateAffine(const ec_domain_params_t *curve, ec_affine_t *A, uint64_t sign) {
+    uint64_t mask = ct_mask_u64(sign);
+    uint256_t neg_y;
+
+    mod_sub(&curve->p, &A->y, &curve->p, &neg_y);
+    for (int i = 0; i < 4; ++i) {
+        A->y.limb[i] = (A->y.limb[i] & ~mask) | (neg_y.limb[i] & mask);
+    }
+}
 
-    uint64_t inf_mask = (uint64_t)(-(int64_t)sel);
-    dest->infinity = (uint8_t)((dest->infinity & ~inf_mask) | (src->infinity & inf_mask));
+static void ProjFromAffine(const ec_affine_t *A, ec_proj_t *P) {
+    P->x = A->x;
+    P->y = A->y;
+    memset(&P->z, 0, sizeof(P->z));
+    P->z.limb[0] = 1;
 }
 
-/* Branch-free negation in homogeneous coordinates: (X, p-Y, Z).
- * The identity (0 : 1 : 0) maps to (0 : p-1 : 0), which is the same
- * projective point, so no special case is needed. */
-static void ConditionalNegatePoint(const ec_domain_params_t *curve, const ec_point_t *in, ec_point_t *out, uint64_t sign) {
-    ec_point_t neg;
-    neg.x = in->x;
-    mod_sub(&curve->p, &in->y, &curve->p, &neg.y);
-    neg.z = in->z;
-    neg.infinity = in->infinity;
-    *out = *in;
-    CMovePoint(out, &neg, sign);
+/* Homogeneous -> affine for up to BATCH_CHUNK points with a single
+ * inversion (Montgomery's trick). Z == 0 marks the identity, which has no
+ * affine form: its entry in A is zeroed and callers test Q[i].z. */
+static void ProjBatchToAffine(const ec_domain_params_t *curve, const ec_proj_t *Q,
+                              ec_affine_t *A, size_t m) {
+    uint256_t prefix[BATCH_CHUNK];
+    uint256_t acc = {{1, 0, 0, 0}};
+    uint256_t inv, z_inv;
+
+    /* prefix[i] = product of the nonzero Z_j for j < i */
+    for (size_t i = 0; i < m; ++i) {
+        prefix[i] = acc;
+        if (!uint256_is_zero(&Q[i].z)) {
+            fe_mul(curve, &acc, &Q[i].z, &acc);
+        }
+    }
+
+    mod_inv(&acc, &curve->p, &inv);
+
+    for (size_t i = m; i-- > 0;) {
+        if (uint256_is_zero(&Q[i].z)) {
+            memset(&A[i], 0, sizeof(A[i]));
+            continue;
+        }
+        fe_mul(curve, &inv, &prefix[i], &z_inv);
+        fe_mul(curve, &inv, &Q[i].z, &inv);
+
+        fe_mul(curve, &Q[i].x, &z_inv, &A[i].x);
+        fe_mul(curve, &Q[i].y, &z_inv, &A[i].y);
+    }
 }
 
+static void ComputeB3(const ec_domain_params_t *curve, uint256_t *b3) {
+    const ec_curve_consts_t *c = ec_curve_consts_lookup(curve);
 
+    if (c) {
+        *b3 = c->b3;
+        return;
+    }
+    mod_add(&curve->b, &curve->b, &curve->p, b3);
+    mod_add(b3, &curve->b, &curve->p, b3);
+}
+
+/* Odd multiples 1P, 3P, ..., (2 TABLE_SIZE - 1)P, normalized to affine
+ * with one shared inversion so the ladder can use mixed additions. */
 static void PrecomputeTable(const ec_domain_params_t *curve, const uint256_t *b3,
-                            const ec_point_t *P, ec_point_t *T /*size TABLE_SIZE*/) {
-    T[0] = *P;
-    ec_point_t twoP;
-    ec_complete_add(curve, b3, P, P, &twoP);
+                            const ec_affine_t *P, ec_affine_t *T /*size TABLE_SIZE*/) {
+    ec_proj_t mult[TABLE_SIZE], twoP;
 
+    ProjFromAffine(P, &mult[0]);
+    ec_complete_add_mixed(curve, b3, &mult[0], P, &twoP);
     for (int j = 1; j < TABLE_SIZE; ++j) {
         // T[j] = T[j-1] + twoP  (so sequence 1P,3P,5P,...)
-        ec_complete_add(curve, b3, &T[j-1], &twoP, &T[j]);
+        ec_complete_add(curve, b3, &mult[j-1], &twoP, &mult[j]);
     }
+
+    ProjBatchToAffine(curve, mult, T, TABLE_SIZE);
 }
 
-static void SelectFromTableConst(const ec_point_t *T, uint64_t j, uint64_t mask_nonzero, ec_point_t *S_out) {
-    PointSetIdentity(S_out);
-    for (uint64_t t = 0; t < TABLE_SIZE; ++t) {
-        uint64_t eq = ct_eq_u64(j, t);
-        uint64_t sel = eq & mask_nonzero;
-        CMovePoint(S_out, &T[t], sel);
+/* The same table for a projective P: the normalization of P itself is
+ * folded into the table's shared inversion. P must not be the identity. */
+static void PrecomputeTableProj(const ec_domain_params_t *curve, const uint256_t *b3,
+                                const ec_proj_t *P, ec_affine_t *T /*size TABLE_SIZE*/) {
+    ec_proj_t mult[TABLE_SIZE], twoP;
+
+    mult[0] = *P;
+    ec_complete_add(curve, b3, P, P, &twoP);
+    for (int j = 1; j < TABLE_SIZE; ++j) {
+        ec_complete_add(curve, b3, &mult[j-1], &twoP, &mult[j]);
     }
+
+    ProjBatchToAffine(curve, mult, T, TABLE_SIZE);
+}
+
+/* S = T[j], or all zeros if j >= TABLE_SIZE. */
+static void SelectFromTableConst(const ec_affine_t *T, uint64_t j, ec_affine_t *S) {
+    ec_table_select((uint64_t *)S, (const uint64_t *)T, TABLE_SIZE, ENTRY_WORDS, j);
 }
 
 
@@ -203,6 +517,9 @@ static void ec_wnaf_encode_const(const uint256_t *n, uint256_t *d) {
 
         uint256_t tmp_add; uint256_add(&k, &di256, &tmp_add);
         uint256_t tmp_sub; uint256_sub(&k, &di256, &tmp_sub);
+        // k + |di| carries out of 256 bits only when k >= 2^256 - 15
+        uint64_t carry = (uint64_t)(tmp_add.limb[0] < k.limb[0]) &
+                         ct_eq_u64(k.limb[1] & k.limb[2] & k.limb[3], ~0ULL);
 
         // choose tmp = (di_signed < 0) ? tmp_add : tmp_sub
         uint64_t neg_mask = (di_signed < 0) ? ~0ULL : 0ULL; // all-ones if negative
@@ -213,49 +530,195 @@ static void ec_wnaf_encode_const(const uint256_t *n, uint256_t *d) {
 
         k = tmp_chosen;
         uint256_rshift1(&k);
+        k.limb[3] |= (carry & neg_mask) << 63;
     }
 }
 
-/* P_h must be in homogeneous projective coordinates (identity = (0:1:0)).
- * Every group operation in the loop is a complete addition, so there is
- * no secret-dependent control flow at this level. Zero digits add the
- * identity instead of skipping the addition. */
-static void wnaf_mul_const(const ec_domain_params_t *curve, const ec_point_t *P_h, const uint256_t *d, ec_point_t *Q_h) {
-    ec_point_t T[TABLE_SIZE];
-    uint256_t b3;
+/* Q_h += sign * T[(abs_val - 1) / 2], or Q_h unchanged when abs_val == 0,
+ * with the same work either way. */
+static void AddSignedDigit(const ec_domain_params_t *curve, const uint256_t *b3,
+                           const ec_affine_t *T, uint64_t abs_val, uint64_t sign_bit,
+                           ec_proj_t *Q_h) {
+    uint64_t is_zero = ct_eq_u64(abs_val, 0);
+    uint64_t mask_nonzero = 1 - is_zero;
+
+    // j = (abs_val - 1) / 2  (safe if abs_val==0; the sum is discarded then)
+    uint64_t safe_abs = abs_val | (1 - mask_nonzero); // becomes 1 when abs_val==0, avoiding underflow
+    uint64_t j_raw = ((safe_abs - 1) >> 1);
+
+    ec_affine_t S;
+    SelectFromTableConst(T, j_raw, &S);
+    ConditionalNegateAffine(curve, &S, sign_bit & mask_nonzero);
+
+    ec_proj_t sum;
+    ec_complete_add_mixed(curve, b3, Q_h, &S, &sum);
+    CMoveProj(Q_h, &sum, mask_nonzero);
+}
 
-    mod_add(&curve->b, &curve->b, &curve->p, &b3);
-    mod_add(&b3, &curve->b, &curve->p, &b3);
+#ifdef EC_FIELD_5X52
+/* wnaf_ladder on the 5x52 representation: the table and the coefficients
+ * are converted once, and the accumulator stays in the Montgomery domain
+ * until the end. */
+static void wnaf_ladder_5x52(const ec_domain_params_t *curve, const uint256_t *b3,
+                             const ec_affine_t *T, const uint256_t *d, ec_proj_t *Q_h) {
+    _Alignas(EC_TABLE_ALIGN) affine52_t T52[TABLE_SIZE];
+    affine52_t S;
+    proj52_t Q, sum;
+    coef52_t c;
+
+    Coef52(curve, b3, &c);
+    for (int j = 0; j < TABLE_SIZE; ++j) {
+        Affine52FromAffine(&T[j], &T52[j]);
+    }
+    memset(&Q, 0, sizeof(Q));
+    Q.y.n[0] = 1;
+
+    for (int idx = L - 1; idx >= 0; --idx) {
+        uint64_t abs_val = d[idx].limb[0];
+        uint64_t nonzero = 1 - ct_eq_u64(abs_val, 0);
+        uint64_t j_raw = ((abs_val | (1 - nonzero)) - 1) >> 1; /* as in AddSignedDigit */
+
+        ec_complete_add52(&c, &Q, &Q, &Q);
 
-    PrecomputeTable(curve, &b3, P_h, T);
+        ec_table_select((uint64_t *)&S, (const uint64_t *)T52, TABLE_SIZE, ENTRY52_WORDS, j_raw);
+        ConditionalNegateAffine52(&S, d[idx].limb[1] & nonzero & 1ULL);
+        ec_complete_add_mixed52(&c, &Q, &S, &sum);
+        CMoveProj52(&Q, &sum, nonzero);
+    }
+
+    ProjFromProj52(&Q, Q_h);
+    secure_wipe(&S, sizeof(S));
+    secure_wipe(&Q, sizeof(Q));
+    secure_wipe(&sum, sizeof(sum));
+}
+#endif
+
+/* Q_h = d * P for an affine P, in homogeneous projective coordinates
+ * (identity = (0:1:0)). Every group operation in the loop is a complete addition, so there is
+ * no secret-dependent control flow at this level. The mixed addition
+ * cannot take the identity as its affine operand, so zero digits still
+ * add a table entry and the old accumulator is moved back afterwards. */
+static void wnaf_ladder(const ec_domain_params_t *curve, const uint256_t *b3, const ec_affine_t *T,
+                        const uint256_t *d, ec_proj_t *Q_h) {
+#ifdef EC_FIELD_5X52
+    if (p256_is_prime(&curve->p)) {
+        wnaf_ladder_5x52(curve, b3, T, d, Q_h);
+        return;
+    }
+#endif
     PointSetIdentity(Q_h);
 
     for (int idx = L - 1; idx >= 0; --idx) {
 
-        ec_complete_add(curve, &b3, Q_h, Q_h, Q_h);
+        ec_complete_add(curve, b3, Q_h, Q_h, Q_h);
 
-        uint64_t abs_val = d[idx].limb[0];
-        uint64_t sign_bit = d[idx].limb[1] & 1ULL;
-        uint64_t is_zero = ct_eq_u64(abs_val, 0);
-        uint64_t mask_nonzero = 1 - is_zero;
+        AddSignedDigit(curve, b3, T, d[idx].limb[0], d[idx].limb[1] & 1ULL, Q_h);
+    }
+}
 
-        // j = (abs_val - 1) / 2  (safe if abs_val==0; selection masked by mask_nonzero)
-        // Use constant-time: when abs_val==0, mask_nonzero==0 so j_raw is masked out anyway
-        uint64_t safe_abs = abs_val | (1 - mask_nonzero); // becomes 1 when abs_val==0, avoiding underflow
-        uint64_t j_raw = ((safe_abs - 1) >> 1);
+static void wnaf_mul_const(const ec_domain_params_t *curve, const ec_affine_t *P, const uint256_t *d, ec_proj_t *Q_h) {
+    ec_affine_t T[TABLE_SIZE];
+    uint256_t b3;
+
+    ComputeB3(curve, &b3);
+    PrecomputeTable(curve, &b3, P, T);
+    wnaf_ladder(curve, &b3, T, d, Q_h);
+}
 
-        ec_point_t S;
-        SelectFromTableConst(T, j_raw, mask_nonzero, &S);
 
-        ec_point_t A;
-        ConditionalNegatePoint(curve, &S, &A, sign_bit & mask_nonzero);
 
-        ec_complete_add(curve, &b3, Q_h, &A, Q_h);
+
+/* True when A (affine) is the base point of a curve whose constant block
+ * says the static table in gtable.h applies. Only public data is compared. */
+static int IsP256Generator(const ec_domain_params_t *curve, const ec_affine_t *A) {
+    const ec_curve_consts_t *c = ec_curve_consts_lookup(curve);
+
+    return c && c->g_table &&
+           memcmp(&A->x, &curve->G.x, sizeof(uint256_t)) == 0 &&
+           memcmp(&A->y, &curve->G.y, sizeof(uint256_t)) == 0;
+}
+
+/* Digit i of k in the signed radix-16 recoding used with the generator
+ * table: |d| and its sign, with the carry into digit i + 1 updated. */
+static inline uint64_t BaseDigit(const uint256_t *k, int i, uint64_t *carry, uint64_t *neg) {
+    uint64_t v = *carry;
+    if (i < 64) {
+        v += (k->limb[i >> 4] >> ((i & 15) * 4)) & 0xf;
+    }
+    /* v in [0, 16]; v > 8 becomes v - 16 with a carry into the next digit */
+    *neg = (8 - v) >> 63;
+    *carry = *neg;
+    return v ^ ((v ^ (16 - v)) & ct_mask_u64(*neg));
+}
+
+#ifdef EC_FIELD_5X52
+/* p256_mul_base_const with the accumulator kept on the 5x52
+ * representation; each selected entry is moved into the domain. */
+static void p256_mul_base_5x52(const ec_domain_params_t *curve, const uint256_t *b3,
+                               const uint256_t *k, ec_proj_t *Q_h) {
+    ec_affine_t e;
+    affine52_t e52;
+    proj52_t Q, sum;
+    coef52_t c;
+    uint64_t carry = 0, neg;
+
+    Coef52(curve, b3, &c);
+    memset(&Q, 0, sizeof(Q));
+    Q.y.n[0] = 1;
+
+    for (int i = 0; i < P256_GTABLE_WINDOWS; ++i) {
+        uint64_t abs_val = BaseDigit(k, i, &carry, &neg);
+        uint64_t nonzero = 1 - ct_eq_u64(abs_val, 0);
+
+        ec_table_select((uint64_t *)&e, (const uint64_t *)p256_gtable[i], P256_GTABLE_ENTRIES,
+                        ENTRY_WORDS, abs_val - 1);
+        Affine52FromAffine(&e, &e52);
+        ConditionalNegateAffine52(&e52, neg & nonzero);
+        ec_complete_add_mixed52(&c, &Q, &e52, &sum);
+        CMoveProj52(&Q, &sum, nonzero);
     }
+
+    ProjFromProj52(&Q, Q_h);
+    secure_wipe(&e, sizeof(e));
+    secure_wipe(&e52, sizeof(e52));
+    secure_wipe(&Q, sizeof(Q));
+    secure_wipe(&sum, sizeof(sum));
 }
+#endif
+
+/* Q_h = k * G from the build-time table. k is recoded on the fly into 65
+ * signed radix-16 digits in [-8, 8]; digit i selects a multiple of 16^i G,
+ * so the loop is 65 mixed complete additions and no doublings. Zero digits
+ * read an all-zero entry (index out of range) and discard the sum, as in
+ * AddSignedDigit. */
+static void p256_mul_base_const(const ec_domain_params_t *curve, const uint256_t *k, ec_proj_t *Q_h) {
+    ec_affine_t e;
+    ec_proj_t sum;
+    uint256_t b3;
+    uint64_t carry = 0, neg;
 
+    ComputeB3(curve, &b3);
+#ifdef EC_FIELD_5X52
+    if (p256_is_prime(&curve->p)) {
+        p256_mul_base_5x52(curve, &b3, k, Q_h);
+        return;
+    }
+#endif
+    PointSetIdentity(Q_h);
 
+    for (int i = 0; i < P256_GTABLE_WINDOWS; ++i) {
+        uint64_t abs_val = BaseDigit(k, i, &carry, &neg);
+        uint64_t nonzero = 1 - ct_eq_u64(abs_val, 0);
 
+        ec_table_select((uint64_t *)&e, (const uint64_t *)p256_gtable[i], P256_GTABLE_ENTRIES,
+                        ENTRY_WORDS, abs_val - 1);
+        ConditionalNegateAffine(curve, &e, neg & nonzero);
+        ec_complete_add_mixed(curve, &b3, Q_h, &e, &sum);
+        CMoveProj(Q_h, &sum, nonzero);
+    }
+
+    secure_wipe(&e, sizeof(e));
+}
 
 void ec_jacobian_to_affine(const ec_domain_params_t *curve, const ec_point_t *P, ec_point_t *R) {
 
@@ -271,14 +734,20 @@ void ec_jacobian_to_affine(const ec_domain_params_t *curve, const ec_point_t *P,
         return;
     }
 
+    /* already affine (decoded keys, ladder results): nothing to invert */
+    if (P->z.limb[0] == 1 && (P->z.limb[1] | P->z.limb[2] | P->z.limb[3]) == 0) {
+        if (R != P) *R = *P;
+        return;
+    }
+
     uint256_t z_inv, z_squared, z_cubed = {{0}};
 
     mod_inv(&P->z, &curve->p, &z_inv);
-    mod_mul(&z_inv, &z_inv, &curve->p, &z_squared);
-    mod_mul(&P->x, &z_squared, &curve->p, &R->x);
+    fe_sqr(curve, &z_inv, &z_squared);
+    fe_mul(curve, &P->x, &z_squared, &R->x);
 
-    mod_mul(&z_squared, &z_inv, &curve->p, &z_cubed);
-    mod_mul(&P->y, &z_cubed, &curve->p, &R->y);
+    fe_mul(curve, &z_squared, &z_inv, &z_cubed);
+    fe_mul(curve, &P->y, &z_cubed, &R->y);
 
     memset(&R->z, 0, sizeof(R->z));
     R->z.limb[0] = 1;
@@ -302,183 +771,347 @@ void ec_negate_point(const ec_domain_params_t *curve, const ec_point_t *P, ec_po
 }
 
 
-void ec_double_point(const ec_domain_params_t *curve, const ec_point_t *P, ec_point_t *R) {
-    
-    if (P->infinity || uint256_is_zero(&P->y)) {
-        R->infinity = 1;
-        memset(&R->x, 0, sizeof(R->x));
-        memset(&R->y, 0, sizeof(R->y));
-        memset(&R->z, 0, sizeof(R->z));
-        return;
-    }
+/* Jacobian helpers for ec_double_point / ec_add_point / ec_add_point_mixed.
+ * These are the branchy public formulas (EFD dbl-2001-b, dbl-2007-bl,
+ * add-2007-bl, madd-2007-bl); the constant-time ladder does not use them. */
 
-    
-    if (!uint256_is_zero(&P->z)) {
-        
-        uint256_t S, M = {{0}};
-        uint256_t y_power_x, z_squared, m_squared = {{0}};
-        uint256_t four = {{4, 0, 0, 0}};
-        uint256_t two = {{2, 0, 0, 0}};
-        uint256_t three = {{3, 0, 0, 0}};
-        uint256_t eight = {{8, 0, 0, 0}};
-        uint256_t temp = {{0}};
-
-        mod_mul(&four, &P->x, &curve->p, &S);
-        mod_mul(&P->y, &P->y, &curve->p, &y_power_x);
-        mod_mul(&S, &y_power_x, &curve->p, &S);
-        
-        mod_mul(&P->z, &P->z, &curve->p, &z_squared);
-        mod_sub(&P->x, &z_squared, &curve->p, &temp);
-        mod_mul(&three, &temp, &curve->p, &temp);
-        mod_add(&P->x, &z_squared, &curve->p, &M);
-        mod_mul(&temp, &M, &curve->p, &M);
-
-        mod_mul(&M, &M, &curve->p, &m_squared);
-        mod_mul(&S, &two, &curve->p, &temp);
-        mod_sub(&m_squared, &temp, &curve->p, &R->x);
-        
-        mod_sub(&S, &R->x, &curve->p, &temp);
-        mod_mul(&M, &temp, &curve->p, &temp);
-        mod_mul(&P->y, &P->y, &curve->p, &y_power_x);
-        mod_mul(&P->y, &y_power_x, &curve->p, &y_power_x);
-        mod_mul(&P->y, &y_power_x, &curve->p, &y_power_x);
-        mod_mul(&eight, &y_power_x, &curve->p, &y_power_x);
-        mod_sub(&temp, &y_power_x, &curve->p, &R->y);
-        
-        mod_mul(&two, &P->y, &curve->p, &temp);
-        mod_mul(&temp, &P->z, &curve->p, &R->z);
-        
-        R->infinity = 0;
+static void SetJacobianInfinity(ec_point_t *R) {
+    R->infinity = 1;
+    memset(&R->x, 0, sizeof(R->x));
+    memset(&R->y, 0, sizeof(R->y));
+    memset(&R->z, 0, sizeof(R->z));
+}
 
-        return;
-    }
+static int IsOne(const uint256_t *z) {
+    return z->limb[0] == 1 && (z->limb[1] | z->limb[2] | z->limb[3]) == 0;
+}
 
-    uint256_t three = {{3, 0, 0, 0}};
-    uint256_t two = {{2, 0, 0, 0}};
-    uint256_t x2, y2, prod, sum, lambda;
+static int CurveAIsMinus3(const ec_domain_params_t *curve) {
+    const ec_curve_consts_t *c = ec_curve_consts_lookup(curve);
 
-    // Lambda
-    mod_mul(&P->x, &P->x, &curve->p, &x2);
-    mod_mul(&x2, &three, &curve->p, &prod);
-    mod_add(&prod, &curve->a, &curve->p, &sum);
-    mod_mul(&P->y, &two, &curve->p, &y2);
-    mod_inv(&y2, &curve->p, &y2);
-    mod_mul(&y2, &sum, &curve->p, &lambda);
+    if (c) return c->a_is_minus3;
 
-    ec_calculate_coordinates(curve, &lambda, P, P, R);
-    R->infinity = 0;
+    uint256_t three = {{3, 0, 0, 0}}, pm3;
+    uint256_sub(&curve->p, &three, &pm3);
+    return uint256_cmp(&curve->a, &pm3) == 0;
 }
 
+/* A point with z == 0 that is not flagged infinite is taken as affine
+ * (x, y), which is the convention these functions have always had. */
+static const ec_point_t *AsJacobian(const ec_point_t *P, ec_point_t *tmp) {
+    if (!uint256_is_zero(&P->z)) return P;
+    tmp->x = P->x;
+    tmp->y = P->y;
+    memset(&tmp->z, 0, sizeof(tmp->z));
+    tmp->z.limb[0] = 1;
+    tmp->infinity = 0;
+    return tmp;
+}
 
-void ec_add_point(const ec_domain_params_t *curve, const ec_point_t *P, const ec_point_t *Q, ec_point_t *R) {
+int ec_affine_from_point(const ec_domain_params_t *curve, const ec_point_t *P, ec_affine_t *A) {
+    ec_point_t t;
 
-    /* Note: equality of P and Q cannot be decided by comparing raw Jacobian
-     * coordinates (equal X/Y with different Z are different affine points).
-     * The doubling case is detected below via H == 0 && r == 0. */
+    ec_jacobian_to_affine(curve, P, &t);
+    if (t.infinity) {
+        memset(A, 0, sizeof(*A));
+        return -1;
+    }
+    A->x = t.x;
+    A->y = t.y;
+    return 0;
+}
+
+void ec_affine_to_point(const ec_affine_t *A, ec_point_t *P) {
+    P->x = A->x;
+    P->y = A->y;
+    memset(&P->z, 0, sizeof(P->z));
+    P->z.limb[0] = 1;
+    P->infinity = 0;
+}
+
+/* Jacobian (X, Y, Z) -> homogeneous (XZ : Y : Z^3) */
+void ec_proj_from_point(const ec_domain_params_t *curve, const ec_point_t *P, ec_proj_t *Q) {
+    ec_point_t tmp;
+    uint256_t z2;
 
     if (P->infinity) {
-        *R = *Q;
+        PointSetIdentity(Q);
         return;
     }
-    if (Q->infinity) {
-        *R = *P;
+    P = AsJacobian(P, &tmp);
+    fe_sqr(curve, &P->z, &z2);
+    fe_mul(curve, &P->x, &P->z, &Q->x);
+    Q->y = P->y;
+    fe_mul(curve, &z2, &P->z, &Q->z);
+}
+
+/* homogeneous (X : Y : Z) -> Jacobian (XZ, YZ^2, Z) */
+void ec_proj_to_point(const ec_domain_params_t *curve, const ec_proj_t *Q, ec_point_t *P) {
+    uint256_t z2;
+
+    if (uint256_is_zero(&Q->z)) {
+        SetJacobianInfinity(P);
         return;
     }
+    fe_sqr(curve, &Q->z, &z2);
+    fe_mul(curve, &Q->x, &Q->z, &P->x);
+    fe_mul(curve, &Q->y, &z2, &P->y);
+    P->z = Q->z;
+    P->infinity = 0;
+}
 
-    if (!uint256_is_zero(&P->z) && !uint256_is_zero(&Q->z)) {
-        
-        uint256_t two = {{2, 0, 0, 0}};
-        uint256_t U1, U2 = {{0}};
-        uint256_t S1, S2 = {{0}};
-        uint256_t H = {{0}};
-        uint256_t r = {{0}};
-        
-        uint256_t z_power_x = {{0}};
-        uint256_t h_squared = {{0}};
-        uint256_t h_cubed = {{0}};
-        uint256_t r_squared = {{0}};
-        uint256_t temp, temp2 = {{0}};
-        
-
-        /* P->Z = Z1 and Q->Z = Z2
-         * This Pattern also applies to the X and Y coordinate */
-
-        mod_mul(&Q->z, &Q->z, &curve->p, &z_power_x);
-        mod_mul(&P->x, &z_power_x, &curve->p, &U1);
-        mod_mul(&P->z, &P->z, &curve->p, &z_power_x);
-        mod_mul(&Q->x, &z_power_x, &curve->p, &U2);
-
-        mod_mul(&Q->z, &Q->z, &curve->p, &z_power_x);
-        mod_mul(&Q->z, &z_power_x, &curve->p, &z_power_x);
-        mod_mul(&P->y, &z_power_x, &curve->p, &S1);
-        mod_mul(&P->z, &P->z, &curve->p, &z_power_x);
-        mod_mul(&P->z, &z_power_x, &curve->p, &z_power_x);
-        mod_mul(&Q->y, &z_power_x, &curve->p, &S2);
-
-        mod_sub(&U2, &U1, &curve->p, &H);
-        mod_sub(&S2, &S1, &curve->p, &r);
-
-        if (uint256_is_zero(&H)) {
-            if (uint256_is_zero(&r)) {
-                ec_double_point(curve, P, R);
-            } else {
-                R->infinity = 1;
-                memset(&R->x, 0, sizeof(R->x));
-                memset(&R->y, 0, sizeof(R->y));
-                memset(&R->z, 0, sizeof(R->z));
-            }
-            return;
-        }
+static void JacobianDouble(const ec_domain_params_t *curve, const ec_point_t *P, ec_point_t *R) {
+    const uint256_t *p = &curve->p;
+    uint256_t X3, Y3, Z3, t0, t1, t2, t3;
+
+    if (CurveAIsMinus3(curve)) {
+        /* dbl-2001-b: delta = Z^2, gamma = Y^2, beta = X gamma,
+         * alpha = 3 (X - delta)(X + delta) */
+        uint256_t delta, gamma, beta, alpha;
+        fe_sqr(curve, &P->z, &delta);
+        fe_sqr(curve, &P->y, &gamma);
+        fe_mul(curve, &P->x, &gamma, &beta);
+        mod_sub(&P->x, &delta, p, &t0);
+        mod_add(&P->x, &delta, p, &t1);
+        fe_mul(curve, &t0, &t1, &alpha);
+        mod_add(&alpha, &alpha, p, &t0);
+        mod_add(&t0, &alpha, p, &alpha);
+
+        /* X3 = alpha^2 - 8 beta */
+        mod_add(&beta, &beta, p, &beta);            /* 2 beta */
+        mod_add(&beta, &beta, p, &beta);            /* 4 beta */
+        fe_sqr(curve, &alpha, &X3);
+        mod_sub(&X3, &beta, p, &X3);
+        mod_sub(&X3, &beta, p, &X3);
+
+        /* Z3 = (Y + Z)^2 - gamma - delta */
+        mod_add(&P->y, &P->z, p, &t0);
+        fe_sqr(curve, &t0, &Z3);
+        mod_sub(&Z3, &gamma, p, &Z3);
+        mod_sub(&Z3, &delta, p, &Z3);
+
+        /* Y3 = alpha (4 beta - X3) - 8 gamma^2 */
+        mod_sub(&beta, &X3, p, &t0);
+        fe_mul(curve, &alpha, &t0, &Y3);
+        fe_sqr(curve, &gamma, &t1);
+        mod_add(&t1, &t1, p, &t1);
+        mod_add(&t1, &t1, p, &t1);
+        mod_add(&t1, &t1, p, &t1);
+        mod_sub(&Y3, &t1, p, &Y3);
+    } else {
+        /* dbl-2007-bl */
+        uint256_t XX, YY, YYYY, ZZ, S, M;
+        fe_sqr(curve, &P->x, &XX);
+        fe_sqr(curve, &P->y, &YY);
+        fe_sqr(curve, &YY, &YYYY);
+        fe_sqr(curve, &P->z, &ZZ);
+
+        /* S = 2 ((X + YY)^2 - XX - YYYY) */
+        mod_add(&P->x, &YY, p, &t0);
+        fe_sqr(curve, &t0, &S);
+        mod_sub(&S, &XX, p, &S);
+        mod_sub(&S, &YYYY, p, &S);
+        mod_add(&S, &S, p, &S);
+
+        /* M = 3 XX + a ZZ^2 */
+        fe_sqr(curve, &ZZ, &t0);
+        fe_mul(curve, &curve->a, &t0, &t1);
+        mod_add(&XX, &XX, p, &M);
+        mod_add(&M, &XX, p, &M);
+        mod_add(&M, &t1, p, &M);
+
+        /* X3 = M^2 - 2 S */
+        fe_sqr(curve, &M, &X3);
+        mod_sub(&X3, &S, p, &X3);
+        mod_sub(&X3, &S, p, &X3);
+
+        /* Y3 = M (S - X3) - 8 YYYY */
+        mod_sub(&S, &X3, p, &t0);
+        fe_mul(curve, &M, &t0, &Y3);
+        mod_add(&YYYY, &YYYY, p, &t2);
+        mod_add(&t2, &t2, p, &t2);
+        mod_add(&t2, &t2, p, &t2);
+        mod_sub(&Y3, &t2, p, &Y3);
+
+        /* Z3 = (Y + Z)^2 - YY - ZZ */
+        mod_add(&P->y, &P->z, p, &t3);
+        fe_sqr(curve, &t3, &Z3);
+        mod_sub(&Z3, &YY, p, &Z3);
+        mod_sub(&Z3, &ZZ, p, &Z3);
+    }
 
-        mod_mul(&H, &H, &curve->p, &h_squared);
-        mod_mul(&h_squared, &U1, &curve->p, &temp);
-        mod_mul(&temp, &two, &curve->p, &temp);
-        mod_mul(&H, &H, &curve->p, &h_cubed);
-        mod_mul(&H, &h_cubed, &curve->p, &h_cubed);
-        mod_mul(&r, &r, &curve->p, &r_squared);
-        mod_sub(&r_squared, &h_cubed, &curve->p, &r_squared);
-        mod_sub(&r_squared, &temp, &curve->p, &R->x);
-
-        mod_mul(&U1, &h_squared, &curve->p, &temp);
-        mod_sub(&temp, &R->x, &curve->p, &temp);
-        mod_mul(&r, &temp, &curve->p, &temp);
-        mod_mul(&S1, &h_cubed, &curve->p, &temp2);
-        mod_sub(&temp, &temp2, &curve->p, &R->y);
-
-        mod_mul(&P->z, &Q->z, &curve->p, &temp);
-        mod_mul(&temp, &H, &curve->p, &R->z);
-        
-        R->infinity = 0;
+    R->x = X3;
+    R->y = Y3;
+    R->z = Z3;
+    R->infinity = 0;
+}
 
+/* madd-2007-bl: P Jacobian, Q affine (Q->z not read). */
+static void JacobianAddMixed(const ec_domain_params_t *curve, const ec_point_t *P,
+                             const ec_point_t *Q, ec_point_t *R) {
+    const uint256_t *p = &curve->p;
+    uint256_t Z1Z1, U2, S2, H, HH, I, J, r, V, X3, Y3, Z3, t0;
+
+    fe_sqr(curve, &P->z, &Z1Z1);
+    fe_mul(curve, &Q->x, &Z1Z1, &U2);
+    fe_mul(curve, &P->z, &Z1Z1, &t0);
+    fe_mul(curve, &Q->y, &t0, &S2);
+    mod_sub(&U2, &P->x, p, &H);
+    mod_sub(&S2, &P->y, p, &r);
+
+    if (uint256_is_zero(&H)) {
+        if (uint256_is_zero(&r)) {
+            JacobianDouble(curve, P, R);
+        } else {
+            SetJacobianInfinity(R);
+        }
         return;
     }
 
-    uint256_t lambda;
-    uint256_t delta_y, delta_x;
+    mod_add(&r, &r, p, &r);                        /* r = 2 (S2 - Y1) */
+    fe_sqr(curve, &H, &HH);
+    mod_add(&HH, &HH, p, &I);
+    mod_add(&I, &I, p, &I);                        /* I = 4 HH */
+    fe_mul(curve, &H, &I, &J);
+    fe_mul(curve, &P->x, &I, &V);
+
+    /* X3 = r^2 - J - 2 V */
+    fe_sqr(curve, &r, &X3);
+    mod_sub(&X3, &J, p, &X3);
+    mod_sub(&X3, &V, p, &X3);
+    mod_sub(&X3, &V, p, &X3);
+
+    /* Y3 = r (V - X3) - 2 Y1 J */
+    mod_sub(&V, &X3, p, &t0);
+    fe_mul(curve, &r, &t0, &Y3);
+    fe_mul(curve, &P->y, &J, &t0);
+    mod_sub(&Y3, &t0, p, &Y3);
+    mod_sub(&Y3, &t0, p, &Y3);
+
+    /* Z3 = (Z1 + H)^2 - Z1Z1 - HH */
+    mod_add(&P->z, &H, p, &t0);
+    fe_sqr(curve, &t0, &Z3);
+    mod_sub(&Z3, &Z1Z1, p, &Z3);
+    mod_sub(&Z3, &HH, p, &Z3);
 
-    // Calculate Lambda
-    mod_sub(&Q->y, &P->y, &curve->p, &delta_y);
-    mod_sub(&Q->x, &P->x, &curve->p, &delta_x);
+    R->x = X3;
+    R->y = Y3;
+    R->z = Z3;
+    R->infinity = 0;
+}
 
-    if (uint256_is_zero(&delta_x)) {
-        if (uint256_is_zero(&delta_y)) {
-            ec_double_point(curve, P, R);
+/* add-2007-bl: both inputs Jacobian. */
+static void JacobianAdd(const ec_domain_params_t *curve, const ec_point_t *P,
+                        const ec_point_t *Q, ec_point_t *R) {
+    const uint256_t *p = &curve->p;
+    uint256_t Z1Z1, Z2Z2, U1, U2, S1, S2, H, I, J, r, V, X3, Y3, Z3, t0;
+
+    fe_sqr(curve, &P->z, &Z1Z1);
+    fe_sqr(curve, &Q->z, &Z2Z2);
+    fe_mul(curve, &P->x, &Z2Z2, &U1);
+    fe_mul(curve, &Q->x, &Z1Z1, &U2);
+    fe_mul(curve, &Q->z, &Z2Z2, &t0);
+    fe_mul(curve, &P->y, &t0, &S1);
+    fe_mul(curve, &P->z, &Z1Z1, &t0);
+    fe_mul(curve, &Q->y, &t0, &S2);
+    mod_sub(&U2, &U1, p, &H);
+    mod_sub(&S2, &S1, p, &r);
+
+    /* equal x: P == Q needs the doubling formula, P == -Q gives O */
+    if (uint256_is_zero(&H)) {
+        if (uint256_is_zero(&r)) {
+            JacobianDouble(curve, P, R);
         } else {
-            R->infinity = 1;
-            memset(&R->x, 0, sizeof(R->x));
-            memset(&R->y, 0, sizeof(R->y));
-            memset(&R->z, 0, sizeof(R->z));
+            SetJacobianInfinity(R);
         }
         return;
     }
 
-    mod_inv(&delta_x, &curve->p, &delta_x);
-    mod_mul(&delta_y, &delta_x, &curve->p, &lambda);
+    mod_add(&r, &r, p, &r);                        /* r = 2 (S2 - S1) */
+    mod_add(&H, &H, p, &t0);
+    fe_sqr(curve, &t0, &I);                        /* I = (2H)^2 */
+    fe_mul(curve, &H, &I, &J);
+    fe_mul(curve, &U1, &I, &V);
+
+    /* X3 = r^2 - J - 2 V */
+    fe_sqr(curve, &r, &X3);
+    mod_sub(&X3, &J, p, &X3);
+    mod_sub(&X3, &V, p, &X3);
+    mod_sub(&X3, &V, p, &X3);
+
+    /* Y3 = r (V - X3) - 2 S1 J */
+    mod_sub(&V, &X3, p, &t0);
+    fe_mul(curve, &r, &t0, &Y3);
+    fe_mul(curve, &S1, &J, &t0);
+    mod_sub(&Y3, &t0, p, &Y3);
+    mod_sub(&Y3, &t0, p, &Y3);
+
+    /* Z3 = ((Z1 + Z2)^2 - Z1Z1 - Z2Z2) H */
+    mod_add(&P->z, &Q->z, p, &t0);
+    fe_sqr(curve, &t0, &Z3);
+    mod_sub(&Z3, &Z1Z1, p, &Z3);
+    mod_sub(&Z3, &Z2Z2, p, &Z3);
+    fe_mul(curve, &Z3, &H, &Z3);
 
-    ec_calculate_coordinates(curve, &lambda, P, Q, R);
+    R->x = X3;
+    R->y = Y3;
+    R->z = Z3;
     R->infinity = 0;
 }
 
+void ec_double_point(const ec_domain_params_t *curve, const ec_point_t *P, ec_point_t *R) {
+    ec_point_t tmp;
+
+    if (P->infinity || uint256_is_zero(&P->y)) {
+        SetJacobianInfinity(R);
+        return;
+    }
+    JacobianDouble(curve, AsJacobian(P, &tmp), R);
+}
+
+void ec_add_point(const ec_domain_params_t *curve, const ec_point_t *P, const ec_point_t *Q, ec_point_t *R) {
+    ec_point_t tp, tq;
+
+    if (P->infinity) {
+        *R = *Q;
+        return;
+    }
+    if (Q->infinity) {
+        *R = *P;
+        return;
+    }
+
+    P = AsJacobian(P, &tp);
+    Q = AsJacobian(Q, &tq);
+
+    /* one affine operand: the cheaper mixed formula */
+    if (IsOne(&Q->z)) {
+        JacobianAddMixed(curve, P, Q, R);
+    } else if (IsOne(&P->z)) {
+        JacobianAddMixed(curve, Q, P, R);
+    } else {
+        JacobianAdd(curve, P, Q, R);
+    }
+}
+
+void ec_add_point_mixed(const ec_domain_params_t *curve, const ec_point_t *P, const ec_point_t *Q, ec_point_t *R) {
+    ec_point_t tp;
+
+    if (Q->infinity) {
+        *R = *P;
+        return;
+    }
+    if (P->infinity) {
+        R->x = Q->x;
+        R->y = Q->y;
+        memset(&R->z, 0, sizeof(R->z));
+        R->z.limb[0] = 1;
+        R->infinity = 0;
+        return;
+    }
+    JacobianAddMixed(curve, AsJacobian(P, &tp), Q, R);
+}
+
 int ec_point_on_curve(const ec_domain_params_t *curve, const ec_point_t *P) {
     if (P->infinity) return 1;
     uint256_t y2, x3, ax, rhs = {{0}};
@@ -487,20 +1120,19 @@ int ec_point_on_curve(const ec_domain_params_t *curve, const ec_point_t *P) {
      * Calculate y2 = x3 + axz4 + bz6 (mod p) for jacobian projective coords
      * Returns 0 if the point lies on the curve */
     
-    if (!uint256_is_zero(&P->z)) {
-        
+    if (!uint256_is_zero(&P->z) && !IsOne(&P->z)) {
 
         uint256_t z2, z4, z6, bz6 = {{0}};
 
-        mod_mul(&P->y, &P->y, &curve->p, &y2);
-        mod_mul(&P->x, &P->x, &curve->p, &x3);
-        mod_mul(&P->x, &x3, &curve->p, &x3);
-        mod_mul(&curve->a, &P->x, &curve->p, &ax);
-        mod_mul(&P->z, &P->z, &curve->p, &z2);
-        mod_mul(&z2, &z2, &curve->p, &z4);
-        mod_mul(&z4, &z2, &curve->p, &z6);
-        mod_mul(&ax, &z4, &curve->p, &ax);
-        mod_mul(&curve->b, &z6, &curve->p, &bz6);
+        fe_sqr(curve, &P->y, &y2);
+        fe_sqr(curve, &P->x, &x3);
+        fe_mul(curve, &P->x, &x3, &x3);
+        fe_mul(curve, &curve->a, &P->x, &ax);
+        fe_sqr(curve, &P->z, &z2);
+        fe_sqr(curve, &z2, &z4);
+        fe_mul(curve, &z4, &z2, &z6);
+        fe_mul(curve, &ax, &z4, &ax);
+        fe_mul(curve, &curve->b, &z6, &bz6);
         mod_add(&x3, &ax, &curve->p, &rhs);
         mod_add(&rhs, &bz6, &curve->p, &rhs);
 
@@ -508,16 +1140,209 @@ int ec_point_on_curve(const ec_domain_params_t *curve, const ec_point_t *P) {
     }
 
 
-    mod_mul(&P->y, &P->y, &curve->p, &y2);
-    mod_mul(&P->x, &P->x, &curve->p, &x3);
-    mod_mul(&P->x, &x3, &curve->p, &x3);
-    mod_mul(&curve->a, &P->x, &curve->p, &ax);
+    fe_sqr(curve, &P->y, &y2);
+    fe_sqr(curve, &P->x, &x3);
+    fe_mul(curve, &P->x, &x3, &x3);
+    fe_mul(curve, &curve->a, &P->x, &ax);
     mod_add(&x3, &ax, &curve->p, &rhs);
     mod_add(&rhs, &curve->b, &curve->p, &rhs);
 
     return (uint256_cmp(&rhs, &y2) == 0);
 }
 
+/* Jacobi symbol (a | m) for odd m, binary algorithm. Variable time:
+ * only ever called on public data (peer x coordinates). */
+static int jacobi_vartime(const uint256_t *a_in, const uint256_t *m_in) {
+    uint256_t a = *a_in, m = *m_in, t;
+    int sign = 1;
+
+    while (!uint256_is_zero(&a)) {
+        while ((a.limb[0] & 1) == 0) {
+            uint256_rshift1(&a);
+            uint64_t m8 = m.limb[0] & 7;
+            if (m8 == 3 || m8 == 5) sign = -sign;
+        }
+        if (uint256_cmp(&a, &m) < 0) {
+            t = a; a = m; m = t;
+            if ((a.limb[0] & 3) == 3 && (m.limb[0] & 3) == 3) sign = -sign;
+        }
+        uint256_sub(&a, &m, &a); /* both odd, a >= m: result is even */
+    }
+
+    return (m.limb[0] == 1 && (m.limb[1] | m.limb[2] | m.limb[3]) == 0) ? sign : 0;
+}
+
+int ec_x_on_curve(const ec_domain_params_t *curve, const uint256_t *x) {
+
+    /* x is the abscissa of a curve point iff x^3 + ax + b is a nonzero
+     * square mod p. Zero is rejected too: y == 0 would be a point of
+     * order 2, which a prime-order curve does not have. Checking this is
+     * what keeps an x-only ladder from being fed a point on the twist. */
+
+    uint256_t x2, x3, ax, rhs;
+
+    if (uint256_cmp(x, &curve->p) >= 0) return 0;
+
+    fe_sqr(curve, x, &x2);
+    fe_mul(curve, x, &x2, &x3);
+    fe_mul(curve, &curve->a, x, &ax);
+    mod_add(&x3, &ax, &curve->p, &rhs);
+    mod_add(&rhs, &curve->b, &curve->p, &rhs);
+
+    return jacobi_vartime(&rhs, &curve->p) == 1;
+}
+
+/* x-only arithmetic on (X : Z) with x = X/Z (Brier-Joye, PKC 2002).
+ * The identity is (X : 0) for any X != 0; both formulas map it to the
+ * right result, which the ladder relies on for k close to n. */
+
+/* X3 = 2(X1Z2 + X2Z1)(X1X2 + aZ1Z2) + 4b(Z1Z2)^2 - xD(X1Z2 - X2Z1)^2
+ * Z3 = (X1Z2 - X2Z1)^2,  where xD = x(P2 - P1) is affine. */
+static void ec_xadd(const ec_domain_params_t *curve, const uint256_t *b4, const uint256_t *xD,
+                    const uint256_t *X1, const uint256_t *Z1,
+                    const uint256_t *X2, const uint256_t *Z2,
+                    uint256_t *X3, uint256_t *Z3) {
+    const uint256_t *prime = &curve->p;
+    uint256_t t0, t1, t2, t3, t4;
+
+    fe_mul(curve, X1, Z2, &t0);
+    fe_mul(curve, X2, Z1, &t1);
+    fe_mul(curve, X1, X2, &t2);
+    fe_mul(curve, Z1, Z2, &t3);
+    mod_add(&t0, &t1, prime, &t4);          /* X1Z2 + X2Z1 */
+    mod_sub(&t0, &t1, prime, &t0);          /* X1Z2 - X2Z1 */
+    fe_mul(curve, &curve->a, &t3, &t1);
+    mod_add(&t2, &t1, prime, &t2);          /* X1X2 + aZ1Z2 */
+    fe_mul(curve, &t4, &t2, &t4);
+    mod_add(&t4, &t4, prime, &t4);
+    fe_sqr(curve, &t3, &t3);
+    fe_mul(curve, b4, &t3, &t3);
+    mod_add(&t4, &t3, prime, &t4);
+    fe_sqr(curve, &t0, &t0);
+    fe_mul(curve, xD, &t0, &t1);
+    mod_sub(&t4, &t1, prime, X3);
+    *Z3 = t0;
+}
+
+/* X3 = (X^2 - aZ^2)^2 - 8bXZ^3
+ * Z3 = 4Z(X^3 + aXZ^2 + bZ^3) */
+static void ec_xdbl(const ec_domain_params_t *curve, const uint256_t *b4,
+                    const uint256_t *X, const uint256_t *Z,
+                    uint256_t *X3, uint256_t *Z3) {
+    const uint256_t *prime = &curve->p;
+    uint256_t xx, zz, t0, t1, t2, t3;
+
+    fe_sqr(curve, X, &xx);
+    fe_sqr(curve, Z, &zz);
+    fe_mul(curve, &curve->a, &zz, &t0);    /* aZ^2 */
+    mod_sub(&xx, &t0, prime, &t1);
+    fe_sqr(curve, &t1, &t1);          /* (X^2 - aZ^2)^2 */
+    fe_mul(curve, &zz, Z, &t2);            /* Z^3 */
+    fe_mul(curve, X, &t2, &t3);
+    fe_mul(curve, b4, &t3, &t3);
+    mod_add(&t3, &t3, prime, &t3);          /* 8bXZ^3 */
+    mod_sub(&t1, &t3, prime, &t1);
+    mod_add(&xx, &t0, prime, &t0);
+    fe_mul(curve, X, &t0, &t0);            /* X^3 + aXZ^2 */
+    mod_add(&t0, &t0, prime, &t0);
+    mod_add(&t0, &t0, prime, &t0);
+    fe_mul(curve, b4, &t2, &t2);           /* 4bZ^3 */
+    mod_add(&t0, &t2, prime, &t0);
+    fe_mul(curve, Z, &t0, Z3);
+    *X3 = t1;
+}
+
+static void CSwapU256(uint256_t *a, uint256_t *b, uint64_t sel) {
+    uint64_t mask = ct_mask_u64(sel);
+    for (int i = 0; i < 4; ++i) {
+        uint64_t t = (a->limb[i] ^ b->limb[i]) & mask;
+        a->limb[i] ^= t;
+        b->limb[i] ^= t;
+    }
+}
+
+/* r = a + b over five limbs (a, b < 2^257 fit comfortably). */
+static void add_u320(const uint64_t a[5], const uint64_t b[5], uint64_t r[5]) {
+    uint64_t carry = 0;
+    for (int i = 0; i < 5; ++i) {
+        uint64_t s = a[i] + carry;
+        uint64_t c1 = s < carry;
+        r[i] = s + b[i];
+        carry = c1 | (r[i] < s);
+    }
+}
+
+int ec_scalar_multiply_x(const ec_domain_params_t *curve, const uint256_t *k,
+                         const uint256_t *x, uint256_t *x_out) {
+
+    /* Montgomery ladder on x-only coordinates. The scalar is first
+     * replaced by k + n or k + 2n (whichever has bit t set, t being the
+     * bit length of n), which is the same multiple of P but has a fixed,
+     * public length; the ladder then always runs t iterations starting
+     * from (P, 2P), with a branch-free conditional swap per bit. */
+
+    uint64_t kn[5], k2n[5], kk[5], nn[5];
+    uint256_t b4, X0, Z0, X1, Z1, tX, tZ, z_inv;
+    uint64_t swap = 0;
+    int t = 256;
+
+    if (uint256_is_zero(k) || uint256_cmp(k, &curve->n) >= 0) {
+        return -1;
+    }
+
+    while (t > 1 && ((curve->n.limb[(t - 1) >> 6] >> ((t - 1) & 63)) & 1) == 0) {
+        t--;
+    }
+
+    for (int i = 0; i < 4; ++i) { kk[i] = k->limb[i]; nn[i] = curve->n.limb[i]; }
+    kk[4] = 0; nn[4] = 0;
+    add_u320(kk, nn, kn);
+    add_u320(kn, nn, k2n);
+
+    uint64_t use_kn = ct_mask_u64((kn[t >> 6] >> (t & 63)) & 1);
+    for (int i = 0; i < 5; ++i) {
+        kk[i] = (kn[i] & use_kn) | (k2n[i] & ~use_kn);
+    }
+
+    mod_add(&curve->b, &curve->b, &curve->p, &b4);
+    mod_add(&b4, &b4, &curve->p, &b4);
+
+    X0 = *x;
+    memset(&Z0, 0, sizeof(Z0)); Z0.limb[0] = 1;
+    ec_xdbl(curve, &b4, &X0, &Z0, &X1, &Z1);
+
+    for (int i = t - 1; i >= 0; --i) {
+        uint64_t bit = (kk[i >> 6] >> (i & 63)) & 1;
+        swap ^= bit;
+        CSwapU256(&X0, &X1, swap);
+        CSwapU256(&Z0, &Z1, swap);
+        swap = bit;
+
+        ec_xadd(curve, &b4, x, &X0, &Z0, &X1, &Z1, &tX, &tZ);
+        X1 = tX; Z1 = tZ;
+        ec_xdbl(curve, &b4, &X0, &Z0, &tX, &tZ);
+        X0 = tX; Z0 = tZ;
+    }
+    CSwapU256(&X0, &X1, swap);
+    CSwapU256(&Z0, &Z1, swap);
+
+    secure_wipe(kk, sizeof(kk));
+    secure_wipe(kn, sizeof(kn));
+    secure_wipe(k2n, sizeof(k2n));
+
+    if (uint256_is_zero(&Z0)) {
+        return -1;
+    }
+
+    mod_inv(&Z0, &curve->p, &z_inv);
+    fe_mul(curve, &X0, &z_inv, x_out);
+
+    secure_wipe(&X1, sizeof(X1));
+    secure_wipe(&Z1, sizeof(Z1));
+
+    return 0;
+}
+
 void ec_scalar_multiply(const ec_domain_params_t *curve, const uint256_t *k, const ec_point_t *P, ec_point_t *R) {
 
     /* Fixed-length wNAF ladder built on complete addition formulas.
@@ -525,21 +1350,22 @@ void ec_scalar_multiply(const ec_domain_params_t *curve, const uint256_t *k, con
      * the result is returned in affine form (z == 1). */
 
     uint256_t d[L];
-    ec_point_t A, Q;
+    ec_affine_t A;
+    ec_proj_t Q;
 
-    ec_jacobian_to_affine(curve, P, &A);
-
-    if (A.infinity) {
+    if (ec_affine_from_point(curve, P, &A) < 0) {
         /* k * O == O */
         memset(R, 0, sizeof(*R));
         R->infinity = 1;
         return;
     }
 
-    /* affine (x, y) -> homogeneous (x : y : 1); A.z is already 1 */
-
-    ec_wnaf_encode_const(k, d);
-    wnaf_mul_const(curve, &A, d, &Q);
+    if (IsP256Generator(curve, &A)) {
+        p256_mul_base_const(curve, k, &Q);
+    } else {
+        ec_wnaf_encode_const(k, d);
+        wnaf_mul_const(curve, &A, d, &Q);
+    }
 
     /* homogeneous -> affine: (X : Y : Z) -> (X/Z, Y/Z); Z == 0 is the identity */
     if (uint256_is_zero(&Q.z)) {
@@ -550,9 +1376,444 @@ void ec_scalar_multiply(const ec_domain_params_t *curve, const uint256_t *k, con
 
     uint256_t z_inv;
     mod_inv(&Q.z, &curve->p, &z_inv);
-    mod_mul(&Q.x, &z_inv, &curve->p, &R->x);
-    mod_mul(&Q.y, &z_inv, &curve->p, &R->y);
+    fe_mul(curve, &Q.x, &z_inv, &R->x);
+    fe_mul(curve, &Q.y, &z_inv, &R->y);
     memset(&R->z, 0, sizeof(R->z));
     R->z.limb[0] = 1;
     R->infinity = 0;
 }
+
+/* Width-W NAF of k, least significant digit first: every nonzero digit
+ * is odd with |d| < 2^(W-1) and is followed by at least W-1 zeros.
+ * Returns the number of digits, 0 for k == 0. Variable time. */
+static int wnaf_encode_vartime(const uint256_t *k, int8_t *d /* L */) {
+    uint64_t v[5] = { k->limb[0], k->limb[1], k->limb[2], k->limb[3], 0 };
+    int len = 0;
+
+    while (v[0] | v[1] | v[2] | v[3] | v[4]) {
+        int64_t di = 0;
+
+        if (v[0] & 1) {
+            di = (int64_t)(v[0] & ((1u << W) - 1));
+            if (di >= (1 << (W - 1))) di -= (1 << W);
+
+            /* v -= di; only the low limb can start a carry or borrow */
+            uint64_t old = v[0];
+            v[0] -= (uint64_t)di;
+            if (di > 0 && v[0] > old) {
+                for (int i = 1; i < 5 && v[i]-- == 0; i++) {}
+            } else if (di < 0 && v[0] < old) {
+                for (int i = 1; i < 5 && ++v[i] == 0; i++) {}
+            }
+        }
+        d[len++] = (int8_t)di;
+
+        for (int i = 0; i < 4; i++) v[i] = (v[i] >> 1) | (v[i + 1] << 63);
+        v[4] >>= 1;
+    }
+    return len;
+}
+
+void ec_scalar_multiply_vartime(const ec_domain_params_t *curve, const uint256_t *k,
+                                const ec_point_t *P, ec_point_t *R) {
+    ec_affine_t T[TABLE_SIZE], A;
+    ec_point_t Q, S, tmp;
+    uint256_t b3;
+    int8_t d[L];
+    int len;
+
+    len = wnaf_encode_vartime(k, d);
+
+    if (ec_affine_from_point(curve, P, &A) < 0 || len == 0) {
+        memset(R, 0, sizeof(*R));
+        R->infinity = 1;
+        return;
+    }
+
+    if (IsP256Generator(curve, &A)) {
+        /* 65 additions beat ~256 doublings even at constant time */
+        ec_proj_t Qh;
+        p256_mul_base_const(curve, k, &Qh);
+        ec_proj_to_point(curve, &Qh, &Q);
+        ec_jacobian_to_affine(curve, &Q, R);
+        return;
+    }
+
+    ComputeB3(curve, &b3);
+    PrecomputeTable(curve, &b3, &A, T);
+
+    memset(&Q, 0, sizeof(Q));
+    Q.infinity = 1;
+    memset(&S.z, 0, sizeof(S.z));
+    S.z.limb[0] = 1;
+    S.infinity = 0;
+
+    for (int i = len - 1; i >= 0; --i) {
+        if (!Q.infinity) {
+            ec_double_point(curve, &Q, &tmp);
+            Q = tmp;
+        }
+        if (d[i] == 0) continue;
+
+        const ec_affine_t *e = &T[(d[i] < 0 ? -d[i] : d[i]) >> 1];
+        S.x = e->x;
+        S.y = e->y;
+        if (d[i] < 0) {
+            mod_sub(&curve->p, &S.y, &curve->p, &S.y);
+        }
+        ec_add_point_mixed(curve, &Q, &S, &tmp);
+        Q = tmp;
+    }
+
+    ec_jacobian_to_affine(curve, &Q, R);
+}
+
+/* Tables for m points at once: the multiples of up to BATCH_CHUNK /
+ * TABLE_SIZE points share one inversion, rather than one per point. */
+static void PrecomputeTables(const ec_domain_params_t *curve, const uint256_t *b3,
+                             const ec_affine_t *const *P, ec_affine_t *T, size_t m) {
+    const size_t per_inv = BATCH_CHUNK / TABLE_SIZE;
+    ec_proj_t mult[BATCH_CHUNK], twoP;
+
+    for (size_t base = 0; base < m; base += per_inv) {
+        size_t cnt = (m - base < per_inv) ? m - base : per_inv;
+
+        for (size_t i = 0; i < cnt; ++i) {
+            ec_proj_t *M = &mult[i * TABLE_SIZE];
+            ProjFromAffine(P[base + i], &M[0]);
+            ec_complete_add_mixed(curve, b3, &M[0], P[base + i], &twoP);
+            for (int j = 1; j < TABLE_SIZE; ++j) {
+                ec_complete_add(curve, b3, &M[j - 1], &twoP, &M[j]);
+            }
+        }
+        ProjBatchToAffine(curve, mult, T + base * TABLE_SIZE, cnt * TABLE_SIZE);
+    }
+}
+
+/* *Q[i] = k[i] * P[i] for m <= ec_lanes_width() affine points on a curve
+ * over the P-256 prime, one SIMD lane each (ec_lanes.h). Unused lanes
+ * repeat lane 0 and their results are dropped. */
+static void wnaf_mul_lanes(const ec_domain_params_t *curve, const ec_affine_t *const *P,
+                           const uint256_t *const *k, ec_proj_t *const *Q, size_t m) {
+    ec_affine_t T[EC_LANES_MAX * TABLE_SIZE];
+    uint8_t digits[EC_LANES_MAX * L];
+    ec_proj_t out[EC_LANES_MAX];
+    uint256_t d[L], b3;
+    size_t w = ec_lanes_width();
+
+    ComputeB3(curve, &b3);
+    PrecomputeTables(curve, &b3, P, T, m);
+    for (size_t i = 0; i < m; ++i) {
+        ec_wnaf_encode_const(k[i], d);
+        for (int idx = 0; idx < L; ++idx) {
+            digits[i * L + idx] = EC_LANES_DIGIT(d[idx].limb[0], d[idx].limb[1] & 1);
+        }
+    }
+    for (size_t i = m; i < w; ++i) {
+        memcpy(&T[i * TABLE_SIZE], T, TABLE_SIZE * sizeof(ec_affine_t));
+        memcpy(&digits[i * L], digits, L);
+    }
+
+    ec_lanes_ladder(&curve->a, &b3, T, digits, out);
+    for (size_t i = 0; i < m; ++i) *Q[i] = out[i];
+
+    secure_wipe(d, sizeof(d));
+    secure_wipe(digits, sizeof(digits));
+    secure_wipe(out, sizeof(out));
+}
+
+void ec_scalar_multiply_batch(const ec_domain_params_t *curve, const uint256_t *k,
+                              const ec_point_t *P, ec_point_t *R, size_t n) {
+
+    /* Same constant-time ladder as ec_scalar_multiply for every entry, but
+     * the final homogeneous -> affine step is shared: BATCH_CHUNK results
+     * are normalized with one inversion instead of one each. Inputs that
+     * are already affine (z == 1) skip their initial conversion. On the
+     * P-256 prime, ladders for points other than G run ec_lanes_width()
+     * at a time in SIMD lanes when the CPU has a lane backend. */
+
+    uint256_t d[L];
+    ec_proj_t Q[BATCH_CHUNK];
+    ec_affine_t out[BATCH_CHUNK], A[BATCH_CHUNK];
+    const ec_affine_t *lane_P[EC_LANES_MAX];
+    const uint256_t *lane_k[EC_LANES_MAX];
+    ec_proj_t *lane_Q[EC_LANES_MAX];
+    size_t w = p256_is_prime(&curve->p) ? ec_lanes_width() : 0;
+
+    for (size_t base = 0; base < n; base += BATCH_CHUNK) {
+        size_t m = (n - base < BATCH_CHUNK) ? n - base : BATCH_CHUNK;
+        size_t queued = 0;
+
+        for (size_t i = 0; i < m; ++i) {
+            const ec_point_t *Pi = &P[base + i];
+
+            if (Pi->z.limb[0] == 1 && (Pi->z.limb[1] | Pi->z.limb[2] | Pi->z.limb[3]) == 0 &&
+                !Pi->infinity) {
+                A[i].x = Pi->x;
+                A[i].y = Pi->y;
+            } else if (ec_affine_from_point(curve, Pi, &A[i]) < 0) {
+                PointSetIdentity(&Q[i]);
+                continue;
+            }
+
+            if (IsP256Generator(curve, &A[i])) {
+                p256_mul_base_const(curve, &k[base + i], &Q[i]);
+            } else if (w) {
+                lane_P[queued] = &A[i];
+                lane_k[queued] = &k[base + i];
+                lane_Q[queued] = &Q[i];
+                if (++queued == w) {
+                    wnaf_mul_lanes(curve, lane_P, lane_k, lane_Q, queued);
+                    queued = 0;
+                }
+            } else {
+                ec_wnaf_encode_const(&k[base + i], d);
+                wnaf_mul_const(curve, &A[i], d, &Q[i]);
+            }
+        }
+
+        /* a partial group costs as much as a full one, so it only goes to
+         * the lanes when at least half full */
+        if (queued * 2 >= w && queued) {
+            wnaf_mul_lanes(curve, lane_P, lane_k, lane_Q, queued);
+        } else {
+            for (size_t i = 0; i < queued; ++i) {
+                ec_wnaf_encode_const(lane_k[i], d);
+                wnaf_mul_const(curve, lane_P[i], d, lane_Q[i]);
+            }
+        }
+
+        ProjBatchToAffine(curve, Q, out, m);
+        for (size_t i = 0; i < m; ++i) {
+            if (uint256_is_zero(&Q[i].z)) {
+                memset(&R[base + i], 0, sizeof(R[base + i]));
+                R[base + i].infinity = 1;
+            } else {
+                ec_affine_to_point(&out[i], &R[base + i]);
+            }
+        }
+    }
+
+    secure_wipe(d, sizeof(d));
+}
+
+/* ── projective in, projective out ── */
+
+void ec_scalar_multiply_proj(const ec_domain_params_t *curve, const uint256_t *k,
+                             const ec_proj_t *P, ec_proj_t *R) {
+
+    /* The ladder of ec_scalar_multiply without either end's inversion:
+     * P goes into the table unnormalized and R stays homogeneous. */
+
+    ec_affine_t T[TABLE_SIZE];
+    uint256_t d[L], b3;
+
+    if (uint256_is_zero(&P->z)) {
+        PointSetIdentity(R);
+        return;
+    }
+
+    if (IsOne(&P->z)) {
+        ec_affine_t A = { P->x, P->y };
+        if (IsP256Generator(curve, &A)) {
+            p256_mul_base_const(curve, k, R);
+            return;
+        }
+    }
+
+    ComputeB3(curve, &b3);
+    PrecomputeTableProj(curve, &b3, P, T);
+    ec_wnaf_encode_const(k, d);
+    wnaf_ladder(curve, &b3, T, d, R); /* P is no longer read, so R may alias it */
+
+    secure_wipe(d, sizeof(d));
+}
+
+void ec_add_proj(const ec_domain_params_t *curve, const ec_proj_t *P, const ec_proj_t *Q, ec_proj_t *R) {
+    uint256_t b3;
+    ComputeB3(curve, &b3);
+    ec_complete_add(curve, &b3, P, Q, R);
+}
+
+void ec_add_proj_mixed(const ec_domain_params_t *curve, const ec_proj_t *P, const ec_affine_t *Q,
+                       ec_proj_t *R) {
+    uint256_t b3;
+    ComputeB3(curve, &b3);
+    ec_complete_add_mixed(curve, &b3, P, Q, R);
+}
+
+void ec_proj_from_affine(const ec_affine_t *A, ec_proj_t *P) {
+    ProjFromAffine(A, P);
+}
+
+int ec_proj_to_affine(const ec_domain_params_t *curve, const ec_proj_t *P, ec_affine_t *A) {
+    if (uint256_is_zero(&P->z)) {
+        memset(A, 0, sizeof(*A));
+        return -1;
+    }
+    ProjBatchToAffine(curve, P, A, 1);
+    return 0;
+}
+
+/* ── multi-scalar multiplication ── */
+
+/* Points per Straus pass: digit and table storage for a pass lives on
+ * the stack (about 9 KB at 16). */
+#define MSM_STRAUS_MAX 16
+/* Largest Pippenger window; 2^c - 1 Jacobian buckets on the stack. */
+#define MSM_PIPPENGER_MAX_C 7
+
+static void SetInfinity(ec_point_t *R) {
+    memset(R, 0, sizeof(*R));
+    R->infinity = 1;
+}
+
+static void AddJacobian(const ec_domain_params_t *curve, ec_point_t *acc, const ec_point_t *P) {
+    ec_point_t tmp;
+    ec_add_point(curve, acc, P, &tmp);
+    *acc = tmp;
+}
+
+static void DoubleJacobian(const ec_domain_params_t *curve, ec_point_t *acc) {
+    ec_point_t tmp;
+    if (acc->infinity) return;
+    ec_double_point(curve, acc, &tmp);
+    *acc = tmp;
+}
+
+static void msm_straus_vartime(const ec_domain_params_t *curve, const uint256_t *k,
+                               const ec_point_t *P, size_t m, ec_point_t *R) {
+    ec_affine_t T[MSM_STRAUS_MAX][TABLE_SIZE], A;
+    int8_t d[MSM_STRAUS_MAX][L];
+    int len[MSM_STRAUS_MAX], top = 0;
+    uint256_t b3;
+    ec_point_t S, tmp;
+
+    ComputeB3(curve, &b3);
+    for (size_t j = 0; j < m; ++j) {
+        len[j] = ec_affine_from_point(curve, &P[j], &A) < 0 ? 0 : wnaf_encode_vartime(&k[j], d[j]);
+        if (len[j] > 0) PrecomputeTable(curve, &b3, &A, T[j]);
+        if (len[j] > top) top = len[j];
+    }
+
+    SetInfinity(R);
+    memset(&S.z, 0, sizeof(S.z));
+    S.z.limb[0] = 1;
+    S.infinity = 0;
+
+    for (int i = top - 1; i >= 0; --i) {
+        DoubleJacobian(curve, R);
+        for (size_t j = 0; j < m; ++j) {
+            if (i >= len[j] || d[j][i] == 0) continue;
+            const ec_affine_t *e = &T[j][(d[j][i] < 0 ? -d[j][i] : d[j][i]) >> 1];
+            S.x = e->x;
+            S.y = e->y;
+            if (d[j][i] < 0) {
+                mod_sub(&curve->p, &S.y, &curve->p, &S.y);
+            }
+            ec_add_point_mixed(curve, R, &S, &tmp);
+            *R = tmp;
+        }
+    }
+}
+
+/* bits [pos, pos + c) of k */
+static unsigned ScalarWindow(const uint256_t *k, unsigned pos, unsigned c) {
+    unsigned limb = pos >> 6, off = pos & 63;
+    uint64_t v = k->limb[limb] >> off;
+    if (off + c > 64 && limb < 3) v |= k->limb[limb + 1] << (64 - off);
+    return (unsigned)(v & ((1u << c) - 1));
+}
+
+/* Bucket method: for each c-bit window (top down) every point goes into
+ * the bucket of its digit, and the running-sum pass weights bucket b by
+ * b with 2 (2^c - 1) additions in total. */
+static void msm_pippenger_vartime(const ec_domain_params_t *curve, const uint256_t *k,
+                                  const ec_point_t *P, size_t n, ec_point_t *R) {
+    ec_point_t bucket[(1 << MSM_PIPPENGER_MAX_C) - 1];
+    ec_point_t running, sum;
+    unsigned c = 2;
+
+    while (c < MSM_PIPPENGER_MAX_C && ((size_t)1 << (c + 2)) < n) ++c;
+    unsigned nb = (1u << c) - 1;
+    unsigned windows = (256 + c - 1) / c;
+
+    SetInfinity(R);
+    for (unsigned w = windows; w-- > 0;) {
+        for (unsigned i = 0; i < c; ++i) DoubleJacobian(curve, R);
+
+        for (unsigned b = 0; b < nb; ++b) SetInfinity(&bucket[b]);
+        for (size_t i = 0; i < n; ++i) {
+            unsigned digit = ScalarWindow(&k[i], w * c, c);
+            if (digit != 0 && !P[i].infinity) AddJacobian(curve, &bucket[digit - 1], &P[i]);
+        }
+
+        SetInfinity(&running);
+        SetInfinity(&sum);
+        for (unsigned b = nb; b-- > 0;) {
+            AddJacobian(curve, &running, &bucket[b]);
+            AddJacobian(curve, &sum, &running);
+        }
+        AddJacobian(curve, R, &sum);
+    }
+}
+
+void ec_multi_scalar_multiply_vartime(const ec_domain_params_t *curve, const uint256_t *k,
+                                      const ec_point_t *P, size_t n, ec_point_t *R) {
+    if (n > MSM_STRAUS_MAX) {
+        msm_pippenger_vartime(curve, k, P, n, R);
+        return;
+    }
+    msm_straus_vartime(curve, k, P, n, R);
+}
+
+void ec_multi_scalar_multiply(const ec_domain_params_t *curve, const uint256_t *k,
+                              const ec_point_t *P, size_t n, ec_point_t *R) {
+
+    /* Constant-time Straus: every pass shares one run of L complete
+     * doublings between up to MSM_STRAUS_MAX points, and each point adds
+     * a constant-time table lookup per digit exactly as the single-point
+     * ladder does. Passes are summed with complete additions. */
+
+    ec_affine_t T[MSM_STRAUS_MAX][TABLE_SIZE], A;
+    uint8_t abs_d[MSM_STRAUS_MAX][L], sign_d[MSM_STRAUS_MAX][L];
+    uint256_t d[L], b3;
+    ec_proj_t total, Q;
+
+    ComputeB3(curve, &b3);
+    PointSetIdentity(&total);
+
+    for (size_t base = 0; base < n; base += MSM_STRAUS_MAX) {
+        size_t m = (n - base < MSM_STRAUS_MAX) ? n - base : MSM_STRAUS_MAX;
+        size_t used = 0;
+
+        /* identity inputs contribute nothing; which inputs those are is public */
+        for (size_t i = 0; i < m; ++i) {
+            if (ec_affine_from_point(curve, &P[base + i], &A) < 0) continue;
+
+            PrecomputeTable(curve, &b3, &A, T[used]);
+            ec_wnaf_encode_const(&k[base + i], d);
+            for (int idx = 0; idx < L; ++idx) {
+                abs_d[used][idx] = (uint8_t)d[idx].limb[0];
+                sign_d[used][idx] = (uint8_t)d[idx].limb[1];
+            }
+            used++;
+        }
+        if (used == 0) continue;
+
+        PointSetIdentity(&Q);
+        for (int idx = L - 1; idx >= 0; --idx) {
+            ec_complete_add(curve, &b3, &Q, &Q, &Q);
+            for (size_t j = 0; j < used; ++j) {
+                AddSignedDigit(curve, &b3, T[j], abs_d[j][idx], sign_d[j][idx] & 1u, &Q);
+            }
+        }
+        ec_complete_add(curve, &b3, &total, &Q, &total);
+    }
+
+    secure_wipe(d, sizeof(d));
+    secure_wipe(abs_d, sizeof(abs_d));
+    secure_wipe(sign_d, sizeof(sign_d));
+
+    ec_proj_to_point(curve, &total, R);
+}
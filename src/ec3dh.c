@@ -21,10 +21,12 @@ int ec3dh_generate_keypair(const ec_domain_params_t *curve, uint256_t *private_k
         return EC3DH_ERR_RNG;
     }
 
-    /* ec_scalar_multiply returns the public key in affine form (z == 1) */
+    /* ec_scalar_multiply returns the public key in affine form (z == 1).
+     * d is in [1, n-1], so d * G is a curve point other than infinity;
+     * the check below only guards against a broken ladder. */
     ec_scalar_multiply(curve, private_key, &curve->G, pubkey);
 
-    if (pubkey->infinity || !ec_point_on_curve(curve, pubkey)) {
+    if (pubkey->infinity) {
         secure_wipe(private_key, sizeof(*private_key));
         return EC3DH_ERR_PUBKEY_INVALID;
     }
@@ -32,10 +34,60 @@ int ec3dh_generate_keypair(const ec_domain_params_t *curve, uint256_t *private_k
     return EC3DH_OK;
 }
 
+int ec3dh_generate_keypairs(const ec_domain_params_t *curve, uint256_t *private_keys, ec_point_t *pubkeys, size_t n) {
+
+    for (size_t i = 0; i < n; i++) {
+        if (kp_generate_private_key(curve, &private_keys[i]) < 0) {
+            secure_wipe(private_keys, i * sizeof(*private_keys));
+            return EC3DH_ERR_RNG;
+        }
+        pubkeys[i] = curve->G;
+    }
+
+    ec_scalar_multiply_batch(curve, private_keys, pubkeys, pubkeys, n);
+
+    for (size_t i = 0; i < n; i++) {
+        if (pubkeys[i].infinity) {
+            secure_wipe(private_keys, n * sizeof(*private_keys));
+            return EC3DH_ERR_PUBKEY_INVALID;
+        }
+    }
+
+    return EC3DH_OK;
+}
+
+static int u256_is_one(const uint256_t *v) {
+    return v->limb[0] == 1 && (v->limb[1] | v->limb[2] | v->limb[3]) == 0;
+}
+
+/* Expand the shared x coordinate into the two keys and wipe it. */
+static int derive_keys(uint256_t *shared_secret,
+                       uint8_t *encryption_key, size_t enc_key_len, uint8_t *mac_key, size_t mac_key_len) {
+
+    if (ecdh_derive_key(shared_secret, "encryption",
+                        encryption_key, enc_key_len) < 0) {
+        secure_wipe(shared_secret, sizeof(*shared_secret));
+        return EC3DH_ERR_KDF;
+    }
+
+    if (ecdh_derive_key(shared_secret, "authentication",
+                        mac_key, mac_key_len) < 0) {
+        secure_wipe(shared_secret, sizeof(*shared_secret));
+        secure_wipe(encryption_key, enc_key_len);
+        return EC3DH_ERR_KDF;
+    }
+
+    secure_wipe(shared_secret, sizeof(*shared_secret));
+
+    return EC3DH_OK;
+}
+
 int ec3dh_compute_shared_secret_dk(const ec_domain_params_t *curve, const uint256_t *private_key, const ec_point_t *peer_pubkey,
                                    uint8_t *encryption_key, size_t enc_key_len, uint8_t *mac_key, size_t mac_key_len) {
 
-    ec_point_t shared_point = {0};
+    ec_point_t peer_affine;
+    const uint256_t *peer_x = &peer_pubkey->x;
+    uint256_t shared_secret;
 
     if (uint256_is_zero(private_key) || uint256_cmp(private_key, &curve->n) >= 0) {
         return EC3DH_ERR_PRIVKEY_RANGE;
@@ -45,32 +97,54 @@ int ec3dh_compute_shared_secret_dk(const ec_domain_params_t *curve, const uint25
         return EC3DH_ERR_PUBKEY_INVALID;
     }
 
-    ec_scalar_multiply(curve, private_key, peer_pubkey, &shared_point);
+    /* only x(d * Q) is needed, so the x-only ladder does the work; it
+     * wants the peer's affine x, which decoded keys already are */
+    if (!u256_is_one(&peer_pubkey->z)) {
+        ec_jacobian_to_affine(curve, peer_pubkey, &peer_affine);
+        peer_x = &peer_affine.x;
+    }
 
-    if (shared_point.infinity) {
-        secure_wipe(&shared_point, sizeof(shared_point));
+    if (ec_scalar_multiply_x(curve, private_key, peer_x, &shared_secret) < 0) {
         return EC3DH_ERR_SHARED_INFINITY;
     }
 
-    ec_jacobian_to_affine(curve, &shared_point, &shared_point);
+    return derive_keys(&shared_secret, encryption_key, enc_key_len, mac_key, mac_key_len);
+}
 
-    uint256_t shared_secret = shared_point.x;
-    secure_wipe(&shared_point, sizeof(shared_point));
+int ec3dh_compute_shared_secret_x_dk(const ec_domain_params_t *curve, const uint256_t *private_key, const uint256_t *peer_x,
+                                     uint8_t *encryption_key, size_t enc_key_len, uint8_t *mac_key, size_t mac_key_len) {
 
-    if (ecdh_derive_key(&shared_secret, "encryption",
-                        encryption_key, enc_key_len) < 0) {
-        secure_wipe(&shared_secret, sizeof(shared_secret));
-        return EC3DH_ERR_KDF;
+    uint256_t shared_secret;
+
+    if (uint256_is_zero(private_key) || uint256_cmp(private_key, &curve->n) >= 0) {
+        return EC3DH_ERR_PRIVKEY_RANGE;
     }
 
-    if (ecdh_derive_key(&shared_secret, "authentication",
-                        mac_key, mac_key_len) < 0) {
-        secure_wipe(&shared_secret, sizeof(shared_secret));
-        secure_wipe(encryption_key, enc_key_len);
-        return EC3DH_ERR_KDF;
+    if (!ec_x_on_curve(curve, peer_x)) {
+        return EC3DH_ERR_PUBKEY_INVALID;
     }
 
-    secure_wipe(&shared_secret, sizeof(shared_secret));
+    if (ec_scalar_multiply_x(curve, private_key, peer_x, &shared_secret) < 0) {
+        return EC3DH_ERR_SHARED_INFINITY;
+    }
 
-    return EC3DH_OK;
+    return derive_keys(&shared_secret, encryption_key, enc_key_len, mac_key, mac_key_len);
+}
+
+int ec3dh_compute_shared_secret_trusted_dk(const ec_domain_params_t *curve, const uint256_t *private_key,
+                                           const ec_affine_t *peer_pubkey,
+                                           uint8_t *encryption_key, size_t enc_key_len,
+                                           uint8_t *mac_key, size_t mac_key_len) {
+
+    uint256_t shared_secret;
+
+    if (uint256_is_zero(private_key) || uint256_cmp(private_key, &curve->n) >= 0) {
+        return EC3DH_ERR_PRIVKEY_RANGE;
+    }
+
+    if (ec_scalar_multiply_x(curve, private_key, &peer_pubkey->x, &shared_secret) < 0) {
+        return EC3DH_ERR_SHARED_INFINITY;
+    }
+
+    return derive_keys(&shared_secret, encryption_key, enc_key_len, mac_key, mac_key_len);
 }
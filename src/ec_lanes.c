@@ -0,0 +1,55 @@
+/*
+ * ec_lanes.c
+ *
+ * Backend selection for the lane-parallel ladder. See ec_lanes.h.
+ */
+
+#include "ec_lanes.h"
+#include "cpu_features.h"
+
+typedef void (*ladder_fn)(const uint256_t *a, const uint256_t *b3, const ec_affine_t *T,
+                          const uint8_t *digits, ec_proj_t *Q);
+
+static ladder_fn lanes_impl = NULL;
+static unsigned lanes_width = 0;
+
+void ec_lanes_select(int level) {
+    lanes_impl = NULL;
+    lanes_width = 0;
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    unsigned features = ec_cpu_features();
+
+    if (level >= 1 && (features & EC_CPU_AVX2)) {
+        lanes_impl = ec_lanes_ladder_avx2;
+        lanes_width = 4;
+    }
+    if (level >= 2 && (features & EC_CPU_IFMA)) {
+        lanes_impl = ec_lanes_ladder_ifma;
+        lanes_width = 8;
+    }
+#else
+    (void)level;
+#endif
+}
+
+unsigned ec_lanes_width(void) {
+    return lanes_width;
+}
+
+const char *ec_lanes_backend(void) {
+    if (lanes_width == 8) return "avx512-ifma";
+    if (lanes_width == 4) return "avx2";
+    return "none";
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((constructor)) static void ec_lanes_load(void) {
+    ec_lanes_select(2);
+}
+#endif
+
+void ec_lanes_ladder(const uint256_t *a, const uint256_t *b3, const ec_affine_t *T,
+                     const uint8_t *digits, ec_proj_t *Q) {
+    if (lanes_impl) lanes_impl(a, b3, T, digits, Q);
+}
@@ -0,0 +1,84 @@
+/*
+ * ec_lanes_avx2.c
+ *
+ * Four-lane P-256 ladder on AVX2. VPMULUDQ multiplies 32-bit halves, so
+ * an element is ten 26-bit limbs, one YMM register per limb, and every
+ * 52-bit product fits a 64-bit accumulator with room for the carries. A
+ * Montgomery product is 100 multiplies for a * b and 60 for m * p (four
+ * of p's limbs are zero). See ec_lanes.h and ec_lanes_ladder.h.
+ */
+
+#include "ec_lanes.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+#define LANES  4
+#define NLIMB  10
+#define RADIX  26
+#define LANES_TARGET __attribute__((target("avx2")))
+#define LANES_LADDER ec_lanes_ladder_avx2
+
+typedef __m256i vec_t;
+
+typedef struct {
+    vec_t v[NLIMB];
+} lfe_t;
+
+static const uint64_t P_LIMBS[NLIMB] = {
+    0x3ffffff, 0x3ffffff, 0x3ffffff, 0x003ffff, 0x0000000,
+    0x0000000, 0x0000000, 0x0000400, 0x3ff0000, 0x03fffff
+};
+static const uint64_t P2_LIMBS[NLIMB] = {
+    0x3fffffe, 0x3ffffff, 0x3ffffff, 0x007ffff, 0x0000000,
+    0x0000000, 0x0000000, 0x0000800, 0x3fe0000, 0x07fffff
+};
+
+static inline LANES_TARGET vec_t v_zero(void) { return _mm256_setzero_si256(); }
+static inline LANES_TARGET vec_t v_set1(uint64_t x) { return _mm256_set1_epi64x((long long)x); }
+static inline LANES_TARGET vec_t v_load(const uint64_t *p) { return _mm256_loadu_si256((const __m256i *)p); }
+static inline LANES_TARGET void v_store(uint64_t *p, vec_t a) { _mm256_storeu_si256((__m256i *)p, a); }
+static inline LANES_TARGET vec_t v_add(vec_t a, vec_t b) { return _mm256_add_epi64(a, b); }
+static inline LANES_TARGET vec_t v_sub(vec_t a, vec_t b) { return _mm256_sub_epi64(a, b); }
+static inline LANES_TARGET vec_t v_and(vec_t a, vec_t b) { return _mm256_and_si256(a, b); }
+static inline LANES_TARGET vec_t v_or(vec_t a, vec_t b) { return _mm256_or_si256(a, b); }
+static inline LANES_TARGET vec_t v_andnot(vec_t a, vec_t b) { return _mm256_andnot_si256(a, b); }
+static inline LANES_TARGET vec_t v_eq(vec_t a, vec_t b) { return _mm256_cmpeq_epi64(a, b); }
+#define v_srli(a, n) _mm256_srli_epi64((a), (n))
+
+/* Operand scanning: after each row acc[0] is a multiple of 2^26 (m is
+ * acc[0] itself, as -p^-1 = 1 mod 2^26) and is shifted out. Every
+ * accumulator collects fewer than 2^5 products below 2^52. */
+static inline LANES_TARGET void lfe_mont_mul(lfe_t *r, const lfe_t *a, const lfe_t *b) {
+    const vec_t mask = _mm256_set1_epi64x(0x3ffffff);
+    vec_t acc[NLIMB + 1];
+
+    for (int j = 0; j <= NLIMB; j++) acc[j] = _mm256_setzero_si256();
+
+    for (int i = 0; i < NLIMB; i++) {
+        vec_t bi = b->v[i], m;
+
+        for (int j = 0; j < NLIMB; j++) {
+            acc[j] = _mm256_add_epi64(acc[j], _mm256_mul_epu32(a->v[j], bi));
+        }
+        m = _mm256_and_si256(acc[0], mask);
+        for (int j = 0; j < NLIMB; j++) {
+            if (!P_LIMBS[j]) continue;
+            acc[j] = _mm256_add_epi64(acc[j],
+                                      _mm256_mul_epu32(m, _mm256_set1_epi64x((long long)P_LIMBS[j])));
+        }
+        acc[1] = _mm256_add_epi64(acc[1], _mm256_srli_epi64(acc[0], 26));
+        for (int j = 0; j < NLIMB; j++) acc[j] = acc[j + 1];
+        acc[NLIMB] = _mm256_setzero_si256();
+    }
+
+    for (int j = 0; j < NLIMB - 1; j++) {
+        acc[j + 1] = _mm256_add_epi64(acc[j + 1], _mm256_srli_epi64(acc[j], 26));
+        r->v[j] = _mm256_and_si256(acc[j], mask);
+    }
+    r->v[NLIMB - 1] = acc[NLIMB - 1];
+}
+
+#include "ec_lanes_ladder.h"
+
+#endif
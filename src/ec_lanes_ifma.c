@@ -0,0 +1,89 @@
+/*
+ * ec_lanes_ifma.c
+ *
+ * Eight-lane P-256 ladder on AVX-512 IFMA. An element is five 52-bit
+ * limbs, one ZMM register per limb. VPMADD52LUQ / VPMADD52HUQ add the low
+ * and high halves of a 52x52-bit product to a 64-bit accumulator, so a
+ * Montgomery product is 25 multiply-accumulates for a * b and 20 for
+ * m * p (p has one zero limb), with carries left in the accumulators
+ * until the end. See ec_lanes.h and ec_lanes_ladder.h.
+ */
+
+#include "ec_lanes.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+#define LANES  8
+#define NLIMB  5
+#define RADIX  52
+#define LANES_TARGET __attribute__((target("avx512f,avx512ifma")))
+#define LANES_LADDER ec_lanes_ladder_ifma
+
+typedef __m512i vec_t;
+
+typedef struct {
+    vec_t v[NLIMB];
+} lfe_t;
+
+static const uint64_t P_LIMBS[NLIMB] = {
+    0xfffffffffffffULL, 0x00fffffffffffULL, 0x0000000000000ULL,
+    0x0001000000000ULL, 0x0ffffffff0000ULL
+};
+static const uint64_t P2_LIMBS[NLIMB] = {
+    0xffffffffffffeULL, 0x01fffffffffffULL, 0x0000000000000ULL,
+    0x0002000000000ULL, 0x1fffffffe0000ULL
+};
+
+static inline LANES_TARGET vec_t v_zero(void) { return _mm512_setzero_si512(); }
+static inline LANES_TARGET vec_t v_set1(uint64_t x) { return _mm512_set1_epi64((long long)x); }
+static inline LANES_TARGET vec_t v_load(const uint64_t *p) { return _mm512_loadu_si512(p); }
+static inline LANES_TARGET void v_store(uint64_t *p, vec_t a) { _mm512_storeu_si512(p, a); }
+static inline LANES_TARGET vec_t v_add(vec_t a, vec_t b) { return _mm512_add_epi64(a, b); }
+static inline LANES_TARGET vec_t v_sub(vec_t a, vec_t b) { return _mm512_sub_epi64(a, b); }
+static inline LANES_TARGET vec_t v_and(vec_t a, vec_t b) { return _mm512_and_si512(a, b); }
+static inline LANES_TARGET vec_t v_or(vec_t a, vec_t b) { return _mm512_or_si512(a, b); }
+static inline LANES_TARGET vec_t v_andnot(vec_t a, vec_t b) { return _mm512_andnot_si512(a, b); }
+static inline LANES_TARGET vec_t v_eq(vec_t a, vec_t b) {
+    return _mm512_maskz_mov_epi64(_mm512_cmpeq_epi64_mask(a, b), _mm512_set1_epi64(-1));
+}
+#define v_srli(a, n) _mm512_srli_epi64((a), (n))
+
+/* Operand scanning: after each row acc[0] is a multiple of 2^52 (m is
+ * acc[0] itself, as -p^-1 = 1 mod 2^52) and is shifted out. Every
+ * accumulator collects fewer than 2^5 terms below 2^52. */
+static inline LANES_TARGET void lfe_mont_mul(lfe_t *r, const lfe_t *a, const lfe_t *b) {
+    const vec_t mask = _mm512_set1_epi64((long long)0xfffffffffffffULL);
+    vec_t acc[NLIMB + 1];
+
+    for (int j = 0; j <= NLIMB; j++) acc[j] = _mm512_setzero_si512();
+
+    for (int i = 0; i < NLIMB; i++) {
+        vec_t bi = b->v[i], m;
+
+        for (int j = 0; j < NLIMB; j++) {
+            acc[j]     = _mm512_madd52lo_epu64(acc[j], a->v[j], bi);
+            acc[j + 1] = _mm512_madd52hi_epu64(acc[j + 1], a->v[j], bi);
+        }
+        m = _mm512_and_si512(acc[0], mask);
+        for (int j = 0; j < NLIMB; j++) {
+            if (!P_LIMBS[j]) continue;
+            vec_t pj = _mm512_set1_epi64((long long)P_LIMBS[j]);
+            acc[j]     = _mm512_madd52lo_epu64(acc[j], pj, m);
+            acc[j + 1] = _mm512_madd52hi_epu64(acc[j + 1], pj, m);
+        }
+        acc[1] = _mm512_add_epi64(acc[1], _mm512_srli_epi64(acc[0], 52));
+        for (int j = 0; j < NLIMB; j++) acc[j] = acc[j + 1];
+        acc[NLIMB] = _mm512_setzero_si512();
+    }
+
+    for (int j = 0; j < NLIMB - 1; j++) {
+        acc[j + 1] = _mm512_add_epi64(acc[j + 1], _mm512_srli_epi64(acc[j], 52));
+        r->v[j] = _mm512_and_si512(acc[j], mask);
+    }
+    r->v[NLIMB - 1] = acc[NLIMB - 1];
+}
+
+#include "ec_lanes_ladder.h"
+
+#endif
@@ -4,14 +4,16 @@
  * ECDSA sign / verify on any secp256r1 curve.
  * Deterministic k is generated per RFC 6979 §3.2 (HMAC-SHA-256).
  *
- * All arithmetic over the curve ORDER n uses GMP (mpz_t), which is
- * already linked via -lgmp.  This sidesteps any risk that libmodplus is
- * internally optimised for the secp256r1 FIELD prime p and would give
- * wrong results when called with n as the modulus.
+ * Arithmetic over the curve ORDER n runs in the Montgomery domain of
+ * scalar.c, with the constants taken from the curve's constant block
+ * (curve_consts.h), so nothing is re-imported or allocated per call and
+ * the inversion of the nonce is constant time.
  *
  * EC point operations (scalar multiplication, affine conversion, point
- * validation) continue to use the existing library because those
- * operations ARE over p and are already correct.
+ * validation) use the library's point code over p.
+ *
+ * The nonce pool keeps (r, k^-1) pairs made from random k in a bgpool
+ * ring; signing with one is the same final step as ecdsa_sign.
  *
  * Byte-order convention (matching kdf.c / curve_params.c):
  *   uint256_t limbs are little-endian (limb[0] = least-significant 64 bits).
@@ -23,8 +25,13 @@
 #include "sha256.h"
 #include "hmac.h"
 #include "pk.h"
+#include "field.h"
+#include "scalar.h"
+#include "curve_consts.h"
+#include "bgpool.h"
+#include "secure_wipe.h"
 
-#include <gmp.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stddef.h>
 
@@ -48,105 +55,403 @@ static void be_to_u256(const uint8_t in[32], uint256_t *v)
     }
 }
 
-/* uint256_t → mpz_t (via big-endian bytes). */
-static void u256_to_mpz(const uint256_t *v, mpz_t out)
+/* e = hash mod n (bits2int with a 256-bit hash, then one reduction). */
+static void hash_to_scalar(const scalar_mont_t *m, const uint8_t hash[32], uint256_t *e)
 {
-    uint8_t bytes[32];
-    u256_to_be(v, bytes);
-    mpz_import(out, 32, 1, 1, 0, 0, bytes);
+    uint256_t h;
+    be_to_u256(hash, &h);
+    scalar_reduce(m, &h, e);
 }
 
-/* mpz_t → 32 big-endian bytes (zero-padded on the left). */
-static void mpz_to_be32(const mpz_t v, uint8_t out[32])
+/* ── per-key signing state ── */
+
+/*
+ * Everything signing derives from the private key alone. ecdsa_sign
+ * builds one on the stack per call; an ecdsa_signing_key keeps one.
+ */
+typedef struct {
+    const ec_domain_params_t *curve;
+    const scalar_mont_t      *m;
+    uint256_t                 d_m;      /* d, Montgomery domain */
+    uint8_t                   d_be[32]; /* int2octets(d) */
+    hmac_sha256_ctx_t         step_d;   /* RFC 6979 step d up to h1 */
+} sign_key_t;
+
+/* Returns 0, or -1 if d is not in [1, n-1]. */
+static int sign_key_init(sign_key_t               *sk,
+                         const ec_domain_params_t *curve,
+                         const scalar_mont_t      *m,
+                         const uint256_t          *d)
 {
-    memset(out, 0, 32);
-    size_t count = 0;
-    unsigned char tmp[32];
-    mpz_export(tmp, &count, 1, 1, 0, 0, v);
-    if (count > 0 && count <= 32)
-        memcpy(out + 32 - count, tmp, count);
+    static const uint8_t zero_key[32] = {0};
+    uint8_t prefix[33];
+
+    if (uint256_is_zero(d) || uint256_cmp(d, &curve->n) >= 0) return -1;
+
+    sk->curve = curve;
+    sk->m = m;
+    scalar_to_mont(m, d, &sk->d_m);
+    u256_to_be(d, sk->d_be);
+
+    /* step d is HMAC_K(V || 0x00 || int2octets(x) || h1) with the initial
+     * K = 0 and V = 0x01...01: only h1 depends on the message */
+    memset(prefix, 0x01, 32);
+    prefix[32] = 0x00;
+    hmac_sha256_init(&sk->step_d, zero_key, 32);
+    hmac_sha256_update(&sk->step_d, prefix, 33);
+    hmac_sha256_update(&sk->step_d, sk->d_be, 32);
+    return 0;
 }
 
-/* uint256_t → mpz, reduce once mod n if >= n.
- * For a 256-bit hash and 256-bit n (close to 2^256) one subtraction suffices. */
-static void hash_to_mpz_mod_n(const uint8_t hash[32], const mpz_t n, mpz_t e)
+static void sign_key_wipe(sign_key_t *sk)
 {
-    mpz_import(e, 32, 1, 1, 0, 0, hash);
-    mpz_mod(e, e, n);
+    secure_wipe(sk, sizeof(*sk));
 }
 
 /* ── RFC 6979 §3.2 deterministic-k generation ── */
 
 /*
- * privkey_be  – 32-byte big-endian private key (int2octets)
+ * sk          – per-key state (int2octets(x) and the step d prefix)
  * hash        – 32-byte SHA-256 message digest
- * n           – curve order as mpz_t
  * k_be_out    – 32-byte big-endian output
+ *
+ * Every HMAC under one K starts from a copy of the keyed context, so the
+ * key pads are hashed once per K rather than once per HMAC.
  */
-static void rfc6979_generate_k(const uint8_t  privkey_be[32],
-                                const uint8_t  hash[32],
-                                const mpz_t    n,
-                                uint8_t        k_be_out[32])
+static void rfc6979_generate_k(const sign_key_t *sk,
+                               const uint8_t     hash[32],
+                               uint8_t           k_be_out[32])
 {
+    static const uint8_t marker0 = 0x00, marker1 = 0x01;
+    hmac_sha256_ctx_t keyed, ctx;
+
     /* bits2octets(h1): reduce hash mod n, serialise as 32-byte big-endian. */
-    mpz_t h_mpz;
-    mpz_init(h_mpz);
-    hash_to_mpz_mod_n(hash, n, h_mpz);
+    uint256_t h;
+    hash_to_scalar(sk->m, hash, &h);
     uint8_t h1_octets[32];
-    mpz_to_be32(h_mpz, h1_octets);
-    mpz_clear(h_mpz);
+    u256_to_be(&h, h1_octets);
 
     uint8_t V[32], K[32];
-    memset(V, 0x01, 32);   /* Step b */
-    memset(K, 0x00, 32);   /* Step c */
-
-    /* Buffer: V(32) | marker(1) | privkey(32) | h1(32) = 97 bytes */
-    uint8_t buf[97];
+    memset(V, 0x01, 32);   /* Steps b, c are folded into sk->step_d */
 
     /* Step d */
-    memcpy(buf,      V,          32); buf[32] = 0x00;
-    memcpy(buf + 33, privkey_be, 32);
-    memcpy(buf + 65, h1_octets,  32);
-    hmac_sha256(K, 32, buf, 97, K);
+    hmac_sha256_clone(&ctx, &sk->step_d);
+    hmac_sha256_update(&ctx, h1_octets, 32);
+    hmac_sha256_final(&ctx, K);
+    hmac_sha256_init(&keyed, K, 32);
 
     /* Step e */
-    hmac_sha256(K, 32, V, 32, V);
+    hmac_sha256_clone(&ctx, &keyed);
+    hmac_sha256_update(&ctx, V, 32);
+    hmac_sha256_final(&ctx, V);
 
     /* Step f */
-    memcpy(buf,      V,          32); buf[32] = 0x01;
-    memcpy(buf + 33, privkey_be, 32);
-    memcpy(buf + 65, h1_octets,  32);
-    hmac_sha256(K, 32, buf, 97, K);
+    hmac_sha256_clone(&ctx, &keyed);
+    hmac_sha256_update(&ctx, V, 32);
+    hmac_sha256_update(&ctx, &marker1, 1);
+    hmac_sha256_update(&ctx, sk->d_be, 32);
+    hmac_sha256_update(&ctx, h1_octets, 32);
+    hmac_sha256_final(&ctx, K);
+    hmac_sha256_init(&keyed, K, 32);
 
     /* Step g */
-    hmac_sha256(K, 32, V, 32, V);
+    hmac_sha256_clone(&ctx, &keyed);
+    hmac_sha256_update(&ctx, V, 32);
+    hmac_sha256_final(&ctx, V);
 
     /* Step h: generate T until k in [1, n-1]. */
-    mpz_t k_cand;
-    mpz_init(k_cand);
+    uint256_t k_cand;
     for (;;) {
-        hmac_sha256(K, 32, V, 32, V);
+        hmac_sha256_clone(&ctx, &keyed);
+        hmac_sha256_update(&ctx, V, 32);
+        hmac_sha256_final(&ctx, V);
         memcpy(k_be_out, V, 32);
 
-        mpz_import(k_cand, 32, 1, 1, 0, 0, k_be_out);
-        if (mpz_sgn(k_cand) > 0 && mpz_cmp(k_cand, n) < 0)
+        be_to_u256(k_be_out, &k_cand);
+        if (!uint256_is_zero(&k_cand) && uint256_cmp(&k_cand, &sk->m->n) < 0)
             break;
 
-        uint8_t v0[33];
-        memcpy(v0, V, 32); v0[32] = 0x00;
-        hmac_sha256(K, 32, v0, 33, K);
-        hmac_sha256(K, 32, V,  32, V);
+        hmac_sha256_clone(&ctx, &keyed);
+        hmac_sha256_update(&ctx, V, 32);
+        hmac_sha256_update(&ctx, &marker0, 1);
+        hmac_sha256_final(&ctx, K);
+        hmac_sha256_init(&keyed, K, 32);
+        hmac_sha256_clone(&ctx, &keyed);
+        hmac_sha256_update(&ctx, V, 32);
+        hmac_sha256_final(&ctx, V);
     }
-    mpz_clear(k_cand);
 
-    memset(buf,       0, sizeof(buf));
-    memset(h1_octets, 0, 32);
-    memset(V, 0, 32);
-    memset(K, 0, 32);
+    secure_wipe(&k_cand,   sizeof(k_cand));
+    secure_wipe(&keyed,    sizeof(keyed));
+    secure_wipe(&ctx,      sizeof(ctx));
+    secure_wipe(h1_octets, 32);
+    secure_wipe(V, 32);
+    secure_wipe(K, 32);
+}
+
+/* in[l] = rows + l * stride, len[l] = row_len, for the multi-buffer calls */
+static void lane_rows(const uint8_t **in, size_t *len, const uint8_t *rows,
+                      size_t stride, size_t row_len, size_t n)
+{
+    for (size_t l = 0; l < n; l++) {
+        in[l] = rows + l * stride;
+        len[l] = row_len;
+    }
+}
+
+/*
+ * rfc6979_generate_k for n ≤ SHA256_LANES digests at once: every HMAC of
+ * steps d to h runs as a multi-buffer HMAC with one lane per digest. A
+ * lane whose first step h candidate is out of range (about 2^-32 for
+ * P-256) is redone by rfc6979_generate_k, which carries on with step h.
+ */
+static void rfc6979_generate_k_lanes(const sign_key_t *sk,
+                                     const uint8_t   (*hashes)[32],
+                                     size_t            n,
+                                     uint8_t         (*k_be_out)[32])
+{
+    hmac_sha256_ctx_t keyed[SHA256_LANES], ctx[SHA256_LANES];
+    uint8_t h1_octets[SHA256_LANES][32], V[SHA256_LANES][32], K[SHA256_LANES][32];
+    uint8_t f_msg[SHA256_LANES][97];
+    const uint8_t *in[SHA256_LANES];
+    size_t len[SHA256_LANES];
+    uint256_t h, k_cand;
+    size_t l;
+
+    for (l = 0; l < n; l++) {
+        hash_to_scalar(sk->m, hashes[l], &h);
+        u256_to_be(&h, h1_octets[l]);
+        memset(V[l], 0x01, 32);   /* Steps b, c are folded into sk->step_d */
+        hmac_sha256_clone(&ctx[l], &sk->step_d);
+    }
+
+    /* Step d */
+    lane_rows(in, len, h1_octets[0], 32, 32, n);
+    hmac_sha256_update_lanes(ctx, in, len, n);
+    hmac_sha256_final_lanes(ctx, K, n);
+    lane_rows(in, len, K[0], 32, 32, n);
+    hmac_sha256_init_lanes(keyed, in, 32, n);
+
+    /* Step e */
+    for (l = 0; l < n; l++) hmac_sha256_clone(&ctx[l], &keyed[l]);
+    lane_rows(in, len, V[0], 32, 32, n);
+    hmac_sha256_update_lanes(ctx, in, len, n);
+    hmac_sha256_final_lanes(ctx, V, n);
+
+    /* Step f: V || 0x01 || int2octets(x) || h1 */
+    for (l = 0; l < n; l++) {
+        memcpy(f_msg[l], V[l], 32);
+        f_msg[l][32] = 0x01;
+        memcpy(f_msg[l] + 33, sk->d_be, 32);
+        memcpy(f_msg[l] + 65, h1_octets[l], 32);
+        hmac_sha256_clone(&ctx[l], &keyed[l]);
+    }
+    lane_rows(in, len, f_msg[0], 97, 97, n);
+    hmac_sha256_update_lanes(ctx, in, len, n);
+    hmac_sha256_final_lanes(ctx, K, n);
+    lane_rows(in, len, K[0], 32, 32, n);
+    hmac_sha256_init_lanes(keyed, in, 32, n);
+
+    /* Steps g and h: two more HMAC_K(V), the second is the first T */
+    for (int step = 0; step < 2; step++) {
+        for (l = 0; l < n; l++) hmac_sha256_clone(&ctx[l], &keyed[l]);
+        lane_rows(in, len, V[0], 32, 32, n);
+        hmac_sha256_update_lanes(ctx, in, len, n);
+        hmac_sha256_final_lanes(ctx, V, n);
+    }
+
+    for (l = 0; l < n; l++) {
+        memcpy(k_be_out[l], V[l], 32);
+        be_to_u256(k_be_out[l], &k_cand);
+        if (uint256_is_zero(&k_cand) || uint256_cmp(&k_cand, &sk->m->n) >= 0)
+            rfc6979_generate_k(sk, hashes[l], k_be_out[l]);
+    }
+
+    secure_wipe(&k_cand,   sizeof(k_cand));
+    secure_wipe(keyed,     sizeof(keyed));
+    secure_wipe(ctx,       sizeof(ctx));
+    secure_wipe(h1_octets, sizeof(h1_octets));
+    secure_wipe(f_msg,     sizeof(f_msg));
+    secure_wipe(V,         sizeof(V));
+    secure_wipe(K,         sizeof(K));
 }
 
 /* ── ECDSA sign ── */
 
+/*
+ * s = k⁻¹ · (e + r·d) mod n and the encoded signature (r, s).
+ * kinv_m, e_m, d_m are in the Montgomery domain, r is not.
+ * Returns 0, or -1 if s = 0 (the caller needs another nonce).
+ */
+static int sign_with_nonce(const scalar_mont_t *m,
+                           const uint256_t     *r,
+                           const uint256_t     *kinv_m,
+                           const uint256_t     *e_m,
+                           const uint256_t     *d_m,
+                           uint8_t              sig_r[32],
+                           uint8_t              sig_s[32])
+{
+    uint256_t r_m, t_m, s;
+
+    scalar_to_mont(m, r, &r_m);
+    scalar_mul(m, &r_m, d_m, &t_m);
+    scalar_add(m, &t_m, e_m, &t_m);
+    scalar_mul(m, kinv_m, &t_m, &s);
+    scalar_from_mont(m, &s, &s);
+    secure_wipe(&t_m, sizeof(t_m));
+    if (uint256_is_zero(&s)) return -1;
+
+    u256_to_be(r, sig_r);
+    u256_to_be(&s, sig_s);
+    return 0;
+}
+
+/* Deterministic signature of a 32-byte digest. Returns 0 or -1. */
+static int sign_hash(const sign_key_t *sk,
+                     const uint8_t     digest[32],
+                     uint8_t           sig_r[32],
+                     uint8_t           sig_s[32])
+{
+    const scalar_mont_t *m = sk->m;
+    uint8_t hash[32];
+    memcpy(hash, digest, 32);
+
+    /* e = hash mod n */
+    uint256_t e, e_m;
+    hash_to_scalar(m, hash, &e);
+    scalar_to_mont(m, &e, &e_m);
+
+    uint8_t k_be[32];
+    rfc6979_generate_k(sk, hash, k_be);
+
+    uint256_t k, k_m, kinv_m, r;
+    int ret = -1;
+    for (int attempt = 0; attempt < 64; attempt++) {
+        if (attempt > 0) {
+            sha256(k_be, 32, hash);
+            rfc6979_generate_k(sk, hash, k_be);
+        }
+
+        /* R = k·G */
+        be_to_u256(k_be, &k);
+        ec_point_t R_aff;
+        ec_scalar_multiply(sk->curve, &k, &sk->curve->G, &R_aff); /* affine result */
+        if (R_aff.infinity) continue;
+
+        /* r = R.x mod n */
+        scalar_reduce(m, &R_aff.x, &r);
+        if (uint256_is_zero(&r)) continue;
+
+        /* k ∈ [1, n-1] is invertible */
+        scalar_to_mont(m, &k, &k_m);
+        scalar_inv(m, &k_m, &kinv_m);
+        if (sign_with_nonce(m, &r, &kinv_m, &e_m, &sk->d_m, sig_r, sig_s) == 0) {
+            ret = 0;
+            break;
+        }
+    }
+
+    secure_wipe(&k,      sizeof(k));
+    secure_wipe(&k_m,    sizeof(k_m));
+    secure_wipe(&kinv_m, sizeof(kinv_m));
+    secure_wipe(k_be,    32);
+    return ret;
+}
+
+/* messages per shared k·G normalization and k⁻¹ inversion */
+#define SIGN_BATCH 16
+
+/*
+ * Deterministic signatures of n ≤ SIGN_BATCH digests. The nonces are
+ * derived SHA256_LANES at a time, all k·G run through ec_scalar_multiply_batch
+ * (one field inversion) and all k⁻¹ through scalar_inv_batch (one scalar
+ * inversion). A message whose first nonce is unusable (r = 0 or s = 0,
+ * negligible in practice) is redone by sign_hash, so the output is
+ * exactly what ecdsa_sign gives. Returns 0 or -1.
+ */
+static int sign_hash_batch(const sign_key_t *sk,
+                           const uint8_t   (*digests)[32],
+                           size_t            n,
+                           uint8_t         (*sig_r)[32],
+                           uint8_t         (*sig_s)[32])
+{
+    const scalar_mont_t *m = sk->m;
+    uint256_t  e_m[SIGN_BATCH], r[SIGN_BATCH];
+    uint256_t  k[SIGN_BATCH] = {0}, k_m[SIGN_BATCH], kinv_m[SIGN_BATCH];
+    ec_point_t R[SIGN_BATCH] = {0};
+    size_t     idx[SIGN_BATCH], cnt = 0;
+    uint8_t    k_be[SIGN_BATCH][32];
+    int        ret = 0;
+
+    if (n > SIGN_BATCH) return -1;
+
+    for (size_t off = 0; off < n; off += SHA256_LANES) {
+        size_t lanes = n - off < SHA256_LANES ? n - off : SHA256_LANES;
+        rfc6979_generate_k_lanes(sk, digests + off, lanes, k_be + off);
+    }
+    for (size_t i = 0; i < n; i++) {
+        uint256_t e;
+        hash_to_scalar(m, digests[i], &e);
+        scalar_to_mont(m, &e, &e_m[i]);
+        be_to_u256(k_be[i], &k[i]);
+        R[i] = sk->curve->G;
+    }
+    ec_scalar_multiply_batch(sk->curve, k, R, R, n);
+
+    /* usable nonces go to the shared inversion, the rest to sign_hash */
+    for (size_t i = 0; i < n; i++) {
+        if (!R[i].infinity) scalar_reduce(m, &R[i].x, &r[i]);
+        if (R[i].infinity || uint256_is_zero(&r[i])) {
+            ret |= sign_hash(sk, digests[i], sig_r[i], sig_s[i]);
+            continue;
+        }
+        scalar_to_mont(m, &k[i], &k_m[cnt]);
+        idx[cnt++] = i;
+    }
+    scalar_inv_batch(m, k_m, kinv_m, cnt);
+
+    for (size_t j = 0; j < cnt; j++) {
+        size_t i = idx[j];
+        if (sign_with_nonce(m, &r[i], &kinv_m[j], &e_m[i], &sk->d_m, sig_r[i], sig_s[i]) < 0)
+            ret |= sign_hash(sk, digests[i], sig_r[i], sig_s[i]);
+    }
+
+    secure_wipe(k,      sizeof(k));
+    secure_wipe(k_m,    sizeof(k_m));
+    secure_wipe(kinv_m, sizeof(kinv_m));
+    secure_wipe(k_be,   sizeof(k_be));
+    return ret ? -1 : 0;
+}
+
+/* Hash and sign msgs[0..n) in SIGN_BATCH chunks, each hashed with the
+ * multi-buffer SHA-256. Returns 0 or -1. */
+static int sign_msgs_batch(const sign_key_t     *sk,
+                           const uint8_t *const *msgs,
+                           const size_t         *msg_lens,
+                           size_t                n,
+                           uint8_t             (*sig_r)[32],
+                           uint8_t             (*sig_s)[32])
+{
+    uint8_t digests[SIGN_BATCH][32];
+    SHA256_ctx_t hash[SIGN_BATCH];
+    SHA256_ctx_t *hp[SIGN_BATCH];
+    int ret = 0;
+
+    for (size_t off = 0; off < n; off += SIGN_BATCH) {
+        size_t cnt = n - off < SIGN_BATCH ? n - off : SIGN_BATCH;
+        for (size_t i = 0; i < cnt; i++) {
+            if (!msgs[off + i]) return -1;
+            sha256_init(&hash[i]);
+            hp[i] = &hash[i];
+        }
+        sha256_update_lanes(hp, msgs + off, msg_lens + off, cnt);
+        sha256_final_lanes(hp, digests, cnt);
+        ret |= sign_hash_batch(sk, (const uint8_t (*)[32])digests, cnt,
+                               sig_r + off, sig_s + off);
+    }
+    return ret ? -1 : 0;
+}
+
 int ecdsa_sign(const ec_domain_params_t *curve,
                const uint256_t          *private_key,
                const uint8_t            *msg,
@@ -154,133 +459,377 @@ int ecdsa_sign(const ec_domain_params_t *curve,
                uint8_t                   sig_r[32],
                uint8_t                   sig_s[32])
 {
-    if (!private_key || !msg || !sig_r || !sig_s) return -1;
-    if (uint256_is_zero(private_key) || uint256_cmp(private_key, &curve->n) >= 0)
+    if (!msg) return -1;
+
+    uint8_t hash[32];
+    sha256(msg, msg_len, hash);
+    return ecdsa_sign_digest(curve, private_key, hash, sig_r, sig_s);
+}
+
+int ecdsa_sign_digest(const ec_domain_params_t *curve,
+                      const uint256_t          *private_key,
+                      const uint8_t             digest[32],
+                      uint8_t                   sig_r[32],
+                      uint8_t                   sig_s[32])
+{
+    if (!private_key || !digest || !sig_r || !sig_s) return -1;
+
+    ec_curve_consts_t tmp_consts;
+    const scalar_mont_t *m = &ec_curve_consts(curve, &tmp_consts)->n_mont;
+
+    sign_key_t sk;
+    if (sign_key_init(&sk, curve, m, private_key) < 0) return -1;
+
+    int ret = sign_hash(&sk, digest, sig_r, sig_s);
+
+    sign_key_wipe(&sk);
+    return ret;
+}
+
+void ecdsa_sign_init(SHA256_ctx_t *ctx)
+{
+    sha256_init(ctx);
+}
+
+void ecdsa_sign_update(SHA256_ctx_t *ctx, const uint8_t *data, size_t len)
+{
+    sha256_update(ctx, data, len);
+}
+
+int ecdsa_sign_final(SHA256_ctx_t             *ctx,
+                     const ec_domain_params_t *curve,
+                     const uint256_t          *private_key,
+                     uint8_t                   sig_r[32],
+                     uint8_t                   sig_s[32])
+{
+    uint8_t hash[32];
+
+    sha256_final(ctx, hash);
+    secure_wipe(ctx, sizeof(*ctx));
+    return ecdsa_sign_digest(curve, private_key, hash, sig_r, sig_s);
+}
+
+int ecdsa_sign_batch(const ec_domain_params_t *curve,
+                     const uint256_t          *private_key,
+                     const uint8_t *const     *msgs,
+                     const size_t             *msg_lens,
+                     size_t                    n,
+                     uint8_t                 (*sig_r)[32],
+                     uint8_t                 (*sig_s)[32])
+{
+    if (!private_key || (n && (!msgs || !msg_lens || !sig_r || !sig_s))) return -1;
+
+    ec_curve_consts_t tmp_consts;
+    const scalar_mont_t *m = &ec_curve_consts(curve, &tmp_consts)->n_mont;
+
+    sign_key_t sk;
+    if (sign_key_init(&sk, curve, m, private_key) < 0) return -1;
+
+    int ret = sign_msgs_batch(&sk, msgs, msg_lens, n, sig_r, sig_s);
+
+    sign_key_wipe(&sk);
+    return ret;
+}
+
+/* ── reusable signing key ── */
+
+struct ecdsa_signing_key {
+    sign_key_t        sk;
+    ec_curve_consts_t consts;  /* backs sk.m for curves without a block */
+};
+
+int ecdsa_signing_key_new(ecdsa_signing_key_t     **key,
+                          const ec_domain_params_t *curve,
+                          const uint256_t          *private_key)
+{
+    ecdsa_signing_key_t *k;
+
+    if (!key) return -1;
+    *key = NULL;
+    if (!curve || !private_key) return -1;
+
+    k = (ecdsa_signing_key_t *)calloc(1, sizeof(*k));
+    if (!k) return -1;
+    if (sign_key_init(&k->sk, curve, &ec_curve_consts(curve, &k->consts)->n_mont,
+                      private_key) < 0) {
+        ecdsa_signing_key_free(k);
         return -1;
+    }
+
+    *key = k;
+    return 0;
+}
 
-    /* Hash the message. */
+int ecdsa_signing_key_sign(const ecdsa_signing_key_t *key,
+                           const uint8_t             *msg,
+                           size_t                     msg_len,
+                           uint8_t                    sig_r[32],
+                           uint8_t                    sig_s[32])
+{
     uint8_t hash[32];
+
+    if (!key || !msg || !sig_r || !sig_s) return -1;
     sha256(msg, msg_len, hash);
+    return sign_hash(&key->sk, hash, sig_r, sig_s);
+}
 
-    /* Serialise private key for RFC 6979. */
-    uint8_t privkey_be[32];
-    u256_to_be(private_key, privkey_be);
+int ecdsa_signing_key_sign_digest(const ecdsa_signing_key_t *key,
+                                  const uint8_t              digest[32],
+                                  uint8_t                    sig_r[32],
+                                  uint8_t                    sig_s[32])
+{
+    if (!key || !digest || !sig_r || !sig_s) return -1;
+    return sign_hash(&key->sk, digest, sig_r, sig_s);
+}
 
-    /* Load curve order and private key into GMP. */
-    mpz_t n, privkey_mpz, e, k_mpz, r, s, tmp, kinv;
-    mpz_inits(n, privkey_mpz, e, k_mpz, r, s, tmp, kinv, NULL);
-    u256_to_mpz(&curve->n, n);
-    mpz_import(privkey_mpz, 32, 1, 1, 0, 0, privkey_be);
+int ecdsa_signing_key_sign_batch(const ecdsa_signing_key_t *key,
+                                 const uint8_t *const      *msgs,
+                                 const size_t              *msg_lens,
+                                 size_t                     n,
+                                 uint8_t                  (*sig_r)[32],
+                                 uint8_t                  (*sig_s)[32])
+{
+    if (!key || (n && (!msgs || !msg_lens || !sig_r || !sig_s))) return -1;
+    return sign_msgs_batch(&key->sk, msgs, msg_lens, n, sig_r, sig_s);
+}
 
-    /* e = hash mod n */
-    hash_to_mpz_mod_n(hash, n, e);
+void ecdsa_signing_key_free(ecdsa_signing_key_t *key)
+{
+    if (!key) return;
+    secure_wipe(key, sizeof(*key));
+    free(key);
+}
 
-    uint8_t k_be[32];
-    rfc6979_generate_k(privkey_be, hash, n, k_be);
+/* ── randomized nonce pool ── */
+
+typedef struct {
+    uint256_t r;       /* x(kG) mod n */
+    uint256_t kinv_m;  /* k⁻¹, Montgomery domain */
+} ecdsa_nonce_t;
 
+struct ecdsa_nonce_pool {
+    const ec_domain_params_t *curve;
+    const scalar_mont_t      *m;
+    ec_curve_consts_t         consts;  /* backs m for curves without a block */
+    bgpool_t                 *bg;
+};
+
+/*
+ * n ≤ BGPOOL_BATCH nonces from random k: the k·G share one batched
+ * normalization and the k⁻¹ one scalar inversion. Returns 0, or -1 if
+ * the RNG failed (or, with negligible probability, some r was 0).
+ */
+static int make_nonces(const ec_domain_params_t *curve,
+                       const scalar_mont_t      *m,
+                       ecdsa_nonce_t            *out,
+                       size_t                    n)
+{
+    uint256_t  k[BGPOOL_BATCH] = {0}, k_m[BGPOOL_BATCH], kinv_m[BGPOOL_BATCH];
+    ec_point_t R[BGPOOL_BATCH] = {0};
     int ret = -1;
-    for (int attempt = 0; attempt < 64; attempt++) {
-        if (attempt > 0) {
-            sha256(k_be, 32, hash);
-            rfc6979_generate_k(privkey_be, hash, n, k_be);
-        }
 
-        mpz_import(k_mpz, 32, 1, 1, 0, 0, k_be);
-
-        /* R = k·G (EC operation, over p — uses existing library). */
-        uint256_t k_u256;
-        be_to_u256(k_be, &k_u256);
-        ec_point_t R_jac, R_aff;
-        ec_scalar_multiply(curve, &k_u256, &curve->G, &R_jac);
-        if (R_jac.infinity) continue;
-        ec_jacobian_to_affine(curve, &R_jac, &R_aff);
-
-        /* r = R.x mod n (GMP) */
-        uint8_t rx_bytes[32];
-        u256_to_be(&R_aff.x, rx_bytes);
-        mpz_import(r, 32, 1, 1, 0, 0, rx_bytes);
-        mpz_mod(r, r, n);
-        if (mpz_sgn(r) == 0) continue;
-
-        /* s = k⁻¹ · (e + r·privkey) mod n (GMP) */
-        mpz_mul(tmp, r, privkey_mpz);
-        mpz_mod(tmp, tmp, n);
-        mpz_add(tmp, e, tmp);
-        mpz_mod(tmp, tmp, n);
-        if (!mpz_invert(kinv, k_mpz, n)) continue; /* k and n must be coprime */
-        mpz_mul(s, kinv, tmp);
-        mpz_mod(s, s, n);
-        if (mpz_sgn(s) == 0) continue;
-
-        mpz_to_be32(r, sig_r);
-        mpz_to_be32(s, sig_s);
-        ret = 0;
-        break;
+    if (n == 0 || n > BGPOOL_BATCH) return -1;
+    for (size_t i = 0; i < n; i++) {
+        if (kp_generate_private_key(curve, &k[i]) < 0) goto done;
+        R[i] = curve->G;
     }
+    ec_scalar_multiply_batch(curve, k, R, R, n);
 
-    mpz_clears(n, privkey_mpz, e, k_mpz, r, s, tmp, kinv, NULL);
-    memset(k_be,       0, 32);
-    memset(privkey_be, 0, 32);
+    for (size_t i = 0; i < n; i++) {
+        if (R[i].infinity) goto done;
+        scalar_reduce(m, &R[i].x, &out[i].r);
+        if (uint256_is_zero(&out[i].r)) goto done;
+        scalar_to_mont(m, &k[i], &k_m[i]);
+    }
+    scalar_inv_batch(m, k_m, kinv_m, n);
+    for (size_t i = 0; i < n; i++) out[i].kinv_m = kinv_m[i];
+    ret = 0;
+
+done:
+    secure_wipe(k,      sizeof(k));
+    secure_wipe(k_m,    sizeof(k_m));
+    secure_wipe(kinv_m, sizeof(kinv_m));
     return ret;
 }
 
-/* ── Variable-time 2-scalar simultaneous multiplication (Shamir's trick) ──
- *
- * Computes R = k1·P1 + k2·P2 in a single pass of 256 doublings instead of
- * two separate scalar multiplications.  This is ~2x faster for the doubling
- * portion (which dominates), at the cost of ~3/4 * 256 additions vs ~1/4 * 256
- * for the constant-time wNAF.  Net field-operation count is still materially
- * lower than two separate ct-wNAF calls.
- *
- * Variable-time is safe here because all inputs to ECDSA verify are PUBLIC:
- *   k1 = u1 = e·s⁻¹ mod n   (derived from public hash and signature)
- *   k2 = u2 = r·s⁻¹ mod n   (same)
- *   P1 = G  (public generator)
- *   P2 = Q  (public key)
- * No secret values flow through this function.
- */
-static void ec_mul2add_vartime(const ec_domain_params_t *curve,
-                               const uint256_t          *k1,
-                               const ec_point_t         *P1,
-                               const uint256_t          *k2,
-                               const ec_point_t         *P2,
-                               ec_point_t               *R)
-{
-    /* Precompute: T[0]=P1, T[1]=P2, T[2]=P1+P2 */
-    ec_point_t T[3];
-    T[0] = *P1;
-    T[1] = *P2;
-    ec_add_point(curve, P1, P2, &T[2]);
-
-    /* Initialise R to the point at infinity. */
-    memset(R, 0, sizeof(*R));
-    R->x.limb[0] = 1;   /* matches PointSetIdentity in ec.c */
-    R->y.limb[0] = 1;
-    R->infinity   = 1;
-
-    /* Process from the most-significant bit downward. */
-    for (int i = 255; i >= 0; i--) {
-        ec_point_t tmp;
-        ec_double_point(curve, R, &tmp);
-        *R = tmp;
-
-        int b1 = (int)((k1->limb[i >> 6] >> (i & 63)) & 1);
-        int b2 = (int)((k2->limb[i >> 6] >> (i & 63)) & 1);
-
-        if (b1 | b2) {
-            /*  b1 b2  → table index
-             *   1  0  → 0  (P1)
-             *   0  1  → 1  (P2)
-             *   1  1  → 2  (P1+P2)          */
-            int idx = b2 ? (b1 ? 2 : 1) : 0;
-            ec_add_point(curve, R, &T[idx], &tmp);
-            *R = tmp;
+static int produce_nonces(void *ctx, void *items, size_t n)
+{
+    const ecdsa_nonce_pool_t *pool = (const ecdsa_nonce_pool_t *)ctx;
+    return make_nonces(pool->curve, pool->m, (ecdsa_nonce_t *)items, n);
+}
+
+int ecdsa_nonce_pool_start(ecdsa_nonce_pool_t     **pool,
+                           const ec_domain_params_t *curve,
+                           size_t                    low,
+                           size_t                    high,
+                           unsigned                  threads)
+{
+    ecdsa_nonce_pool_t *p;
+
+    if (!pool) return -1;
+    *pool = NULL;
+    if (!curve) return -1;
+
+    p = (ecdsa_nonce_pool_t *)calloc(1, sizeof(*p));
+    if (!p) return -1;
+    p->curve = curve;
+    p->m = &ec_curve_consts(curve, &p->consts)->n_mont;
+    if (bgpool_start(&p->bg, sizeof(ecdsa_nonce_t), low, high, threads,
+                     produce_nonces, p) != 0) {
+        free(p);
+        return -1;
+    }
+
+    *pool = p;
+    return 0;
+}
+
+int ecdsa_sign_pooled(ecdsa_nonce_pool_t *pool,
+                      const uint256_t    *private_key,
+                      const uint8_t      *msg,
+                      size_t              msg_len,
+                      uint8_t             sig_r[32],
+                      uint8_t             sig_s[32])
+{
+    if (!pool || !private_key || !msg || !sig_r || !sig_s) return -1;
+    if (uint256_is_zero(private_key) || uint256_cmp(private_key, &pool->curve->n) >= 0)
+        return -1;
+
+    const scalar_mont_t *m = pool->m;
+
+    uint8_t hash[32];
+    sha256(msg, msg_len, hash);
+
+    uint256_t e, e_m, d_m;
+    hash_to_scalar(m, hash, &e);
+    scalar_to_mont(m, &e, &e_m);
+    scalar_to_mont(m, private_key, &d_m);
+
+    /* bgpool_take fails in a forked child, whose ring copy holds the
+     * parent's nonces, so the child always takes the make_nonces path */
+    ecdsa_nonce_t nonce;
+    int ret = -1;
+    for (int attempt = 0; attempt < 64; attempt++) {
+        if (bgpool_take(pool->bg, &nonce) < 0 &&
+            make_nonces(pool->curve, m, &nonce, 1) < 0)
+            break;
+        if (sign_with_nonce(m, &nonce.r, &nonce.kinv_m, &e_m, &d_m, sig_r, sig_s) == 0) {
+            ret = 0;
+            break;
         }
     }
+
+    secure_wipe(&nonce, sizeof(nonce));
+    secure_wipe(&d_m,   sizeof(d_m));
+    return ret;
+}
+
+size_t ecdsa_nonce_pool_available(const ecdsa_nonce_pool_t *pool)
+{
+    return bgpool_available(pool->bg);
+}
+
+void ecdsa_nonce_pool_stop(ecdsa_nonce_pool_t *pool)
+{
+    if (!pool) return;
+    bgpool_stop(pool->bg);
+    secure_wipe(pool, sizeof(*pool));
+    free(pool);
 }
 
 /* ── ECDSA verify ── */
 
+/* ecdsa_verify_digest for a public key known to be on the curve. */
+static int verify_digest_valid(const ec_domain_params_t *curve,
+                               const ec_point_t         *public_key,
+                               const uint8_t             digest[32],
+                               const uint8_t             sig_r[32],
+                               const uint8_t             sig_s[32])
+{
+    ec_curve_consts_t tmp_consts;
+    const scalar_mont_t *m = &ec_curve_consts(curve, &tmp_consts)->n_mont;
+
+    /* r, s ∈ [1, n-1] */
+    uint256_t r, s;
+    be_to_u256(sig_r, &r);
+    be_to_u256(sig_s, &s);
+    if (uint256_is_zero(&r) || uint256_cmp(&r, &m->n) >= 0) return 0;
+    if (uint256_is_zero(&s) || uint256_cmp(&s, &m->n) >= 0) return 0;
+
+    /* e = digest mod n */
+    uint256_t e;
+    hash_to_scalar(m, digest, &e);
+
+    /* w = s⁻¹ mod n;  u1 = e·w mod n,  u2 = r·w mod n */
+    uint256_t w, t, u1_u256, u2_u256;
+    scalar_to_mont(m, &s, &t);
+    scalar_inv(m, &t, &w);
+    scalar_to_mont(m, &e, &t);
+    scalar_mul(m, &t, &w, &u1_u256);
+    scalar_from_mont(m, &u1_u256, &u1_u256);
+    scalar_to_mont(m, &r, &t);
+    scalar_mul(m, &t, &w, &u2_u256);
+    scalar_from_mont(m, &u2_u256, &u2_u256);
+
+    /* X = u1·G + u2·Q in one interleaved pass. Variable time is safe:
+     * u1, u2 come from the public hash and signature, G and Q are public. */
+    uint256_t u[2] = { u1_u256, u2_u256 };
+    ec_point_t pts[2] = { curve->G, *public_key };
+    ec_point_t X;
+    ec_multi_scalar_multiply_vartime(curve, u, pts, 2, &X);
+
+    /* Accept iff x(X) mod n == r, checked projectively so no inversion is
+     * needed: x = X/Z^2, and x mod n == r means x == r or (if r + n < p)
+     * x == r + n, because x < p. */
+    int result = 0;
+    if (!X.infinity) {
+        uint256_t r_u256 = r, z2, rz2, pn;
+        fe_sqr(curve, &X.z, &z2);
+
+        fe_mul(curve, &r_u256, &z2, &rz2);
+        result = uint256_cmp(&rz2, &X.x) == 0;
+
+        if (!result && uint256_cmp(&curve->p, &curve->n) > 0) {
+            uint256_sub(&curve->p, &curve->n, &pn);
+            if (uint256_cmp(&r_u256, &pn) < 0) {
+                uint256_add(&r_u256, &curve->n, &r_u256);
+                fe_mul(curve, &r_u256, &z2, &rz2);
+                result = uint256_cmp(&rz2, &X.x) == 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+int ecdsa_verify_digest(const ec_domain_params_t *curve,
+                        const ec_point_t         *public_key,
+                        const uint8_t             digest[32],
+                        const uint8_t             sig_r[32],
+                        const uint8_t             sig_s[32])
+{
+    if (!public_key || !digest || !sig_r || !sig_s) return -1;
+
+    if (public_key->infinity || !ec_point_on_curve(curve, public_key))
+        return -1;
+
+    return verify_digest_valid(curve, public_key, digest, sig_r, sig_s);
+}
+
+int ecdsa_verify_digest_trusted(const ec_domain_params_t *curve,
+                                const ec_affine_t        *public_key,
+                                const uint8_t             digest[32],
+                                const uint8_t             sig_r[32],
+                                const uint8_t             sig_s[32])
+{
+    ec_point_t Q;
+
+    if (!public_key || !digest || !sig_r || !sig_s) return -1;
+
+    ec_affine_to_point(public_key, &Q);
+    return verify_digest_valid(curve, &Q, digest, sig_r, sig_s);
+}
+
 int ecdsa_verify(const ec_domain_params_t *curve,
                  const ec_point_t         *public_key,
                  const uint8_t            *msg,
@@ -288,71 +837,45 @@ int ecdsa_verify(const ec_domain_params_t *curve,
                  const uint8_t             sig_r[32],
                  const uint8_t             sig_s[32])
 {
-    if (!public_key || !msg || !sig_r || !sig_s) return -1;
+    if (!msg) return -1;
 
-    if (public_key->infinity || !ec_point_on_curve(curve, public_key))
-        return -1;
-
-    /* Load n, r, s. */
-    mpz_t n, r, s;
-    mpz_inits(n, r, s, NULL);
-    u256_to_mpz(&curve->n, n);
-    mpz_import(r, 32, 1, 1, 0, 0, sig_r);
-    mpz_import(s, 32, 1, 1, 0, 0, sig_s);
+    uint8_t hash[32];
+    sha256(msg, msg_len, hash);
+    return ecdsa_verify_digest(curve, public_key, hash, sig_r, sig_s);
+}
 
-    /* r, s ∈ [1, n-1] */
-    if (mpz_sgn(r) <= 0 || mpz_cmp(r, n) >= 0) { mpz_clears(n, r, s, NULL); return 0; }
-    if (mpz_sgn(s) <= 0 || mpz_cmp(s, n) >= 0) { mpz_clears(n, r, s, NULL); return 0; }
+int ecdsa_verify_trusted(const ec_domain_params_t *curve,
+                         const ec_affine_t        *public_key,
+                         const uint8_t            *msg,
+                         size_t                    msg_len,
+                         const uint8_t             sig_r[32],
+                         const uint8_t             sig_s[32])
+{
+    if (!msg) return -1;
 
-    /* e = SHA-256(msg) mod n */
     uint8_t hash[32];
     sha256(msg, msg_len, hash);
-    mpz_t e;
-    mpz_init(e);
-    hash_to_mpz_mod_n(hash, n, e);
-
-    /* w = s⁻¹ mod n */
-    mpz_t w;
-    mpz_init(w);
-    if (!mpz_invert(w, s, n)) {
-        mpz_clears(n, r, s, e, w, NULL);
-        return -1;
-    }
+    return ecdsa_verify_digest_trusted(curve, public_key, hash, sig_r, sig_s);
+}
 
-    /* u1 = e·w mod n,  u2 = r·w mod n */
-    mpz_t u1, u2;
-    mpz_inits(u1, u2, NULL);
-    mpz_mul(u1, e, w); mpz_mod(u1, u1, n);
-    mpz_mul(u2, r, w); mpz_mod(u2, u2, n);
-
-    /* Convert u1, u2 back to uint256_t for EC operations. */
-    uint8_t u1_be[32], u2_be[32];
-    mpz_to_be32(u1, u1_be);
-    mpz_to_be32(u2, u2_be);
-    uint256_t u1_u256, u2_u256;
-    be_to_u256(u1_be, &u1_u256);
-    be_to_u256(u2_be, &u2_u256);
-
-    /* X = u1·G + u2·Q using Shamir's trick (single pass, variable-time).
-     * All inputs are public so variable-time is safe. */
-    ec_point_t X;
-    ec_mul2add_vartime(curve, &u1_u256, &curve->G, &u2_u256, public_key, &X);
+void ecdsa_verify_init(SHA256_ctx_t *ctx)
+{
+    sha256_init(ctx);
+}
 
-    int result = 0;
-    if (!X.infinity) {
-        ec_jacobian_to_affine(curve, &X, &X);
-
-        /* Accept iff X.x mod n == r */
-        uint8_t xcoord_be[32];
-        u256_to_be(&X.x, xcoord_be);
-        mpz_t x_mod_n;
-        mpz_init(x_mod_n);
-        mpz_import(x_mod_n, 32, 1, 1, 0, 0, xcoord_be);
-        mpz_mod(x_mod_n, x_mod_n, n);
-        result = (mpz_cmp(x_mod_n, r) == 0) ? 1 : 0;
-        mpz_clear(x_mod_n);
-    }
+void ecdsa_verify_update(SHA256_ctx_t *ctx, const uint8_t *data, size_t len)
+{
+    sha256_update(ctx, data, len);
+}
 
-    mpz_clears(n, r, s, e, w, u1, u2, NULL);
-    return result;
+int ecdsa_verify_final(SHA256_ctx_t             *ctx,
+                       const ec_domain_params_t *curve,
+                       const ec_point_t         *public_key,
+                       const uint8_t             sig_r[32],
+                       const uint8_t             sig_s[32])
+{
+    uint8_t hash[32];
+
+    sha256_final(ctx, hash);
+    return ecdsa_verify_digest(curve, public_key, hash, sig_r, sig_s);
 }
@@ -0,0 +1,364 @@
+/*
+ * field.c
+ *
+ * P-256 field multiplication. The 512-bit product comes from either a
+ * portable 4x4 schoolbook or, when the CPU has BMI2 and ADX, inline
+ * assembly that runs two independent carry chains (ADCX on CF, ADOX on
+ * OF) under MULX. Reduction uses the NIST FIPS 186 fast reduction for
+ * p = 2^256 - 2^224 + 2^192 + 2^96 - 1 and is shared by both products
+ * and by the 5x52 code in field_5x52.c.
+ * Nothing here branches on operand values.
+ */
+
+#include "field.h"
+#include "cpu_features.h"
+
+#include <string.h>
+
+typedef void (*mul_fn)(uint64_t t[8], const uint64_t a[4], const uint64_t b[4]);
+typedef void (*sqr_fn)(uint64_t t[8], const uint64_t a[4]);
+
+static const uint64_t P256[4] = {
+    0xffffffffffffffffULL, 0x00000000ffffffffULL,
+    0x0000000000000000ULL, 0xffffffff00000001ULL
+};
+
+/* ── portable products ── */
+
+#if defined(__SIZEOF_INT128__)
+static inline void mul64(uint64_t a, uint64_t b, uint64_t *lo, uint64_t *hi) {
+    unsigned __int128 p = (unsigned __int128)a * b;
+    *lo = (uint64_t)p;
+    *hi = (uint64_t)(p >> 64);
+}
+#else
+static inline void mul64(uint64_t a, uint64_t b, uint64_t *lo, uint64_t *hi) {
+    uint64_t a0 = a & 0xffffffffULL, a1 = a >> 32;
+    uint64_t b0 = b & 0xffffffffULL, b1 = b >> 32;
+    uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    uint64_t mid = (p00 >> 32) + (p01 & 0xffffffffULL) + (p10 & 0xffffffffULL);
+    *lo = (mid << 32) | (p00 & 0xffffffffULL);
+    *hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+}
+#endif
+
+/* t[k] += lo, carry chain through *carry (hi absorbs both carries: the
+ * high word of a 64x64 product is at most 2^64 - 2). */
+static inline void mac(uint64_t *t, uint64_t a, uint64_t b, uint64_t *carry) {
+    uint64_t lo, hi, s;
+    mul64(a, b, &lo, &hi);
+    s = *t + lo;
+    hi += s < lo;
+    s += *carry;
+    hi += s < *carry;
+    *t = s;
+    *carry = hi;
+}
+
+static void mul_4x4_portable(uint64_t t[8], const uint64_t a[4], const uint64_t b[4]) {
+    memset(t, 0, 8 * sizeof(uint64_t));
+    for (int i = 0; i < 4; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < 4; j++) {
+            mac(&t[i + j], a[j], b[i], &carry);
+        }
+        t[i + 4] = carry;
+    }
+}
+
+static void sqr_4x4_portable(uint64_t t[8], const uint64_t a[4]) {
+    uint64_t carry, top = 0;
+
+    /* off-diagonal products a_i * a_j, i < j */
+    memset(t, 0, 8 * sizeof(uint64_t));
+    for (int i = 0; i < 3; i++) {
+        carry = 0;
+        for (int j = i + 1; j < 4; j++) {
+            mac(&t[i + j], a[i], a[j], &carry);
+        }
+        t[i + 4] = carry;
+    }
+
+    /* double them */
+    for (int i = 0; i < 8; i++) {
+        uint64_t next = t[i] >> 63;
+        t[i] = (t[i] << 1) | top;
+        top = next;
+    }
+
+    /* add the squares a_i^2 at word 2i */
+    carry = 0;
+    for (int i = 0; i < 4; i++) {
+        uint64_t lo, hi, s;
+        mul64(a[i], a[i], &lo, &hi);
+        s = t[2 * i] + lo;
+        uint64_t c1 = s < lo;
+        t[2 * i] = s + carry;
+        c1 |= t[2 * i] < s;
+        s = t[2 * i + 1] + hi;
+        uint64_t c2 = s < hi;
+        t[2 * i + 1] = s + c1;
+        c2 |= t[2 * i + 1] < s;
+        carry = c2;
+    }
+}
+
+/* ── MULX / ADCX / ADOX products ── */
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HAVE_MULX_ASM 1
+
+/* One row of the product: accumulate a * b[i] into words i..i+4, where
+ * A0..A3 hold words i..i+3 and N receives word i+4. Low halves go into
+ * the OF chain, high halves into the CF chain; word i is final afterwards
+ * and is stored to r. */
+#define MUL_ROW(OFF, A0, A1, A2, A3, N)                 \
+    "movq " OFF "(%[b]), %%rdx\n\t"                     \
+    "xorl %k[lo], %k[lo]\n\t"                           \
+    "mulxq 0(%[a]), %[lo], %[hi]\n\t"                   \
+    "adoxq %[lo], %[" A0 "]\n\t"                        \
+    "adcxq %[hi], %[" A1 "]\n\t"                        \
+    "movq %[" A0 "], " OFF "(%[r])\n\t"                 \
+    "mulxq 8(%[a]), %[lo], %[hi]\n\t"                   \
+    "adoxq %[lo], %[" A1 "]\n\t"                        \
+    "adcxq %[hi], %[" A2 "]\n\t"                        \
+    "mulxq 16(%[a]), %[lo], %[hi]\n\t"                  \
+    "adoxq %[lo], %[" A2 "]\n\t"                        \
+    "adcxq %[hi], %[" A3 "]\n\t"                        \
+    "mulxq 24(%[a]), %[lo], %[" N "]\n\t"               \
+    "adoxq %[lo], %[" A3 "]\n\t"                        \
+    "adcxq %[z], %[" N "]\n\t"                          \
+    "adoxq %[z], %[" N "]\n\t"
+
+static void mul_4x4_mulx(uint64_t r[8], const uint64_t a[4], const uint64_t b[4]) {
+    uint64_t t0, t1, t2, t3, t4, lo, hi, z;
+
+    __asm__ volatile(
+        /* row 0 needs only the CF chain */
+        "movq 0(%[b]), %%rdx\n\t"
+        "xorl %k[z], %k[z]\n\t"
+        "mulxq 0(%[a]), %[t0], %[t1]\n\t"
+        "movq %[t0], 0(%[r])\n\t"
+        "mulxq 8(%[a]), %[lo], %[t2]\n\t"
+        "adcxq %[lo], %[t1]\n\t"
+        "mulxq 16(%[a]), %[lo], %[t3]\n\t"
+        "adcxq %[lo], %[t2]\n\t"
+        "mulxq 24(%[a]), %[lo], %[t4]\n\t"
+        "adcxq %[lo], %[t3]\n\t"
+        "adcxq %[z], %[t4]\n\t"
+
+        MUL_ROW("8",  "t1", "t2", "t3", "t4", "t0")
+        MUL_ROW("16", "t2", "t3", "t4", "t0", "t1")
+        MUL_ROW("24", "t3", "t4", "t0", "t1", "t2")
+
+        "movq %[t4], 32(%[r])\n\t"
+        "movq %[t0], 40(%[r])\n\t"
+        "movq %[t1], 48(%[r])\n\t"
+        "movq %[t2], 56(%[r])\n\t"
+        : [t0] "=&r"(t0), [t1] "=&r"(t1), [t2] "=&r"(t2), [t3] "=&r"(t3), [t4] "=&r"(t4),
+          [lo] "=&r"(lo), [hi] "=&r"(hi), [z] "=&r"(z)
+        : [a] "r"(a), [b] "r"(b), [r] "r"(r)
+        : "rdx", "cc", "memory");
+}
+
+static void sqr_4x4_mulx(uint64_t r[8], const uint64_t a[4]) {
+    uint64_t t1, t2, t3, t4, t5, t6, t7, lo, hi, z;
+
+    __asm__ volatile(
+        /* a0 * (a1, a2, a3) -> words 1..4, CF chain */
+        "movq 0(%[a]), %%rdx\n\t"
+        "xorl %k[z], %k[z]\n\t"
+        "mulxq 8(%[a]), %[t1], %[t2]\n\t"
+        "mulxq 16(%[a]), %[lo], %[t3]\n\t"
+        "adcxq %[lo], %[t2]\n\t"
+        "mulxq 24(%[a]), %[lo], %[t4]\n\t"
+        "adcxq %[lo], %[t3]\n\t"
+        "adcxq %[z], %[t4]\n\t"
+
+        /* a1 * (a2, a3) -> words 3..5, both chains */
+        "movq 8(%[a]), %%rdx\n\t"
+        "xorl %k[lo], %k[lo]\n\t"
+        "mulxq 16(%[a]), %[lo], %[hi]\n\t"
+        "adoxq %[lo], %[t3]\n\t"
+        "adcxq %[hi], %[t4]\n\t"
+        "mulxq 24(%[a]), %[lo], %[t5]\n\t"
+        "adoxq %[lo], %[t4]\n\t"
+        "adcxq %[z], %[t5]\n\t"
+        "adoxq %[z], %[t5]\n\t"
+
+        /* a2 * a3 -> words 5..6 */
+        "movq 16(%[a]), %%rdx\n\t"
+        "xorl %k[lo], %k[lo]\n\t"
+        "mulxq 24(%[a]), %[lo], %[t6]\n\t"
+        "adcxq %[lo], %[t5]\n\t"
+        "adcxq %[z], %[t6]\n\t"
+
+        /* double the off-diagonal sum, top bit into word 7 */
+        "xorl %k[t7], %k[t7]\n\t"
+        "addq %[t1], %[t1]\n\t"
+        "adcq %[t2], %[t2]\n\t"
+        "adcq %[t3], %[t3]\n\t"
+        "adcq %[t4], %[t4]\n\t"
+        "adcq %[t5], %[t5]\n\t"
+        "adcq %[t6], %[t6]\n\t"
+        "adcq %[z], %[t7]\n\t"
+
+        /* add the squares; MULX leaves the flags alone, so a single
+         * ADD/ADC chain runs through all four */
+        "movq 0(%[a]), %%rdx\n\t"
+        "mulxq %%rdx, %[lo], %[hi]\n\t"
+        "movq %[lo], 0(%[r])\n\t"
+        "addq %[hi], %[t1]\n\t"
+        "movq 8(%[a]), %%rdx\n\t"
+        "mulxq %%rdx, %[lo], %[hi]\n\t"
+        "adcq %[lo], %[t2]\n\t"
+        "adcq %[hi], %[t3]\n\t"
+        "movq 16(%[a]), %%rdx\n\t"
+        "mulxq %%rdx, %[lo], %[hi]\n\t"
+        "adcq %[lo], %[t4]\n\t"
+        "adcq %[hi], %[t5]\n\t"
+        "movq 24(%[a]), %%rdx\n\t"
+        "mulxq %%rdx, %[lo], %[hi]\n\t"
+        "adcq %[lo], %[t6]\n\t"
+        "adcq %[hi], %[t7]\n\t"
+
+        "movq %[t1], 8(%[r])\n\t"
+        "movq %[t2], 16(%[r])\n\t"
+        "movq %[t3], 24(%[r])\n\t"
+        "movq %[t4], 32(%[r])\n\t"
+        "movq %[t5], 40(%[r])\n\t"
+        "movq %[t6], 48(%[r])\n\t"
+        "movq %[t7], 56(%[r])\n\t"
+        : [t1] "=&r"(t1), [t2] "=&r"(t2), [t3] "=&r"(t3), [t4] "=&r"(t4),
+          [t5] "=&r"(t5), [t6] "=&r"(t6), [t7] "=&r"(t7),
+          [lo] "=&r"(lo), [hi] "=&r"(hi), [z] "=&r"(z)
+        : [a] "r"(a), [r] "r"(r)
+        : "rdx", "cc", "memory");
+}
+#endif
+
+/* ── reduction ── */
+
+/* r = t mod p for t = (hi : t[7..0]), per FIPS 186-4 D.2.3: with t split
+ * into 32-bit words c0..c17,
+ *   t = s1 + 2 s2 + 2 s3 + s4 + s5 - s6 - s7 - s8 - s9  (mod p)
+ * covers c0..c15, and the two words of hi enter through
+ * 2^512 and 2^544 mod p written the same way. The terms are summed per
+ * word in signed 64-bit accumulators, the carry out of word 7 is folded
+ * back twice using 2^256 = 2^224 - 2^192 - 2^96 + 1 (mod p), and one
+ * masked subtraction of p finishes the job. */
+static inline void p256_reduce_core(const uint64_t t[8], uint64_t hi, uint256_t *r) {
+    int64_t c[18], w[8], acc;
+    uint64_t v[4], d[4], borrow = 0, mask;
+
+    for (int i = 0; i < 8; i++) {
+        c[2 * i]     = (int64_t)(t[i] & 0xffffffffULL);
+        c[2 * i + 1] = (int64_t)(t[i] >> 32);
+    }
+    c[16] = (int64_t)(hi & 0xffffffffULL);
+    c[17] = (int64_t)(hi >> 32);
+
+    w[0] = c[0] + c[8]  + c[9]  - c[11] - c[12] - c[13] - c[14];
+    w[1] = c[1] + c[9]  + c[10] - c[12] - c[13] - c[14] - c[15];
+    w[2] = c[2] + c[10] + c[11] - c[13] - c[14] - c[15];
+    w[3] = c[3] + 2 * c[11] + 2 * c[12] + c[13] - c[15] - c[8] - c[9];
+    w[4] = c[4] + 2 * c[12] + 2 * c[13] + c[14] - c[9] - c[10];
+    w[5] = c[5] + 2 * c[13] + 2 * c[14] + c[15] - c[10] - c[11];
+    w[6] = c[6] + 3 * c[14] + 2 * c[15] + c[13] - c[8] - c[9];
+    w[7] = c[7] + 3 * c[15] + c[8] - c[10] - c[11] - c[12] - c[13];
+
+    /* 2^512 = (3, 0, -1, -4, -1, 0, -2, 5)
+     * 2^544 = (5, 3, 0, -6, -4, -1, -5, 3) in words 0..7, mod p */
+    w[0] += 3 * c[16] + 5 * c[17];
+    w[1] += 3 * c[17];
+    w[2] -= c[16];
+    w[3] -= 4 * c[16] + 6 * c[17];
+    w[4] -= c[16] + 4 * c[17];
+    w[5] -= c[17];
+    w[6] -= 2 * c[16] + 5 * c[17];
+    w[7] += 5 * c[16] + 3 * c[17];
+
+    for (int round = 0; round < 3; round++) {
+        acc = 0;
+        for (int i = 0; i < 8; i++) {
+            acc += w[i];
+            w[i] = acc & 0xffffffffLL;
+            acc >>= 32; /* arithmetic shift: floor division by 2^32 */
+        }
+        /* the third pass always ends with acc == 0 */
+        w[0] += acc;
+        w[3] -= acc;
+        w[6] -= acc;
+        w[7] += acc;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        v[i] = (uint64_t)w[2 * i] | ((uint64_t)w[2 * i + 1] << 32);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        uint64_t diff = v[i] - P256[i];
+        uint64_t b1 = v[i] < P256[i];
+        d[i] = diff - borrow;
+        borrow = b1 | (diff < borrow);
+    }
+
+    mask = borrow - 1; /* all ones iff v >= p */
+    for (int i = 0; i < 4; i++) {
+        r->limb[i] = (d[i] & mask) | (v[i] & ~mask);
+    }
+}
+
+static void p256_reduce(const uint64_t t[8], uint256_t *r) {
+    p256_reduce_core(t, 0, r);
+}
+
+void p256_reduce_wide(const uint64_t t[9], uint256_t *r) {
+    p256_reduce_core(t, t[8], r);
+}
+
+/* ── dispatch ── */
+
+static mul_fn mul_impl = mul_4x4_portable;
+static sqr_fn sqr_impl = sqr_4x4_portable;
+
+void p256_field_select(int allow_asm) {
+    mul_impl = mul_4x4_portable;
+    sqr_impl = sqr_4x4_portable;
+
+#ifdef HAVE_MULX_ASM
+    unsigned need = EC_CPU_BMI2 | EC_CPU_ADX;
+    if (allow_asm && (ec_cpu_features() & need) == need) {
+        mul_impl = mul_4x4_mulx;
+        sqr_impl = sqr_4x4_mulx;
+    }
+#else
+    (void)allow_asm;
+#endif
+}
+
+const char *p256_field_backend(void) {
+#ifdef HAVE_MULX_ASM
+    if (mul_impl == mul_4x4_mulx) return "mulx-adx";
+#endif
+    return "portable";
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+/* pick the backend once, when the library is loaded */
+__attribute__((constructor)) static void p256_field_init(void) {
+    p256_field_select(1);
+}
+#endif
+
+void p256_mul(const uint256_t *a, const uint256_t *b, uint256_t *r) {
+    uint64_t t[8];
+    mul_impl(t, a->limb, b->limb);
+    p256_reduce(t, r);
+}
+
+void p256_sqr(const uint256_t *a, uint256_t *r) {
+    uint64_t t[8];
+    sqr_impl(t, a->limb);
+    p256_reduce(t, r);
+}
@@ -0,0 +1,143 @@
+/*
+ * field_5x52.c
+ *
+ * P-256 field elements as five 52-bit limbs in 64-bit words. The twelve
+ * spare bits of every limb absorb additions and subtractions, so those
+ * never carry or reduce; the carries are resolved once, inside the
+ * multiplication. The product is formed in nine 128-bit column sums and
+ * reduced in place by Montgomery's method with R = 2^260: since
+ * p = -1 mod 2^52, the multiplier for each column is just its low 52
+ * bits, and m p is four shifted copies of m. Magnitude rules are in
+ * field.h. Nothing here branches on operand values.
+ */
+
+#include "field.h"
+
+#ifdef FE52_AVAILABLE
+
+#define M52 0xfffffffffffffULL
+#define M48 0xffffffffffffULL
+
+/* 2^520 mod p, so that fe52_mul by it moves a value into the domain */
+static const fe52_t FE52_R2 = {{
+    0x300ULL, 0xffffffff00000ULL, 0xffffefffffffbULL, 0xfdfffffffffffULL, 0x4ffffffULL,
+}};
+
+typedef unsigned __int128 u128;
+
+void fe52_from_u256(fe52_t *r, const uint256_t *a) {
+    const uint64_t *l = a->limb;
+    r->n[0] = l[0] & M52;
+    r->n[1] = ((l[0] >> 52) | (l[1] << 12)) & M52;
+    r->n[2] = ((l[1] >> 40) | (l[2] << 24)) & M52;
+    r->n[3] = ((l[2] >> 28) | (l[3] << 36)) & M52;
+    r->n[4] = l[3] >> 16;
+}
+
+/* Carry into 52-bit limbs, pack into 64-bit words and reduce fully. */
+void fe52_to_u256(uint256_t *r, const fe52_t *a) {
+    uint64_t l[4], t[9] = {0};
+    uint64_t c = 0;
+
+    /* limbs below 2^60, so the running carry stays below 2^9 */
+    for (int i = 0; i < 4; i++) {
+        c += a->n[i];
+        l[i] = c & M52;
+        c >>= 52;
+    }
+    c += a->n[4]; /* may exceed 52 bits; t[4] keeps the excess */
+
+    t[0] = l[0]         | (l[1] << 52);
+    t[1] = (l[1] >> 12) | (l[2] << 40);
+    t[2] = (l[2] >> 24) | (l[3] << 28);
+    t[3] = (l[3] >> 36) | (c << 16);
+    t[4] = c >> 48;
+
+    p256_reduce_wide(t, r);
+}
+
+/* r = col * 2^-260 mod p, at magnitude 1. p in radix 2^52 is
+ * (2^52 - 1, 2^44 - 1, 0, 2^36, 2^48 - 2^16); adding m p clears the low
+ * limb of column i, whose carry together with m (2^44 - 1) becomes the
+ * m 2^44 below. After five rounds col[5..8] hold (col + M p) / 2^260,
+ * which is below 2^276 + p for FE52_MAX_MAG inputs. The part h above
+ * 2^256, below 2^21, is folded back through 2^256 = 2^224 - 2^192 -
+ * 2^96 + 1 (mod p) in one signed carry pass; the sum stays below
+ * 2^256 + 2^245, so the top limb ends below 2^52. */
+static void fe52_finish(fe52_t *r, u128 col[9]) {
+    uint64_t l[5], h;
+    __int128 s;
+    u128 c;
+
+    for (int i = 0; i < 5; i++) {
+        uint64_t m = (uint64_t)col[i] & M52;
+        col[i + 1] += (col[i] >> 52) + ((u128)m << 44);
+        col[i + 3] += (u128)m << 36;
+        col[i + 4] += (u128)m * 0xffffffff0000ULL;
+    }
+
+    c = col[5];
+    for (int k = 0; k < 3; k++) {
+        l[k] = (uint64_t)c & M52;
+        c = (c >> 52) + col[6 + k];
+    }
+    l[3] = (uint64_t)c & M52;
+    c >>= 52;
+    l[4] = (uint64_t)c & M48;
+    h = (uint64_t)(c >> 48);
+
+    s = (__int128)l[0] + h;
+    r->n[0] = (uint64_t)s & M52;
+    s = (s >> 52) + l[1] - ((__int128)h << 44); /* arithmetic shifts */
+    r->n[1] = (uint64_t)s & M52;
+    s = (s >> 52) + l[2];
+    r->n[2] = (uint64_t)s & M52;
+    s = (s >> 52) + l[3] - ((__int128)h << 36);
+    r->n[3] = (uint64_t)s & M52;
+    s = (s >> 52) + l[4] + ((__int128)h << 16);
+    r->n[4] = (uint64_t)s;
+}
+
+void fe52_to_mont(fe52_t *r, const fe52_t *a) {
+    fe52_mul(r, a, &FE52_R2);
+}
+
+/* Column sums are below 5 * 2^120 for FE52_MAX_MAG inputs, which leaves
+ * room for the three 2^100 terms and the carry each gets in fe52_finish. */
+void fe52_mul(fe52_t *r, const fe52_t *a, const fe52_t *b) {
+    const uint64_t *x = a->n, *y = b->n;
+    u128 col[9];
+
+    col[0] = (u128)x[0] * y[0];
+    col[1] = (u128)x[0] * y[1] + (u128)x[1] * y[0];
+    col[2] = (u128)x[0] * y[2] + (u128)x[1] * y[1] + (u128)x[2] * y[0];
+    col[3] = (u128)x[0] * y[3] + (u128)x[1] * y[2] + (u128)x[2] * y[1] + (u128)x[3] * y[0];
+    col[4] = (u128)x[0] * y[4] + (u128)x[1] * y[3] + (u128)x[2] * y[2] + (u128)x[3] * y[1]
+           + (u128)x[4] * y[0];
+    col[5] = (u128)x[1] * y[4] + (u128)x[2] * y[3] + (u128)x[3] * y[2] + (u128)x[4] * y[1];
+    col[6] = (u128)x[2] * y[4] + (u128)x[3] * y[3] + (u128)x[4] * y[2];
+    col[7] = (u128)x[3] * y[4] + (u128)x[4] * y[3];
+    col[8] = (u128)x[4] * y[4];
+
+    fe52_finish(r, col);
+}
+
+void fe52_sqr(fe52_t *r, const fe52_t *a) {
+    const uint64_t *x = a->n;
+    uint64_t d0 = 2 * x[0], d1 = 2 * x[1], d2 = 2 * x[2], d3 = 2 * x[3];
+    u128 col[9];
+
+    col[0] = (u128)x[0] * x[0];
+    col[1] = (u128)d0 * x[1];
+    col[2] = (u128)d0 * x[2] + (u128)x[1] * x[1];
+    col[3] = (u128)d0 * x[3] + (u128)d1 * x[2];
+    col[4] = (u128)d0 * x[4] + (u128)d1 * x[3] + (u128)x[2] * x[2];
+    col[5] = (u128)d1 * x[4] + (u128)d2 * x[3];
+    col[6] = (u128)d2 * x[4] + (u128)x[3] * x[3];
+    col[7] = (u128)d3 * x[4];
+    col[8] = (u128)x[4] * x[4];
+
+    fe52_finish(r, col);
+}
+
+#endif /* FE52_AVAILABLE */
@@ -10,14 +10,11 @@
 #include <string.h>
 
 
-void hmac_sha256(const uint8_t *key, size_t key_len, const uint8_t *data, size_t data_len, uint8_t output[32]) {
-    
+void hmac_sha256_init(hmac_sha256_ctx_t *ctx, const uint8_t *key, size_t key_len) {
+
     uint8_t k[64];
-    uint8_t k_ipad[64];
-    uint8_t k_opad[64];
-    uint8_t inner_hash[32];
-    SHA256_ctx_t ctx;
-    
+    uint8_t pad[64];
+
     if (key_len > 64) {
         sha256(key, key_len, k);
         memset(k + 32, 0, 32);
@@ -26,24 +23,130 @@ void hmac_sha256(const uint8_t *key, size_t key_len, const uint8_t *data, size_t
         memset(k + key_len, 0, 64 - key_len);
     }
 
-    for (int i = 0; i < 64; i++) {
-        k_ipad[i] = k[i] ^ 0x36;
-        k_opad[i] = k[i] ^ 0x5c;
-    }
-
-    sha256_init(&ctx);
-    sha256_update(&ctx, k_ipad, 64);
-    sha256_update(&ctx, data, data_len);
-    sha256_final(&ctx, inner_hash);
+    for (int i = 0; i < 64; i++) pad[i] = k[i] ^ 0x36;
+    sha256_init(&ctx->inner);
+    sha256_update(&ctx->inner, pad, 64);
 
-    sha256_init(&ctx);
-    sha256_update(&ctx, k_opad, 64);
-    sha256_update(&ctx, inner_hash, 32);
-    sha256_final(&ctx, output);
+    for (int i = 0; i < 64; i++) pad[i] = k[i] ^ 0x5c;
+    sha256_init(&ctx->outer);
+    sha256_update(&ctx->outer, pad, 64);
 
-    secure_wipe(&ctx, sizeof(ctx));
     secure_wipe(k, 64);
-    secure_wipe(k_ipad, 64);
-    secure_wipe(k_opad, 64);
+    secure_wipe(pad, 64);
+}
+
+void hmac_sha256_update(hmac_sha256_ctx_t *ctx, const uint8_t *data, size_t data_len) {
+    sha256_update(&ctx->inner, data, data_len);
+}
+
+void hmac_sha256_final(hmac_sha256_ctx_t *ctx, uint8_t output[32]) {
+
+    uint8_t inner_hash[32];
+
+    sha256_final(&ctx->inner, inner_hash);
+    sha256_update(&ctx->outer, inner_hash, 32);
+    sha256_final(&ctx->outer, output);
+
     secure_wipe(inner_hash, 32);
+    secure_wipe(ctx, sizeof(*ctx));
+}
+
+void hmac_sha256_clone(hmac_sha256_ctx_t *dst, const hmac_sha256_ctx_t *src) {
+    sha256_clone(&dst->inner, &src->inner);
+    sha256_clone(&dst->outer, &src->outer);
+}
+
+void hmac_sha256_init_lanes(hmac_sha256_ctx_t *ctx, const uint8_t *const *key, size_t key_len,
+                            size_t n) {
+
+    uint8_t k[SHA256_LANES][64];
+    uint8_t pad[2 * SHA256_LANES][64];
+    SHA256_ctx_t *c[2 * SHA256_LANES];
+    const uint8_t *p[2 * SHA256_LANES];
+    size_t len[2 * SHA256_LANES];
+
+    for (; n > SHA256_LANES; n -= SHA256_LANES) {
+        hmac_sha256_init_lanes(ctx, key, key_len, SHA256_LANES);
+        ctx += SHA256_LANES;
+        key += SHA256_LANES;
+    }
+
+    /* inner and outer pads of every lane go through one multi-buffer update */
+    for (size_t l = 0; l < n; l++) {
+        if (key_len > 64) {
+            sha256(key[l], key_len, k[l]);
+            memset(k[l] + 32, 0, 32);
+        } else {
+            memcpy(k[l], key[l], key_len);
+            memset(k[l] + key_len, 0, 64 - key_len);
+        }
+        for (int i = 0; i < 64; i++) {
+            pad[l][i] = k[l][i] ^ 0x36;
+            pad[n + l][i] = k[l][i] ^ 0x5c;
+        }
+        sha256_init(&ctx[l].inner);
+        sha256_init(&ctx[l].outer);
+        c[l] = &ctx[l].inner;
+        c[n + l] = &ctx[l].outer;
+        p[l] = pad[l];
+        p[n + l] = pad[n + l];
+        len[l] = len[n + l] = 64;
+    }
+    sha256_update_lanes(c, p, len, 2 * n);
+
+    secure_wipe(k, sizeof(k));
+    secure_wipe(pad, sizeof(pad));
+}
+
+void hmac_sha256_update_lanes(hmac_sha256_ctx_t *ctx, const uint8_t *const *data,
+                              const size_t *data_len, size_t n) {
+
+    SHA256_ctx_t *c[SHA256_LANES];
+
+    for (; n > SHA256_LANES; n -= SHA256_LANES) {
+        hmac_sha256_update_lanes(ctx, data, data_len, SHA256_LANES);
+        ctx += SHA256_LANES;
+        data += SHA256_LANES;
+        data_len += SHA256_LANES;
+    }
+
+    for (size_t l = 0; l < n; l++) c[l] = &ctx[l].inner;
+    sha256_update_lanes(c, data, data_len, n);
+}
+
+void hmac_sha256_final_lanes(hmac_sha256_ctx_t *ctx, uint8_t (*output)[32], size_t n) {
+
+    uint8_t inner_hash[SHA256_LANES][32];
+    SHA256_ctx_t *c[SHA256_LANES];
+    const uint8_t *p[SHA256_LANES];
+    size_t len[SHA256_LANES];
+
+    for (; n > SHA256_LANES; n -= SHA256_LANES) {
+        hmac_sha256_final_lanes(ctx, output, SHA256_LANES);
+        ctx += SHA256_LANES;
+        output += SHA256_LANES;
+    }
+
+    for (size_t l = 0; l < n; l++) c[l] = &ctx[l].inner;
+    sha256_final_lanes(c, inner_hash, n);
+
+    for (size_t l = 0; l < n; l++) {
+        c[l] = &ctx[l].outer;
+        p[l] = inner_hash[l];
+        len[l] = 32;
+    }
+    sha256_update_lanes(c, p, len, n);
+    sha256_final_lanes(c, output, n);
+
+    secure_wipe(inner_hash, sizeof(inner_hash));
+    secure_wipe(ctx, n * sizeof(*ctx));
+}
+
+void hmac_sha256(const uint8_t *key, size_t key_len, const uint8_t *data, size_t data_len, uint8_t output[32]) {
+
+    hmac_sha256_ctx_t ctx;
+
+    hmac_sha256_init(&ctx, key, key_len);
+    hmac_sha256_update(&ctx, data, data_len);
+    hmac_sha256_final(&ctx, output);
 }
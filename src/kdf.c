@@ -10,17 +10,31 @@
 
 #include <string.h>
 
+/* HMAC keyed with the default salt (HashLen zero bytes): the SHA-256
+ * midstates after the 0x36 and 0x5c key pads, precomputed so that an
+ * unsalted extract hashes only the IKM. */
+static const hmac_sha256_ctx_t zero_salt_hmac = {
+    .inner = { .bitlen = 512, .state = {
+        0xf454dead, 0x9725214f, 0x90daf2a0, 0xdf1228ea,
+        0x64e5750f, 0xa3924181, 0x824a932b, 0xf8e04e32 } },
+    .outer = { .bitlen = 512, .state = {
+        0xd385480f, 0x7abb6477, 0x37c9c538, 0x5dd82467,
+        0x8e043a72, 0x753434b0, 0xdeb82818, 0x361d45a6 } },
+};
+
 void hkdf_extract(const uint8_t *salt, size_t salt_len, const uint8_t *ikm, size_t ikm_len, uint8_t prk[32]) {
     
-    uint8_t default_salt[32] = {0};
+    hmac_sha256_ctx_t ctx;
     
     if (salt == NULL || salt_len == 0) {
-        salt = default_salt;
-        salt_len = 32;
+        hmac_sha256_clone(&ctx, &zero_salt_hmac);
+    } else {
+        hmac_sha256_init(&ctx, salt, salt_len);
     }
     
     // PRK = HMAC-Hash(salt, IKM)
-    hmac_sha256(salt, salt_len, ikm, ikm_len, prk);
+    hmac_sha256_update(&ctx, ikm, ikm_len);
+    hmac_sha256_final(&ctx, prk);
 }
 
 int hkdf_expand(const uint8_t prk[32],
@@ -36,30 +50,26 @@ int hkdf_expand(const uint8_t prk[32],
         return -1;
     }
     
+    hmac_sha256_ctx_t keyed, ctx;
     uint8_t T[32] = {0};
     size_t T_len = 0;
     size_t offset = 0;
     uint8_t counter = 1;
     
+    // the PRK key pads are hashed once for all blocks
+    hmac_sha256_init(&keyed, prk, 32);
+    
     while (offset < okm_len) {
-        uint8_t hmac_input[32 + 256 + 1];  // T || info || counter
-        size_t hmac_input_len = 0;
-        
-        // Build: T(i-1) || info || counter
+        // T(i) = HMAC-Hash(PRK, T(i-1) || info || counter)
+        hmac_sha256_clone(&ctx, &keyed);
         if (T_len > 0) {
-            memcpy(hmac_input, T, T_len);
-            hmac_input_len += T_len;
+            hmac_sha256_update(&ctx, T, T_len);
         }
-        
         if (info != NULL && info_len > 0) {
-            memcpy(hmac_input + hmac_input_len, info, info_len);
-            hmac_input_len += info_len;
+            hmac_sha256_update(&ctx, info, info_len);
         }
-        
-        hmac_input[hmac_input_len++] = counter;
-        
-        // T(i) = HMAC-Hash(PRK, T(i-1) || info || counter)
-        hmac_sha256(prk, 32, hmac_input, hmac_input_len, T);
+        hmac_sha256_update(&ctx, &counter, 1);
+        hmac_sha256_final(&ctx, T);
         T_len = 32;
         
         size_t to_copy = (okm_len - offset < 32) ? (okm_len - offset) : 32;
@@ -67,10 +77,9 @@ int hkdf_expand(const uint8_t prk[32],
         offset += to_copy;
 
         counter++;
-
-        secure_wipe(hmac_input, hmac_input_len);
     }
 
+    secure_wipe(&keyed, sizeof(keyed));
     secure_wipe(T, 32);
     
     return 0;
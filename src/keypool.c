@@ -0,0 +1,83 @@
+/*
+ * keypool.c
+ *
+ * Background keypair pool on top of bgpool.c. See keypool.h.
+ */
+
+#include "keypool.h"
+#include "bgpool.h"
+#include "ec3dh.h"
+#include "secure_wipe.h"
+
+#include <stdlib.h>
+
+typedef struct {
+    uint256_t private_key;
+    ec_point_t pubkey;
+} pool_keypair_t;
+
+_Static_assert(sizeof(pool_keypair_t) <= BGPOOL_MAX_ITEM, "keypair fits a pool slot");
+
+struct ec3dh_pool {
+    const ec_domain_params_t *curve;
+    bgpool_t *bg;
+};
+
+/* one batch of keypairs sharing their final normalization */
+static int produce_keypairs(void *ctx, void *items, size_t n) {
+    const ec3dh_pool_t *pool = (const ec3dh_pool_t *)ctx;
+    pool_keypair_t *out = (pool_keypair_t *)items;
+    uint256_t d[BGPOOL_BATCH];
+    ec_point_t Q[BGPOOL_BATCH];
+
+    if (ec3dh_generate_keypairs(pool->curve, d, Q, n) != EC3DH_OK) return -1;
+    for (size_t i = 0; i < n; i++) {
+        out[i].private_key = d[i];
+        out[i].pubkey = Q[i];
+    }
+    secure_wipe(d, sizeof(d));
+    return 0;
+}
+
+int ec3dh_pool_start(ec3dh_pool_t **pool, const ec_domain_params_t *curve,
+                     size_t low, size_t high, unsigned threads) {
+    ec3dh_pool_t *p;
+
+    if (!pool) return EC3DH_ERR_POOL;
+    *pool = NULL;
+    if (!curve) return EC3DH_ERR_POOL;
+
+    p = (ec3dh_pool_t *)calloc(1, sizeof(*p));
+    if (!p) return EC3DH_ERR_POOL;
+    p->curve = curve;
+    if (bgpool_start(&p->bg, sizeof(pool_keypair_t), low, high, threads,
+                     produce_keypairs, p) != 0) {
+        free(p);
+        return EC3DH_ERR_POOL;
+    }
+
+    *pool = p;
+    return EC3DH_OK;
+}
+
+int ec3dh_take_keypair(ec3dh_pool_t *pool, uint256_t *private_key, ec_point_t *pubkey) {
+    pool_keypair_t kp;
+
+    if (bgpool_take(pool->bg, &kp) < 0) {
+        return ec3dh_generate_keypair(pool->curve, private_key, pubkey);
+    }
+    *private_key = kp.private_key;
+    *pubkey = kp.pubkey;
+    secure_wipe(&kp, sizeof(kp));
+    return EC3DH_OK;
+}
+
+size_t ec3dh_pool_available(const ec3dh_pool_t *pool) {
+    return bgpool_available(pool->bg);
+}
+
+void ec3dh_pool_stop(ec3dh_pool_t *pool) {
+    if (!pool) return;
+    bgpool_stop(pool->bg);
+    free(pool);
+}
@@ -0,0 +1,280 @@
+/*
+ * keystore.c
+ *
+ * Writer and memory-mapped reader for the public key store. See
+ * keystore.h for the file layout.
+ */
+
+#include "keystore.h"
+#include "curve_params.h"
+#include "sha256.h"
+
+#include <modplus.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define KS_MAGIC      "EC3DHKS1"
+#define KS_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    uint8_t  magic[8];
+    uint32_t version;
+    uint32_t curve_id;
+    uint32_t record_size;
+    uint32_t byte_order;
+    uint64_t count;
+    uint8_t  checksum[32];
+} ks_header_t;
+
+_Static_assert(sizeof(ks_header_t) == EC_KEYSTORE_HEADER_LEN, "keystore header layout");
+_Static_assert(sizeof(ec_affine_t) == 64 && EC_KEYSTORE_HEADER_LEN % _Alignof(ec_affine_t) == 0,
+               "keystore records are aligned ec_affine_t");
+
+static int u256_eq(const uint256_t *a, const uint256_t *b) {
+    return memcmp(a->limb, b->limb, sizeof(a->limb)) == 0;
+}
+
+/* Built-in curve id for curve, or 0 if it is not a built-in curve. */
+static uint32_t curve_id(const ec_domain_params_t *curve) {
+    const ec_domain_params_t *c = &secp256r1;
+
+    if (u256_eq(&curve->p, &c->p) && u256_eq(&curve->a, &c->a) && u256_eq(&curve->b, &c->b) &&
+        u256_eq(&curve->n, &c->n) && u256_eq(&curve->G.x, &c->G.x) &&
+        u256_eq(&curve->G.y, &c->G.y)) {
+        return EC_KEYSTORE_CURVE_SECP256R1;
+    }
+    return 0;
+}
+
+/* Affine record for P. Returns 0, or -1 if P is not a valid key. */
+static int make_record(const ec_domain_params_t *curve, const ec_point_t *P, ec_affine_t *rec) {
+    ec_point_t A;
+
+    if (P->infinity) return -1;
+    ec_jacobian_to_affine(curve, P, &A);
+    if (A.infinity || uint256_cmp(&A.x, &curve->p) >= 0 || uint256_cmp(&A.y, &curve->p) >= 0 ||
+        !ec_point_on_curve(curve, &A)) {
+        return -1;
+    }
+
+    rec->x = A.x;
+    rec->y = A.y;
+    return 0;
+}
+
+/* Create a new file next to path, named path.XXXXXX with a unique
+ * suffix, and open it for writing. The name goes to tmp. Public keys
+ * only, so the file is made readable by everyone, as fopen would. */
+static FILE *create_temp(const char *path, char *tmp, size_t tmp_len) {
+    FILE *f;
+    int fd;
+
+    if ((size_t)snprintf(tmp, tmp_len, "%s.XXXXXX", path) >= tmp_len) return NULL;
+#if defined(_WIN32)
+    if (_mktemp_s(tmp, tmp_len) != 0) return NULL;
+    fd = _open(tmp, _O_CREAT | _O_EXCL | _O_WRONLY | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if (fd < 0) return NULL;
+    f = _fdopen(fd, "wb");
+    if (!f) _close(fd);
+#else
+    fd = mkstemp(tmp);
+    if (fd < 0) return NULL;
+    f = fchmod(fd, 0644) == 0 ? fdopen(fd, "wb") : NULL;
+    if (!f) close(fd);
+#endif
+    if (!f) remove(tmp);
+    return f;
+}
+
+/* Push f's contents to the disk and close it. Returns 0 or -1. */
+static int sync_close(FILE *f) {
+    int ok = fflush(f) == 0;
+#if defined(_WIN32)
+    ok = ok && _commit(_fileno(f)) == 0;
+#else
+    ok = ok && fsync(fileno(f)) == 0;
+#endif
+    return (fclose(f) == 0 && ok) ? 0 : -1;
+}
+
+static int replace_file(const char *tmp, const char *path) {
+#if defined(_WIN32)
+    return MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+    return rename(tmp, path);
+#endif
+}
+
+/* Records are built, hashed and written in one pass; the header goes out
+ * first with a zero checksum and is rewritten at the end. */
+int ec_keystore_write(const char *path, const ec_domain_params_t *curve,
+                      const ec_point_t *keys, size_t n) {
+    ks_header_t hdr;
+    SHA256_ctx_t ctx;
+    ec_affine_t rec;
+    char tmp[4096];
+    FILE *f;
+    int ret = EC_KEYSTORE_OK;
+
+    if (!path || !curve || (n && !keys)) return EC_KEYSTORE_ERR_IO;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, KS_MAGIC, sizeof(hdr.magic));
+    hdr.version = EC_KEYSTORE_VERSION;
+    hdr.curve_id = curve_id(curve);
+    hdr.record_size = (uint32_t)sizeof(ec_affine_t);
+    hdr.byte_order = KS_BYTE_ORDER;
+    hdr.count = (uint64_t)n;
+    if (hdr.curve_id == 0) return EC_KEYSTORE_ERR_CURVE;
+
+    f = create_temp(path, tmp, sizeof(tmp));
+    if (!f) return EC_KEYSTORE_ERR_IO;
+
+    if (fwrite(&hdr, sizeof(hdr), 1, f) != 1) ret = EC_KEYSTORE_ERR_IO;
+    sha256_init(&ctx);
+    for (size_t i = 0; i < n && ret == EC_KEYSTORE_OK; i++) {
+        if (make_record(curve, &keys[i], &rec) < 0) {
+            ret = EC_KEYSTORE_ERR_KEY;
+        } else {
+            sha256_update(&ctx, (const uint8_t *)&rec, sizeof(rec));
+            if (fwrite(&rec, sizeof(rec), 1, f) != 1) ret = EC_KEYSTORE_ERR_IO;
+        }
+    }
+    sha256_final(&ctx, hdr.checksum);
+
+    if (ret == EC_KEYSTORE_OK &&
+        (fseek(f, 0, SEEK_SET) != 0 || fwrite(&hdr, sizeof(hdr), 1, f) != 1)) {
+        ret = EC_KEYSTORE_ERR_IO;
+    }
+    if (sync_close(f) != 0 && ret == EC_KEYSTORE_OK) ret = EC_KEYSTORE_ERR_IO;
+    if (ret == EC_KEYSTORE_OK && replace_file(tmp, path) != 0) ret = EC_KEYSTORE_ERR_IO;
+
+    if (ret != EC_KEYSTORE_OK) remove(tmp);
+    return ret;
+}
+
+/* Map the whole file read-only. Returns 0 and sets *map / *len, or -1. */
+static int map_file(const char *path, void **map, size_t *len) {
+#if defined(_WIN32)
+    HANDLE file, mapping;
+    LARGE_INTEGER size;
+
+    file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                       OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return -1;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 ||
+        (unsigned long long)size.QuadPart > (size_t)-1) {
+        CloseHandle(file);
+        return -1;
+    }
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return -1;
+    *map = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!*map) return -1;
+    *len = (size_t)size.QuadPart;
+    return 0;
+#else
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) return -1;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || (unsigned long long)st.st_size > (size_t)-1) {
+        close(fd);
+        return -1;
+    }
+    *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (*map == MAP_FAILED) {
+        *map = NULL;
+        return -1;
+    }
+    *len = (size_t)st.st_size;
+    return 0;
+#endif
+}
+
+static void unmap_file(void *map, size_t len) {
+#if defined(_WIN32)
+    (void)len;
+    UnmapViewOfFile(map);
+#else
+    munmap(map, len);
+#endif
+}
+
+static int check_header(const ks_header_t *hdr, size_t len, const ec_domain_params_t *curve) {
+    if (memcmp(hdr->magic, KS_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != EC_KEYSTORE_VERSION || hdr->byte_order != KS_BYTE_ORDER ||
+        hdr->record_size != sizeof(ec_affine_t)) {
+        return EC_KEYSTORE_ERR_FORMAT;
+    }
+    if (hdr->curve_id == 0 || hdr->curve_id != curve_id(curve)) {
+        return EC_KEYSTORE_ERR_CURVE;
+    }
+    if (hdr->count > (len - sizeof(*hdr)) / sizeof(ec_affine_t) ||
+        len - sizeof(*hdr) != hdr->count * sizeof(ec_affine_t)) {
+        return EC_KEYSTORE_ERR_FORMAT;
+    }
+    return EC_KEYSTORE_OK;
+}
+
+int ec_keystore_open(const char *path, const ec_domain_params_t *curve,
+                     unsigned flags, ec_keystore_t *ks) {
+    const ks_header_t *hdr;
+    void *map;
+    size_t len;
+    int ret;
+
+    if (!ks) return EC_KEYSTORE_ERR_IO;
+    memset(ks, 0, sizeof(*ks));
+    if (!path || !curve) return EC_KEYSTORE_ERR_IO;
+
+    if (map_file(path, &map, &len) < 0) return EC_KEYSTORE_ERR_IO;
+    if (len < sizeof(ks_header_t)) {
+        unmap_file(map, len);
+        return EC_KEYSTORE_ERR_FORMAT;
+    }
+
+    hdr = (const ks_header_t *)map;
+    ret = check_header(hdr, len, curve);
+
+    if (ret == EC_KEYSTORE_OK && !(flags & EC_KEYSTORE_NO_CHECKSUM)) {
+        uint8_t digest[32];
+        sha256((const uint8_t *)map + sizeof(*hdr), len - sizeof(*hdr), digest);
+        if (memcmp(digest, hdr->checksum, sizeof(digest)) != 0) {
+            ret = EC_KEYSTORE_ERR_CHECKSUM;
+        }
+    }
+
+    if (ret != EC_KEYSTORE_OK) {
+        unmap_file(map, len);
+        return ret;
+    }
+
+    ks->keys = (const ec_affine_t *)((const uint8_t *)map + sizeof(*hdr));
+    ks->count = (size_t)hdr->count;
+    ks->map = map;
+    ks->map_len = len;
+    return EC_KEYSTORE_OK;
+}
+
+void ec_keystore_close(ec_keystore_t *ks) {
+    if (!ks) return;
+    if (ks->map) unmap_file(ks->map, ks->map_len);
+    memset(ks, 0, sizeof(*ks));
+}
@@ -11,6 +11,7 @@
 
 #include "pk.h"
 #include "ec.h"
+#include "rng.h"
 #include "secure_wipe.h"
 
 #include <string.h>
@@ -80,11 +81,10 @@ ssize_t kp_getrandom_bytes(void *buf, size_t buflen, unsigned int flags) {
 
 int kp_generate_private_key(const ec_domain_params_t *curve, uint256_t *private_key) {
     unsigned char bytes[BUFLEN];
-    ssize_t result;
 
     do {
-        result = kp_getrandom_bytes(bytes, BUFLEN, 0);
-        if (result < 0) {
+        /* buffered per-thread generator, not a system call per key */
+        if (ec_rng_bytes(bytes, BUFLEN) < 0) {
             secure_wipe(bytes, BUFLEN);
             secure_wipe(private_key, sizeof(*private_key));
             return -1;
@@ -0,0 +1,180 @@
+/*
+ * rng.c
+ *
+ * Per-thread ChaCha20 generator with fast key erasure, and the callback
+ * hook. See rng.h.
+ */
+
+#include "rng.h"
+#include "pk.h"
+#include "secure_wipe.h"
+
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#if defined(_MSC_VER)
+#define RNG_TLS __declspec(thread)
+#else
+#define RNG_TLS _Thread_local
+#endif
+
+/* 16 ChaCha20 blocks per refill; the first 32 bytes become the next key */
+#define RNG_BUF_LEN 1024
+#define RNG_KEY_LEN 32
+
+typedef struct {
+    uint32_t key[8];
+    uint8_t buf[RNG_BUF_LEN];
+    size_t pos;                 /* next unread byte of buf */
+    uint64_t since_reseed;      /* bytes handed out since the last reseed */
+    int seeded;
+} rng_state_t;
+
+static RNG_TLS rng_state_t rng;
+
+static ec_rng_fn rng_fn = NULL;
+static void *rng_ctx = NULL;
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define QR(a, b, c, d)                                          \
+    do {                                                        \
+        a += b; d ^= a; d = ROTL32(d, 16);                      \
+        c += d; b ^= c; b = ROTL32(b, 12);                      \
+        a += b; d ^= a; d = ROTL32(d, 8);                       \
+        c += d; b ^= c; b = ROTL32(b, 7);                       \
+    } while (0)
+
+void chacha20_block(const uint32_t key[8], uint32_t counter, const uint32_t nonce[3],
+                    uint8_t out[64]) {
+    uint32_t in[16], x[16];
+
+    in[0] = 0x61707865; in[1] = 0x3320646e; in[2] = 0x79622d32; in[3] = 0x6b206574;
+    for (int i = 0; i < 8; i++) in[4 + i] = key[i];
+    in[12] = counter;
+    in[13] = nonce[0];
+    in[14] = nonce[1];
+    in[15] = nonce[2];
+
+    memcpy(x, in, sizeof(x));
+    for (int i = 0; i < 10; i++) {
+        QR(x[0], x[4], x[8],  x[12]);
+        QR(x[1], x[5], x[9],  x[13]);
+        QR(x[2], x[6], x[10], x[14]);
+        QR(x[3], x[7], x[11], x[15]);
+        QR(x[0], x[5], x[10], x[15]);
+        QR(x[1], x[6], x[11], x[12]);
+        QR(x[2], x[7], x[8],  x[13]);
+        QR(x[3], x[4], x[9],  x[14]);
+    }
+
+    for (int i = 0; i < 16; i++) {
+        uint32_t v = x[i] + in[i];
+        out[4 * i + 0] = (uint8_t)v;
+        out[4 * i + 1] = (uint8_t)(v >> 8);
+        out[4 * i + 2] = (uint8_t)(v >> 16);
+        out[4 * i + 3] = (uint8_t)(v >> 24);
+    }
+    secure_wipe(x, sizeof(x));
+    secure_wipe(in, sizeof(in));
+}
+
+#if !defined(_WIN32)
+static pthread_key_t rng_exit_key;
+static int rng_exit_key_ok = 0;
+
+/* thread exit: do not leave the generator state behind in freed TLS */
+static void rng_thread_exit(void *state) {
+    secure_wipe(state, sizeof(rng_state_t));
+}
+
+/* runs in the child, whose only thread is the one that forked */
+static void rng_atfork_child(void) {
+    secure_wipe(&rng, sizeof(rng));
+}
+
+__attribute__((constructor)) static void rng_load(void) {
+    rng_exit_key_ok = pthread_key_create(&rng_exit_key, rng_thread_exit) == 0;
+    pthread_atfork(NULL, NULL, rng_atfork_child);
+}
+#endif
+
+/* Stream 16 blocks under the current key, then take the first 32 bytes
+ * as the next key so the state never holds what produced earlier output. */
+static void rng_refill(void) {
+    static const uint32_t nonce[3] = {0, 0, 0};
+
+    for (uint32_t i = 0; i < RNG_BUF_LEN / 64; i++) {
+        chacha20_block(rng.key, i, nonce, rng.buf + 64 * i);
+    }
+    for (int i = 0; i < 8; i++) {
+        const uint8_t *k = rng.buf + 4 * i;
+        rng.key[i] = (uint32_t)k[0] | (uint32_t)k[1] << 8 | (uint32_t)k[2] << 16 |
+                     (uint32_t)k[3] << 24;
+    }
+    secure_wipe(rng.buf, RNG_KEY_LEN);
+    rng.pos = RNG_KEY_LEN;
+}
+
+/* Mix fresh OS entropy into the key and drop any buffered output. */
+static int rng_reseed_from_os(void) {
+    uint32_t seed[8];
+
+    if (kp_getrandom_bytes(seed, sizeof(seed), 0) < 0) return -1;
+    for (int i = 0; i < 8; i++) rng.key[i] ^= seed[i];
+    secure_wipe(seed, sizeof(seed));
+
+#if !defined(_WIN32)
+    if (!rng.seeded && rng_exit_key_ok) pthread_setspecific(rng_exit_key, &rng);
+#endif
+    rng.seeded = 1;
+    rng.since_reseed = 0;
+    rng_refill();
+    return 0;
+}
+
+int ec_rng_bytes(void *buf, size_t len) {
+    uint8_t *out = (uint8_t *)buf;
+    ec_rng_fn fn = rng_fn;
+
+    if (fn) {
+        if (fn(rng_ctx, out, len) != 0) {
+            secure_wipe(buf, len);
+            return -1;
+        }
+        return 0;
+    }
+
+    if (!rng.seeded || rng.since_reseed >= EC_RNG_RESEED_BYTES) {
+        if (rng_reseed_from_os() < 0) {
+            secure_wipe(buf, len);
+            return -1;
+        }
+    }
+
+    while (len) {
+        size_t n;
+
+        if (rng.pos == RNG_BUF_LEN) rng_refill();
+        n = RNG_BUF_LEN - rng.pos;
+        if (n > len) n = len;
+        memcpy(out, rng.buf + rng.pos, n);
+        secure_wipe(rng.buf + rng.pos, n);
+        rng.pos += n;
+        rng.since_reseed += n;
+        out += n;
+        len -= n;
+    }
+    return 0;
+}
+
+void ec_rng_set_callback(ec_rng_fn fn, void *ctx) {
+    rng_ctx = ctx;
+    rng_fn = fn;
+}
+
+void ec_rng_reseed(void) {
+    rng.since_reseed = EC_RNG_RESEED_BYTES;
+}
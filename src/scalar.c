@@ -0,0 +1,200 @@
+/*
+ * scalar.c
+ *
+ * Montgomery arithmetic modulo the group order (CIOS, four 64-bit limbs).
+ * Nothing here branches on or indexes by operand values; the only
+ * data-dependent choices are masked selects after a trial subtraction.
+ * See scalar.h.
+ */
+
+#include "scalar.h"
+#include "secure_wipe.h"
+
+#include <string.h>
+
+#if defined(__SIZEOF_INT128__)
+static inline void mul64(uint64_t a, uint64_t b, uint64_t *lo, uint64_t *hi) {
+    unsigned __int128 p = (unsigned __int128)a * b;
+    *lo = (uint64_t)p;
+    *hi = (uint64_t)(p >> 64);
+}
+#else
+static inline void mul64(uint64_t a, uint64_t b, uint64_t *lo, uint64_t *hi) {
+    uint64_t a0 = a & 0xffffffffULL, a1 = a >> 32;
+    uint64_t b0 = b & 0xffffffffULL, b1 = b >> 32;
+    uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    uint64_t mid = (p00 >> 32) + (p01 & 0xffffffffULL) + (p10 & 0xffffffffULL);
+    *lo = (mid << 32) | (p00 & 0xffffffffULL);
+    *hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+}
+#endif
+
+/* returns t + a b + c, high word in *carry (cannot overflow 128 bits) */
+static inline uint64_t mac(uint64_t t, uint64_t a, uint64_t b, uint64_t *carry) {
+    uint64_t lo, hi, s;
+    mul64(a, b, &lo, &hi);
+    s = t + lo;
+    hi += s < lo;
+    s += *carry;
+    hi += s < *carry;
+    *carry = hi;
+    return s;
+}
+
+/* r = a - b over four limbs; returns the borrow (0 or 1) */
+static inline uint64_t sub4(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; i++) {
+        uint64_t d = a[i] - b[i];
+        uint64_t b1 = a[i] < b[i];
+        r[i] = d - borrow;
+        borrow = b1 | (d < borrow);
+    }
+    return borrow;
+}
+
+/* r = a + b over four limbs; returns the carry (0 or 1) */
+static inline uint64_t add4(uint64_t r[4], const uint64_t a[4], const uint64_t b[4]) {
+    uint64_t carry = 0;
+    for (int i = 0; i < 4; i++) {
+        uint64_t s = a[i] + carry;
+        uint64_t c1 = s < carry;
+        r[i] = s + b[i];
+        carry = c1 | (r[i] < s);
+    }
+    return carry;
+}
+
+/* r = (sel ? a : b) */
+static inline void select4(uint64_t r[4], uint64_t sel, const uint64_t a[4], const uint64_t b[4]) {
+    uint64_t mask = 0 - sel;
+    for (int i = 0; i < 4; i++) r[i] = (a[i] & mask) | (b[i] & ~mask);
+}
+
+/* r = v mod n for v = hi 2^256 + t, v < 2n */
+static inline void final_sub(const scalar_mont_t *m, uint64_t r[4], const uint64_t t[4], uint64_t hi) {
+    uint64_t d[4];
+    uint64_t borrow = sub4(d, t, m->n.limb);
+    /* keep t only if it was already below n */
+    select4(r, borrow & (hi ^ 1), t, d);
+}
+
+static void mont_mul(const scalar_mont_t *m, const uint64_t a[4], const uint64_t b[4], uint64_t r[4]) {
+    const uint64_t *n = m->n.limb;
+    uint64_t t[4] = {0}, t4 = 0, t5, c, u;
+
+    for (int i = 0; i < 4; i++) {
+        c = 0;
+        for (int j = 0; j < 4; j++) t[j] = mac(t[j], a[j], b[i], &c);
+        t4 += c;
+        t5 = t4 < c;
+
+        u = t[0] * m->n0;
+        c = 0;
+        mac(t[0], u, n[0], &c);
+        for (int j = 1; j < 4; j++) t[j - 1] = mac(t[j], u, n[j], &c);
+        t[3] = t4 + c;
+        t4 = t5 + (t[3] < c);
+    }
+
+    final_sub(m, r, t, t4);
+}
+
+void scalar_mont_init(scalar_mont_t *m, const uint256_t *n) {
+    uint64_t x[4] = {0}, inv = 1;
+
+    m->n = *n;
+
+    /* Newton iteration for n^-1 mod 2^64: each step doubles the correct bits */
+    for (int i = 0; i < 6; i++) inv *= 2 - n->limb[0] * inv;
+    m->n0 = 0 - inv;
+
+    /* rr = 2^512 mod n by 512 modular doublings of 1 */
+    x[0] = 1;
+    for (int i = 0; i < 512; i++) {
+        uint64_t hi = add4(x, x, x), d[4];
+        uint64_t borrow = sub4(d, x, n->limb);
+        select4(x, borrow & (hi ^ 1), x, d);
+    }
+    memcpy(m->rr.limb, x, sizeof(x));
+}
+
+void scalar_to_mont(const scalar_mont_t *m, const uint256_t *a, uint256_t *r) {
+    mont_mul(m, a->limb, m->rr.limb, r->limb);
+}
+
+void scalar_from_mont(const scalar_mont_t *m, const uint256_t *a, uint256_t *r) {
+    static const uint64_t one[4] = {1, 0, 0, 0};
+    mont_mul(m, a->limb, one, r->limb);
+}
+
+void scalar_reduce(const scalar_mont_t *m, const uint256_t *a, uint256_t *r) {
+    uint256_t t;
+    scalar_to_mont(m, a, &t);
+    scalar_from_mont(m, &t, r);
+}
+
+void scalar_mul(const scalar_mont_t *m, const uint256_t *a, const uint256_t *b, uint256_t *r) {
+    mont_mul(m, a->limb, b->limb, r->limb);
+}
+
+void scalar_add(const scalar_mont_t *m, const uint256_t *a, const uint256_t *b, uint256_t *r) {
+    uint64_t t[4];
+    uint64_t hi = add4(t, a->limb, b->limb);
+    final_sub(m, r->limb, t, hi);
+}
+
+void scalar_sub(const scalar_mont_t *m, const uint256_t *a, const uint256_t *b, uint256_t *r) {
+    uint64_t t[4], u[4];
+    uint64_t borrow = sub4(t, a->limb, b->limb);
+    add4(u, t, m->n.limb);
+    select4(r->limb, borrow, u, t);
+}
+
+/* a^(n-2) with fixed 4-bit windows; the exponent is public, the table
+ * index is not secret. */
+void scalar_inv(const scalar_mont_t *m, const uint256_t *a, uint256_t *r) {
+    static const uint64_t two[4] = {2, 0, 0, 0};
+    uint64_t tbl[16][4], e[4], acc[4];
+
+    sub4(e, m->n.limb, two);
+
+    /* tbl[i] = a^i, tbl[0] = R mod n */
+    memcpy(tbl[1], a->limb, sizeof(tbl[1]));
+    mont_mul(m, tbl[1], tbl[1], tbl[2]);
+    for (int i = 3; i < 16; i++) mont_mul(m, tbl[i - 1], tbl[1], tbl[i]);
+    {
+        uint256_t one = {{1, 0, 0, 0}}, rm;
+        scalar_to_mont(m, &one, &rm);
+        memcpy(tbl[0], rm.limb, sizeof(tbl[0]));
+    }
+
+    memcpy(acc, tbl[0], sizeof(acc));
+    for (int i = 63; i >= 0; i--) {
+        unsigned w = (unsigned)(e[i / 16] >> ((i % 16) * 4)) & 0xf;
+        for (int s = 0; s < 4; s++) mont_mul(m, acc, acc, acc);
+        mont_mul(m, acc, tbl[w], acc);
+    }
+    memcpy(r->limb, acc, sizeof(acc));
+}
+
+void scalar_inv_batch(const scalar_mont_t *m, const uint256_t *a, uint256_t *r, size_t n) {
+    uint256_t inv, t;
+
+    if (n == 0) return;
+
+    /* r[i] = a[0] ... a[i] */
+    r[0] = a[0];
+    for (size_t i = 1; i < n; i++) scalar_mul(m, &r[i - 1], &a[i], &r[i]);
+
+    /* walk back: inv = (a[0] ... a[i])^-1 at the top of each step */
+    scalar_inv(m, &r[n - 1], &inv);
+    for (size_t i = n - 1; i > 0; i--) {
+        scalar_mul(m, &inv, &r[i - 1], &t);
+        scalar_mul(m, &inv, &a[i], &inv);
+        r[i] = t;
+    }
+    r[0] = inv;
+    secure_wipe(&t, sizeof(t));
+    secure_wipe(&inv, sizeof(inv));
+}
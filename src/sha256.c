@@ -4,6 +4,8 @@
  */
 
 #include "sha256.h"
+#include "cpu_features.h"
+
 #include <string.h>
 
 #define ROTRIGHT(a, b)  (((a) >> (b)) | ((a) << (32-(b))))
@@ -99,17 +101,30 @@ void sha256_init(SHA256_ctx_t *ctx) {
 
 void sha256_update(SHA256_ctx_t *ctx, const uint8_t data[], size_t len) {
 
-    size_t i;
+    /* top up a partial block first */
+    if (ctx->datalen) {
+        size_t n = 64 - ctx->datalen;
+        if (n > len) n = len;
+        memcpy(ctx->data + ctx->datalen, data, n);
+        ctx->datalen += (uint32_t)n;
+        data += n;
+        len -= n;
+        if (ctx->datalen < 64) return;
+        sha256_transform(ctx, ctx->data);
+        ctx->bitlen += 512;
+        ctx->datalen = 0;
+    }
 
-    for (i = 0; i < len; ++i) {
-        ctx->data[ctx->datalen] = data[i];
-        ctx->datalen++;
-        if (ctx->datalen == 64) {
-            sha256_transform(ctx, ctx->data);
-            ctx->bitlen += 512;
-            ctx->datalen = 0;
-        }
+    /* whole blocks straight from the input, no copy */
+    while (len >= 64) {
+        sha256_transform(ctx, data);
+        ctx->bitlen += 512;
+        data += 64;
+        len -= 64;
     }
+
+    if (len) memcpy(ctx->data, data, len);
+    ctx->datalen = (uint32_t)len;
 }
 
 void sha256_final(SHA256_ctx_t *ctx, uint8_t hash[32]) {
@@ -159,3 +174,250 @@ void sha256(const uint8_t *data, size_t len, uint8_t hash[32]) {
     sha256_update(&ctx, data, len);
     sha256_final(&ctx, hash);
 }
+
+void sha256_clone(SHA256_ctx_t *dst, const SHA256_ctx_t *src) {
+    if (dst != src) memcpy(dst, src, sizeof(*dst));
+}
+
+void sha256_export_state(const SHA256_ctx_t *ctx, uint8_t out[SHA256_STATE_LEN]) {
+    uint64_t len = ctx->bitlen / 8 + ctx->datalen;
+
+    for (int i = 0; i < 8; i++) {
+        out[4 * i]     = (uint8_t)(ctx->state[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(ctx->state[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(ctx->state[i] >> 8);
+        out[4 * i + 3] = (uint8_t)ctx->state[i];
+    }
+    for (int i = 0; i < 8; i++) {
+        out[32 + i] = (uint8_t)(len >> (56 - 8 * i));
+    }
+    memcpy(out + 40, ctx->data, ctx->datalen);
+    memset(out + 40 + ctx->datalen, 0, 64 - ctx->datalen);
+}
+
+int sha256_import_state(SHA256_ctx_t *ctx, const uint8_t in[SHA256_STATE_LEN]) {
+    uint64_t len = 0;
+    uint32_t tail;
+    uint8_t pad = 0;
+
+    for (int i = 0; i < 8; i++) {
+        len = (len << 8) | in[32 + i];
+    }
+    /* the message length in bits must fit the 64-bit counter */
+    if (len >> 61) return -1;
+
+    tail = (uint32_t)(len % 64);
+    for (uint32_t i = tail; i < 64; i++) {
+        pad |= in[40 + i];
+    }
+    if (pad) return -1;
+
+    for (int i = 0; i < 8; i++) {
+        ctx->state[i] = (uint32_t)in[4 * i] << 24 | (uint32_t)in[4 * i + 1] << 16 |
+                        (uint32_t)in[4 * i + 2] << 8 | (uint32_t)in[4 * i + 3];
+    }
+    ctx->bitlen = (len - tail) * 8;
+    ctx->datalen = tail;
+    memcpy(ctx->data, in + 40, 64);
+    return 0;
+}
+
+/* ── multi-buffer ── */
+
+#define SIG0(x)         (ROTRIGHT(x, 7) ^ ROTRIGHT(x, 18) ^ ((x) >> 3))
+#define SIG1(x)         (ROTRIGHT(x, 17) ^ ROTRIGHT(x, 19) ^ ((x) >> 10))
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LANES_INLINE static inline __attribute__((always_inline))
+#else
+#define LANES_INLINE static inline
+#endif
+
+typedef void (*lanes_fn)(uint32_t *const *state, const uint8_t *const *block, size_t n);
+
+/*
+ * One block into each of n <= SHA256_LANES states. Every word is held
+ * for all lanes side by side (w[i][l]) and each step is a loop over the
+ * lanes with nothing carried between them, which the vectorizer maps
+ * onto whole registers; lanes past n compute on zeros and are dropped.
+ */
+LANES_INLINE void transform_lanes(uint32_t *const *state, const uint8_t *const *block, size_t n) {
+
+    uint32_t w[64][SHA256_LANES];
+    uint32_t a[SHA256_LANES], b[SHA256_LANES], c[SHA256_LANES], d[SHA256_LANES];
+    uint32_t e[SHA256_LANES], f[SHA256_LANES], g[SHA256_LANES], h[SHA256_LANES];
+    size_t i, l;
+
+    memset(w, 0, 16 * sizeof(w[0]));
+    memset(a, 0, sizeof(a)); memset(b, 0, sizeof(b));
+    memset(c, 0, sizeof(c)); memset(d, 0, sizeof(d));
+    memset(e, 0, sizeof(e)); memset(f, 0, sizeof(f));
+    memset(g, 0, sizeof(g)); memset(h, 0, sizeof(h));
+
+    for (l = 0; l < n; l++) {
+        for (i = 0; i < 16; i++) {
+            const uint8_t *p = block[l] + 4 * i;
+            w[i][l] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+        }
+        a[l] = state[l][0]; b[l] = state[l][1]; c[l] = state[l][2]; d[l] = state[l][3];
+        e[l] = state[l][4]; f[l] = state[l][5]; g[l] = state[l][6]; h[l] = state[l][7];
+    }
+
+    for (i = 16; i < 64; i++) {
+        for (l = 0; l < SHA256_LANES; l++) {
+            w[i][l] = w[i - 16][l] + SIG0(w[i - 15][l]) + w[i - 7][l] + SIG1(w[i - 2][l]);
+        }
+    }
+
+    for (i = 0; i < 64; i++) {
+        for (l = 0; l < SHA256_LANES; l++) {
+            uint32_t temp1 = h[l] + S1(e[l]) + CH(e[l], f[l], g[l]) + k[i] + w[i][l];
+            uint32_t temp2 = S0(a[l]) + MAJ(a[l], b[l], c[l]);
+
+            h[l] = g[l];
+            g[l] = f[l];
+            f[l] = e[l];
+            e[l] = d[l] + temp1;
+            d[l] = c[l];
+            c[l] = b[l];
+            b[l] = a[l];
+            a[l] = temp1 + temp2;
+        }
+    }
+
+    for (l = 0; l < n; l++) {
+        state[l][0] += a[l]; state[l][1] += b[l]; state[l][2] += c[l]; state[l][3] += d[l];
+        state[l][4] += e[l]; state[l][5] += f[l]; state[l][6] += g[l]; state[l][7] += h[l];
+    }
+}
+
+static void transform_lanes_c(uint32_t *const *state, const uint8_t *const *block, size_t n) {
+    transform_lanes(state, block, n);
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HAVE_AVX2_LANES 1
+
+/* the same C, compiled for 8 x 32-bit YMM lanes */
+__attribute__((target("avx2")))
+static void transform_lanes_avx2(uint32_t *const *state, const uint8_t *const *block, size_t n) {
+    transform_lanes(state, block, n);
+}
+#endif
+
+static lanes_fn lanes_impl = transform_lanes_c;
+
+void sha256_lanes_select(int level) {
+    lanes_impl = transform_lanes_c;
+
+#ifdef HAVE_AVX2_LANES
+    if (level >= 1 && (ec_cpu_features() & EC_CPU_AVX2)) {
+        lanes_impl = transform_lanes_avx2;
+    }
+#else
+    (void)level;
+#endif
+}
+
+const char *sha256_lanes_backend(void) {
+#ifdef HAVE_AVX2_LANES
+    if (lanes_impl == transform_lanes_avx2) return "avx2";
+#endif
+    return "c";
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((constructor)) static void sha256_lanes_load(void) {
+    sha256_lanes_select(1);
+}
+#endif
+
+void sha256_update_lanes(SHA256_ctx_t *const *ctx, const uint8_t *const *data,
+                         const size_t *len, size_t n) {
+
+    const uint8_t *in[SHA256_LANES], *blk[SHA256_LANES];
+    uint32_t *st[SHA256_LANES];
+    size_t left[SHA256_LANES];
+    size_t l, m;
+
+    for (; n > SHA256_LANES; n -= SHA256_LANES) {
+        sha256_update_lanes(ctx, data, len, SHA256_LANES);
+        ctx += SHA256_LANES;
+        data += SHA256_LANES;
+        len += SHA256_LANES;
+    }
+
+    for (l = 0; l < n; l++) {
+        in[l] = data[l];
+        left[l] = len[l];
+    }
+
+    /* each round takes one block from every lane that still has one:
+     * a topped-up partial block, else a whole block straight from the input */
+    for (;;) {
+        for (l = 0, m = 0; l < n; l++) {
+            SHA256_ctx_t *c = ctx[l];
+
+            if (c->datalen + left[l] < 64) continue;
+            if (c->datalen) {
+                size_t t = 64 - c->datalen;
+                memcpy(c->data + c->datalen, in[l], t);
+                in[l] += t;
+                left[l] -= t;
+                c->datalen = 0;
+                blk[m] = c->data;
+            } else {
+                blk[m] = in[l];
+                in[l] += 64;
+                left[l] -= 64;
+            }
+            c->bitlen += 512;
+            st[m++] = c->state;
+        }
+        if (!m) break;
+        lanes_impl(st, blk, m);
+    }
+
+    for (l = 0; l < n; l++) {
+        SHA256_ctx_t *c = ctx[l];
+        if (left[l]) memcpy(c->data + c->datalen, in[l], left[l]);
+        c->datalen += (uint32_t)left[l];
+    }
+}
+
+void sha256_final_lanes(SHA256_ctx_t *const *ctx, uint8_t (*hash)[32], size_t n) {
+
+    uint8_t pad[SHA256_LANES][72];
+    const uint8_t *p[SHA256_LANES] = {0};
+    size_t plen[SHA256_LANES] = {0};
+    size_t l;
+
+    for (; n > SHA256_LANES; n -= SHA256_LANES) {
+        sha256_final_lanes(ctx, hash, SHA256_LANES);
+        ctx += SHA256_LANES;
+        hash += SHA256_LANES;
+    }
+
+    /* 0x80, zeros up to 56 mod 64, then the bit length */
+    for (l = 0; l < n; l++) {
+        uint64_t bits = ctx[l]->bitlen + (uint64_t)ctx[l]->datalen * 8;
+
+        plen[l] = (ctx[l]->datalen < 56 ? 64 : 128) - ctx[l]->datalen;
+        memset(pad[l], 0, plen[l]);
+        pad[l][0] = 0x80;
+        for (int i = 0; i < 8; i++) {
+            pad[l][plen[l] - 1 - i] = (uint8_t)(bits >> (8 * i));
+        }
+        p[l] = pad[l];
+    }
+    sha256_update_lanes(ctx, p, plen, n);
+
+    for (l = 0; l < n; l++) {
+        for (int i = 0; i < 8; i++) {
+            hash[l][4 * i]     = (uint8_t)(ctx[l]->state[i] >> 24);
+            hash[l][4 * i + 1] = (uint8_t)(ctx[l]->state[i] >> 16);
+            hash[l][4 * i + 2] = (uint8_t)(ctx[l]->state[i] >> 8);
+            hash[l][4 * i + 3] = (uint8_t)ctx[l]->state[i];
+        }
+    }
+}
@@ -9,6 +9,7 @@
  *  - HKDF-SHA256:  RFC 5869 test cases 1 and 3
  *  - P-256 k*G:    well-known multiples of the base point
  *  - ECDH P-256:   NIST CAVP ECC CDH component test, vector 0
+ *  - ECDSA P-256:  RFC 6979 A.2.5, SHA-256, message "sample"
  *
  * All vectors were independently cross-checked against a separate
  * big-integer implementation before being embedded here.
@@ -22,11 +23,30 @@
 #include "hmac.h"
 #include "sha256.h"
 #include "codec.h"
-
+#include "field.h"
+#include "ct_select.h"
+#include "ec_lanes.h"
+#include "ecdsa.h"
+#include "gtable.h"
+#include "keystore.h"
+#include "scalar.h"
+#include "curve_consts.h"
+#include "rng.h"
+#include "keypool.h"
+
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 static int tests_run = 0;
 static int tests_failed = 0;
 
@@ -97,6 +117,15 @@ static int point_eq_affine(const ec_point_t *P, const char *x_hex, const char *y
     return !A.infinity && u256_eq(&A.x, &ex) && u256_eq(&A.y, &ey);
 }
 
+/* For tests that wait on background threads. */
+static void sleep_ms(unsigned ms) {
+#if defined(_WIN32)
+    Sleep(ms);
+#else
+    usleep(ms * 1000);
+#endif
+}
+
 /* ---------- SHA-256 ---------- */
 
 static void test_sha256_one(const uint8_t *msg, size_t len, const char *digest_hex, const char *name) {
@@ -131,6 +160,104 @@ static void test_sha256(void) {
     test_sha256_one(buf, 64,
         "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb",
         "sha256: 64-byte (exact block) message");
+
+    /* one million 'a', fed in uneven pieces across block boundaries */
+    {
+        static uint8_t a[200];
+        SHA256_ctx_t ctx;
+        uint8_t got[32], expected[32];
+        size_t left = 1000000, step = 1;
+        memset(a, 'a', sizeof(a));
+        sha256_init(&ctx);
+        while (left) {
+            size_t n = step < left ? step : left;
+            sha256_update(&ctx, a, n);
+            left -= n;
+            step = step % sizeof(a) + 1;
+        }
+        sha256_final(&ctx, got);
+        hex_to_bytes("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0", expected, 32);
+        check(memcmp(got, expected, 32) == 0, "sha256: million 'a' in uneven updates");
+    }
+
+    /* prefix hashed once, resumed by clone and by export/import */
+    {
+        static const char *msg = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+        SHA256_ctx_t prefix, ctx;
+        uint8_t st[SHA256_STATE_LEN], got[32], expected[32];
+        int ok = 1;
+        hex_to_bytes("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1", expected, 32);
+        for (size_t cut = 0; cut <= 56; cut += 7) {
+            sha256_init(&prefix);
+            sha256_update(&prefix, (const uint8_t *)msg, cut);
+
+            sha256_clone(&ctx, &prefix);
+            sha256_update(&ctx, (const uint8_t *)msg + cut, 56 - cut);
+            sha256_final(&ctx, got);
+            ok = ok && memcmp(got, expected, 32) == 0;
+
+            sha256_export_state(&prefix, st);
+            memset(&ctx, 0xa5, sizeof(ctx));
+            ok = ok && sha256_import_state(&ctx, st) == 0;
+            sha256_update(&ctx, (const uint8_t *)msg + cut, 56 - cut);
+            sha256_final(&ctx, got);
+            ok = ok && memcmp(got, expected, 32) == 0;
+        }
+        check(ok, "sha256: clone and export/import resume a prefix");
+
+        /* the encoding is fixed: IV, length 3, tail "abc" */
+        sha256_init(&ctx);
+        sha256_update(&ctx, (const uint8_t *)"abc", 3);
+        sha256_export_state(&ctx, st);
+        check(st[0] == 0x6a && st[31] == 0x19 && st[39] == 3 && st[38] == 0 &&
+              memcmp(st + 40, "abc", 3) == 0 && st[43] == 0,
+              "sha256: exported midstate layout");
+
+        st[43] = 1;
+        check(sha256_import_state(&ctx, st) == -1, "sha256: import rejects data past the tail");
+        st[43] = 0;
+        st[32] = 0x20;
+        check(sha256_import_state(&ctx, st) == -1, "sha256: import rejects an oversized length");
+    }
+}
+
+/* multi-buffer: more lanes than SHA256_LANES, unequal lengths, two
+ * updates that split blocks differently per lane */
+static void test_sha256_lanes_level(int level) {
+    enum { N = SHA256_LANES + 3 };
+    static uint8_t buf[N][200];
+    SHA256_ctx_t ctx[N], *cp[N];
+    const uint8_t *in[N];
+    size_t len[N], len2[N];
+    uint8_t got[N][32], want[32];
+    char name[64];
+    int ok = 1;
+
+    sha256_lanes_select(level);
+    for (int l = 0; l < N; l++) {
+        for (size_t i = 0; i < sizeof(buf[l]); i++) buf[l][i] = (uint8_t)(l * 31 + i * 7 + (i >> 3));
+        sha256_init(&ctx[l]);
+        cp[l] = &ctx[l];
+        in[l] = buf[l];
+        len[l] = (size_t)l * 7;
+        len2[l] = (size_t)l * 11 % 70;
+    }
+    sha256_update_lanes(cp, in, len, N);
+    for (int l = 0; l < N; l++) in[l] = buf[l] + len[l];
+    sha256_update_lanes(cp, in, len2, N);
+    sha256_final_lanes(cp, got, N);
+
+    for (int l = 0; l < N; l++) {
+        sha256(buf[l], len[l] + len2[l], want);
+        ok &= memcmp(got[l], want, 32) == 0;
+    }
+    snprintf(name, sizeof(name), "sha256: multi-buffer matches sha256 (%s)", sha256_lanes_backend());
+    check(ok, name);
+}
+
+static void test_sha256_lanes(void) {
+    test_sha256_lanes_level(0);
+    test_sha256_lanes_level(1);
 }
 
 /* ---------- HMAC-SHA256 (RFC 4231) ---------- */
@@ -172,6 +299,50 @@ static void test_hmac(void) {
         (const uint8_t *)"Test Using Larger Than Block-Size Key - Hash Key First", 54,
         "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54",
         "hmac: RFC 4231 test case 6 (long key)");
+
+    /* incremental, twice from one keyed context */
+    {
+        hmac_sha256_ctx_t keyed, ctx;
+        uint8_t expected[32], got[32];
+        int ok = 1;
+        hex_to_bytes("5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843", expected, 32);
+        hmac_sha256_init(&keyed, (const uint8_t *)"Jefe", 4);
+        for (int i = 0; i < 2; i++) {
+            hmac_sha256_clone(&ctx, &keyed);
+            hmac_sha256_update(&ctx, (const uint8_t *)"what do ya ", 11);
+            hmac_sha256_update(&ctx, (const uint8_t *)"want for nothing?", 17);
+            hmac_sha256_final(&ctx, got);
+            ok = ok && memcmp(got, expected, 32) == 0;
+        }
+        check(ok, "hmac: incremental context reused under one key");
+    }
+
+    /* multi-buffer, with short and hashed (over 64-byte) keys */
+    for (size_t key_len = 32; key_len <= 96; key_len += 64) {
+        enum { N = SHA256_LANES + 1 };
+        uint8_t keys[N][96], data[N][80], got[N][32], want[32];
+        hmac_sha256_ctx_t ctx[N];
+        const uint8_t *kp[N], *dp[N];
+        size_t dlen[N];
+        int ok = 1;
+
+        for (int l = 0; l < N; l++) {
+            memset(keys[l], 0x10 + l, sizeof(keys[l]));
+            memset(data[l], 0x40 + l, sizeof(data[l]));
+            kp[l] = keys[l];
+            dp[l] = data[l];
+            dlen[l] = (size_t)l * 9;
+        }
+        hmac_sha256_init_lanes(ctx, kp, key_len, N);
+        hmac_sha256_update_lanes(ctx, dp, dlen, N);
+        hmac_sha256_final_lanes(ctx, got, N);
+        for (int l = 0; l < N; l++) {
+            hmac_sha256(keys[l], key_len, data[l], dlen[l], want);
+            ok &= memcmp(got[l], want, 32) == 0;
+        }
+        check(ok, key_len > 64 ? "hmac: multi-buffer matches hmac_sha256 (long keys)"
+                               : "hmac: multi-buffer matches hmac_sha256");
+    }
 }
 
 /* ---------- HKDF-SHA256 (RFC 5869) ---------- */
@@ -199,6 +370,379 @@ static void test_hkdf(void) {
           "hkdf: zero-length output accepted");
 }
 
+/* ---------- random number generation ---------- */
+
+static int fill_0x11(void *ctx, uint8_t *buf, size_t len) {
+    (*(int *)ctx)++;
+    memset(buf, 0x11, len);
+    return 0;
+}
+
+static int fail_rng(void *ctx, uint8_t *buf, size_t len) {
+    (void)ctx;
+    (void)buf;
+    (void)len;
+    return -1;
+}
+
+static void test_csprng(void) {
+    /* RFC 8439 2.3.2 */
+    {
+        uint32_t key[8], nonce[3] = {0x09000000, 0x4a000000, 0};
+        uint8_t out[64], expected[64];
+        for (int i = 0; i < 8; i++) {
+            key[i] = (uint32_t)(4 * i) | (uint32_t)(4 * i + 1) << 8 |
+                     (uint32_t)(4 * i + 2) << 16 | (uint32_t)(4 * i + 3) << 24;
+        }
+        hex_to_bytes("10f1e7e4d13b5915500fdd1fa32071c4c7d1f4c733c068030422aa9ac3d46c4e"
+                     "d2826446079faa0914c2d705d98b02a2b5129cd1de164eb9cbd083e8a2503c4e",
+                     expected, 64);
+        chacha20_block(key, 1, nonce, out);
+        check(memcmp(out, expected, 64) == 0, "rng: ChaCha20 RFC 8439 block");
+    }
+
+    /* consecutive outputs differ, also across a refill and a reseed */
+    {
+        static uint8_t big[3000];
+        uint8_t a[32], b[32], c[32], zero[32] = {0};
+        int ok = ec_rng_bytes(a, 32) == 0 && ec_rng_bytes(big, sizeof(big)) == 0 &&
+                 ec_rng_bytes(b, 32) == 0;
+        ec_rng_reseed();
+        ok = ok && ec_rng_bytes(c, 32) == 0;
+        check(ok && memcmp(a, b, 32) != 0 && memcmp(b, c, 32) != 0 &&
+              memcmp(a, zero, 32) != 0 && memcmp(big + sizeof(big) - 32, zero, 32) != 0,
+              "rng: built-in generator output is fresh");
+    }
+
+#if !defined(_WIN32)
+    /* a forked child must not replay the parent's buffered stream */
+    {
+        uint8_t parent[32], child[32];
+        int fds[2], status = 1, ok = pipe(fds) == 0 && ec_rng_bytes(parent, 1) == 0;
+        pid_t pid = ok ? fork() : -1;
+
+        if (pid == 0) {
+            close(fds[0]);
+            ec_rng_bytes(child, 32);
+            _exit(write(fds[1], child, 32) == 32 ? 0 : 1);
+        }
+        if (pid > 0) {
+            close(fds[1]);
+            ok = read(fds[0], child, 32) == 32;
+            close(fds[0]);
+            ok = ok && waitpid(pid, &status, 0) == pid && status == 0;
+            ok = ok && ec_rng_bytes(parent, 32) == 0 && memcmp(parent, child, 32) != 0;
+        }
+        check(pid > 0 && ok, "rng: fork child reseeds");
+    }
+#endif
+
+    /* caller-supplied source feeds key generation */
+    {
+        uint256_t d, want;
+        ec_point_t Q;
+        int calls = 0;
+
+        memset(want.limb, 0x11, sizeof(want.limb));
+        ec_rng_set_callback(fill_0x11, &calls);
+        check(ec3dh_generate_keypair(&secp256r1, &d, &Q) == EC3DH_OK && calls == 1 &&
+              u256_eq(&d, &want),
+              "rng: callback source used for key generation");
+        ec_rng_set_callback(fail_rng, NULL);
+        check(ec3dh_generate_keypair(&secp256r1, &d, &Q) == EC3DH_ERR_RNG,
+              "rng: callback failure reported as EC3DH_ERR_RNG");
+        ec_rng_set_callback(NULL, NULL);
+    }
+}
+
+/* A pool started before fork() must not hand the parent's precomputed
+ * secrets to the child as well: the child gets a copy of the ring and
+ * has to generate inline. Stopping the copy must not wait for producers
+ * that only exist in the parent. */
+static void test_pool_fork(void) {
+#if !defined(_WIN32)
+    ec3dh_pool_t *pool = NULL;
+    uint256_t child, parent;
+    ec_point_t Q;
+    int fds[2], status = 1, ok;
+    pid_t pid;
+
+    ok = ec3dh_pool_start(&pool, &secp256r1, 2, 8, 2) == EC3DH_OK;
+    for (int i = 0; ok && i < 5000 && ec3dh_pool_available(pool) < 8; i++) sleep_ms(1);
+    ok = ok && ec3dh_pool_available(pool) == 8 && pipe(fds) == 0;
+    pid = ok ? fork() : -1;
+
+    if (pid == 0) {
+        close(fds[0]);
+        ok = ec3dh_pool_available(pool) == 0 &&
+             ec3dh_take_keypair(pool, &child, &Q) == EC3DH_OK;
+        ec3dh_pool_stop(pool);
+        _exit(ok && write(fds[1], &child, sizeof(child)) == sizeof(child) ? 0 : 1);
+    }
+    if (pid > 0) {
+        close(fds[1]);
+        ok = read(fds[0], &child, sizeof(child)) == sizeof(child);
+        close(fds[0]);
+        ok = ok && waitpid(pid, &status, 0) == pid && status == 0;
+        /* the first eight takes drain what the ring held at fork time */
+        for (int i = 0; i < 8 && ok; i++) {
+            ok = ec3dh_take_keypair(pool, &parent, &Q) == EC3DH_OK && !u256_eq(&parent, &child);
+        }
+    }
+    check(pid > 0 && ok, "keypool: forked child does not take the parent's keypairs");
+    ec3dh_pool_stop(pool);
+
+    /* the same for nonces: a shared r across two messages leaks the key */
+    {
+        const uint8_t msg_p[] = "parent", msg_c[] = "child";
+        uint256_t d = u256("c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721");
+        ecdsa_nonce_pool_t *npool = NULL;
+        uint8_t r_c[32], r_p[32], s_c[32], s_p[32];
+
+        ok = ecdsa_nonce_pool_start(&npool, &secp256r1, 2, 8, 2) == 0;
+        for (int i = 0; ok && i < 5000 && ecdsa_nonce_pool_available(npool) < 8; i++) sleep_ms(1);
+        ok = ok && ecdsa_nonce_pool_available(npool) == 8 && pipe(fds) == 0;
+        pid = ok ? fork() : -1;
+
+        if (pid == 0) {
+            close(fds[0]);
+            ok = ecdsa_nonce_pool_available(npool) == 0 &&
+                 ecdsa_sign_pooled(npool, &d, msg_c, 5, r_c, s_c) == 0;
+            ecdsa_nonce_pool_stop(npool);
+            _exit(ok && write(fds[1], r_c, 32) == 32 ? 0 : 1);
+        }
+        if (pid > 0) {
+            close(fds[1]);
+            ok = read(fds[0], r_c, 32) == 32;
+            close(fds[0]);
+            ok = ok && waitpid(pid, &status, 0) == pid && status == 0;
+            for (int i = 0; i < 8 && ok; i++) {
+                ok = ecdsa_sign_pooled(npool, &d, msg_p, 6, r_p, s_p) == 0 &&
+                     memcmp(r_p, r_c, 32) != 0;
+            }
+        }
+        check(pid > 0 && ok, "ecdsa pool: forked child does not reuse the parent's nonces");
+        ecdsa_nonce_pool_stop(npool);
+    }
+#endif
+}
+
+/* ---------- P-256 field backends ---------- */
+
+/* Deterministic xorshift stream for the randomized cross-checks. */
+static uint64_t test_rng_state = 0x9e3779b97f4a7c15ULL;
+static uint64_t test_rand64(void) {
+    test_rng_state ^= test_rng_state << 13;
+    test_rng_state ^= test_rng_state >> 7;
+    test_rng_state ^= test_rng_state << 17;
+    return test_rng_state;
+}
+
+/* random field element; every few draws take an edge value near 0 or p */
+static void test_rand_fe(uint256_t *x) {
+    uint64_t sel = test_rand64() & 7;
+    for (int i = 0; i < 4; i++) x->limb[i] = test_rand64();
+    if (sel == 0) {
+        *x = secp256r1.p;
+        x->limb[0] -= 1 + (test_rand64() & 3);
+    } else if (sel == 1) {
+        memset(x, 0, sizeof(*x));
+        x->limb[0] = test_rand64() & 3;
+    }
+    while (uint256_cmp(x, &secp256r1.p) >= 0) x->limb[3] >>= 1;
+}
+
+static void test_field_backend(int allow_asm) {
+    char name[64];
+    int ok = 1;
+
+    p256_field_select(allow_asm);
+    for (int i = 0; i < 20000 && ok; i++) {
+        uint256_t a, b, r1, r2;
+        test_rand_fe(&a);
+        test_rand_fe(&b);
+        p256_mul(&a, &b, &r1);
+        mod_mul(&a, &b, &secp256r1.p, &r2);
+        ok = u256_eq(&r1, &r2);
+        p256_sqr(&a, &r1);
+        mod_mul(&a, &a, &secp256r1.p, &r2);
+        ok = ok && u256_eq(&r1, &r2);
+    }
+    snprintf(name, sizeof(name), "field: %s mul/sqr match mod_mul", p256_field_backend());
+    check(ok, name);
+
+    {
+        uint256_t k = u256("7d7dc5f71eb29ddaf80d6214632eeae03d9058af1fb6d22ed80badb62bc1a534");
+        ec_point_t Q;
+        ec_scalar_multiply(&secp256r1, &k, &secp256r1.G, &Q);
+        snprintf(name, sizeof(name), "field: %s CAVP public key", p256_field_backend());
+        check(point_eq_affine(&Q,
+            "ead218590119e8876b29146ff89ca61770c4edbbf97d38ce385ed281d8a6b230",
+            "28af61281fd35e2fa7002523acc85a429cb06ee6648325389f59edfce1405141"), name);
+    }
+}
+
+#ifdef FE52_AVAILABLE
+/* value of a mod p, computed limb by limb with libmodplus */
+static void fe52_ref(const fe52_t *a, uint256_t *r) {
+    uint256_t radix = {{0}}, w = {{0}}, term, limb = {{0}};
+    radix.limb[0] = 1ULL << 52;
+    w.limb[0] = 1;
+    memset(r, 0, sizeof(*r));
+    for (int i = 0; i < 5; i++) {
+        limb.limb[0] = a->n[i];
+        mod_mul(&limb, &w, &secp256r1.p, &term);
+        mod_add(r, &term, &secp256r1.p, r);
+        mod_mul(&w, &radix, &secp256r1.p, &w);
+    }
+}
+
+/* random element of magnitude m, limbs pushed to the bound now and then */
+static void test_rand_fe52(fe52_t *a, uint64_t m) {
+    uint64_t bound = m << 52;
+    for (int i = 0; i < 5; i++) {
+        a->n[i] = (test_rand64() & 3) == 0 ? bound - 1 : test_rand64() % bound;
+    }
+}
+
+static void test_field_5x52(void) {
+    int ok = 1, mag_ok = 1;
+
+    for (int i = 0; i < 20000 && ok; i++) {
+        uint64_t ma = 1 + test_rand64() % FE52_MAX_MAG;
+        uint64_t mb = 1 + test_rand64() % FE52_MAX_MAG;
+        fe52_t a, b, r;
+        uint256_t ra, rb, want, got;
+
+        test_rand_fe52(&a, ma);
+        test_rand_fe52(&b, mb);
+        fe52_ref(&a, &ra);
+        fe52_ref(&b, &rb);
+
+        fe52_to_u256(&got, &a);
+        ok = u256_eq(&got, &ra);
+
+        /* a b 2^-260, moved back by fe52_to_mont */
+        fe52_mul(&r, &a, &b);
+        mag_ok &= fe52_has_magnitude(&r, 1);
+        fe52_to_mont(&r, &r);
+        mag_ok &= fe52_has_magnitude(&r, 1);
+        fe52_to_u256(&got, &r);
+        mod_mul(&ra, &rb, &secp256r1.p, &want);
+        ok = ok && u256_eq(&got, &want);
+
+        fe52_sqr(&r, &a);
+        mag_ok &= fe52_has_magnitude(&r, 1);
+        fe52_to_mont(&r, &r);
+        fe52_to_u256(&got, &r);
+        mod_mul(&ra, &ra, &secp256r1.p, &want);
+        ok = ok && u256_eq(&got, &want);
+
+        /* halve the magnitudes so the sums stay within FE52_MAX_MAG */
+        test_rand_fe52(&a, 1 + ma / 4);
+        test_rand_fe52(&b, 1 + mb / 4);
+        fe52_ref(&a, &ra);
+        fe52_ref(&b, &rb);
+
+        fe52_add(&r, &a, &b);
+        mag_ok &= fe52_has_magnitude(&r, 2 + ma / 4 + mb / 4);
+        fe52_to_u256(&got, &r);
+        mod_add(&ra, &rb, &secp256r1.p, &want);
+        ok = ok && u256_eq(&got, &want);
+
+        fe52_sub(&r, &a, &b, 1 + mb / 4);
+        mag_ok &= fe52_has_magnitude(&r, 1 + ma / 4 + 2 * (1 + mb / 4));
+        fe52_to_u256(&got, &r);
+        mod_sub(&ra, &rb, &secp256r1.p, &want);
+        ok = ok && u256_eq(&got, &want);
+
+        fe52_mul_small(&r, &b, 3);
+        mag_ok &= fe52_has_magnitude(&r, 3 * (1 + mb / 4));
+        fe52_to_u256(&got, &r);
+        mod_add(&rb, &rb, &secp256r1.p, &want);
+        mod_add(&want, &rb, &secp256r1.p, &want);
+        ok = ok && u256_eq(&got, &want);
+    }
+    check(ok, "field: 5x52 ops match mod_mul/mod_add/mod_sub");
+    check(mag_ok, "field: 5x52 results within documented magnitudes");
+
+    {
+        /* every limb at the largest value the bounds allow */
+        fe52_t a, r, zero = {{0}}, one = {{1}};
+        uint256_t ra, want, got;
+        for (int i = 0; i < 5; i++) a.n[i] = ((uint64_t)FE52_MAX_MAG << 52) - 1;
+        fe52_ref(&a, &ra);
+        fe52_sqr(&r, &a);
+        ok = fe52_has_magnitude(&r, 1);
+        fe52_to_mont(&r, &r);
+        fe52_to_u256(&got, &r);
+        mod_mul(&ra, &ra, &secp256r1.p, &want);
+        ok = ok && u256_eq(&got, &want);
+        fe52_to_mont(&r, &a);
+        ok = ok && fe52_has_magnitude(&r, 1);
+        fe52_mul(&r, &r, &one);
+        fe52_to_u256(&got, &r);
+        ok = ok && u256_eq(&got, &ra);
+        fe52_to_u256(&got, &a);
+        ok = ok && u256_eq(&got, &ra);
+        fe52_sub(&r, &zero, &a, FE52_MAX_MAG);
+        fe52_to_u256(&got, &r);
+        mod_sub(&secp256r1.p, &ra, &secp256r1.p, &want);
+        ok = ok && u256_eq(&got, &want) && fe52_has_magnitude(&r, 2 * FE52_MAX_MAG);
+        check(ok, "field: 5x52 at FE52_MAX_MAG");
+    }
+
+    {
+        /* p itself, in any spelling, must come back as 0 */
+        fe52_t a, b = {{0}};
+        uint256_t got;
+        fe52_from_u256(&a, &secp256r1.p);
+        fe52_to_u256(&got, &a);
+        int ok0 = uint256_is_zero(&got);
+        fe52_sub(&a, &b, &b, 1); /* 32p */
+        fe52_to_u256(&got, &a);
+        check(ok0 && uint256_is_zero(&got), "field: 5x52 reduces p and 32p to 0");
+    }
+}
+#endif
+
+static void test_field(void) {
+    test_field_backend(0);
+    test_field_backend(1); /* same as above on CPUs without BMI2/ADX */
+#ifdef FE52_AVAILABLE
+    test_field_5x52();
+#endif
+}
+
+/* ---------- constant-time table lookup ---------- */
+
+static void test_table_select_level(int level) {
+    _Alignas(EC_TABLE_ALIGN) uint64_t table[8 * EC_TABLE_MAX_WORDS];
+    uint64_t out[EC_TABLE_MAX_WORDS];
+    char name[64];
+    int ok = 1;
+
+    ec_table_select_init(level);
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++) table[i] = test_rand64();
+
+    for (size_t words = 4; words <= EC_TABLE_MAX_WORDS; words += 4) {
+        for (uint64_t idx = 0; idx <= 9; idx++) {
+            static const uint64_t zeros[EC_TABLE_MAX_WORDS];
+            const uint64_t *want = idx < 8 ? table + idx * words : zeros;
+            ec_table_select(out, table, 8, words, idx);
+            ok &= memcmp(out, want, words * sizeof(uint64_t)) == 0;
+        }
+    }
+    snprintf(name, sizeof(name), "table select: %s", ec_table_select_backend());
+    check(ok, name);
+}
+
+static void test_table_select(void) {
+    test_table_select_level(0);
+    test_table_select_level(1);
+    test_table_select_level(2);
+}
+
 /* ---------- P-256 scalar multiplication ---------- */
 
 static void test_scalar_mult_one(const char *k_hex, const char *x_hex, const char *y_hex,
@@ -256,6 +800,314 @@ static void test_scalar_mult(void) {
         "ecmul: (2^192+1)*G (sparse scalar)");
 }
 
+static void test_scalar_mult_vartime(void) {
+    static const char *ks[] = {
+        "0000000000000000000000000000000000000000000000000000000000000001",
+        "0000000000000000000000000000000000000000000000000000000000000002",
+        "000000000000000000000000000000000000000000000000000000000000000f",
+        "7d7dc5f71eb29ddaf80d6214632eeae03d9058af1fb6d22ed80badb62bc1a534",
+        "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632550", /* n - 1 */
+        "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", /* > n */
+        "8000000000000000000000000000000000000000000000000000000000000000",
+    };
+    ec_point_t P2, want, got;
+    int ok = 1;
+
+    ec_double_point(&secp256r1, &secp256r1.G, &P2); /* Jacobian input */
+    for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]) && ok; i++) {
+        uint256_t k = u256(ks[i]);
+        ec_scalar_multiply(&secp256r1, &k, &secp256r1.G, &want);
+        ec_scalar_multiply_vartime(&secp256r1, &k, &secp256r1.G, &got);
+        ok = !got.infinity && u256_eq(&got.x, &want.x) && u256_eq(&got.y, &want.y) &&
+             got.z.limb[0] == 1;
+        ec_scalar_multiply(&secp256r1, &k, &P2, &want);
+        ec_scalar_multiply_vartime(&secp256r1, &k, &P2, &got);
+        ok = ok && u256_eq(&got.x, &want.x) && u256_eq(&got.y, &want.y);
+    }
+    check(ok, "ecmul: vartime matches constant-time ladder");
+
+    {
+        uint256_t n = secp256r1.n, zero = {{0}};
+        ec_point_t O;
+        memset(&O, 0, sizeof(O));
+        O.infinity = 1;
+        ec_scalar_multiply_vartime(&secp256r1, &n, &secp256r1.G, &got);
+        ok = got.infinity;
+        ec_scalar_multiply_vartime(&secp256r1, &zero, &secp256r1.G, &got);
+        ok = ok && got.infinity;
+        ec_scalar_multiply_vartime(&secp256r1, &n, &O, &got);
+        check(ok && got.infinity, "ecmul: vartime n*G, 0*G, k*O are infinity");
+    }
+}
+
+static void test_gtable(void) {
+    static const char *ks[] = {
+        "0000000000000000000000000000000000000000000000000000000000000008",
+        "0000000000000000000000000000000000000000000000000000000000000009",
+        "8888888888888888888888888888888888888888888888888888888888888888",
+        "9999999999999999999999999999999999999999999999999999999999999999",
+        "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632550", /* n - 1 */
+        "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", /* final carry */
+    };
+    ec_point_t base = secp256r1.G, e, a, t, want, got;
+    int ok = 1;
+
+    /* every entry against a chain of Jacobian additions and doublings */
+    for (int i = 0; i < P256_GTABLE_WINDOWS && ok; i++) {
+        e = base;
+        for (int j = 0; j < P256_GTABLE_ENTRIES && ok; j++) {
+            ec_jacobian_to_affine(&secp256r1, &e, &a);
+            ok = u256_eq(&a.x, &p256_gtable[i][j].x) && u256_eq(&a.y, &p256_gtable[i][j].y);
+            ec_add_point(&secp256r1, &e, &base, &t);
+            e = t;
+        }
+        for (int d = 0; d < 4; d++) {
+            ec_double_point(&secp256r1, &base, &t);
+            base = t;
+        }
+    }
+    check(ok, "gtable: generated entries are (j + 1) * 16^i * G");
+
+    /* the fixed-base path against the generic ladder (via the MSM) */
+    for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]) && ok; i++) {
+        uint256_t k = u256(ks[i]);
+        ec_scalar_multiply(&secp256r1, &k, &secp256r1.G, &got);
+        ec_multi_scalar_multiply(&secp256r1, &k, &secp256r1.G, 1, &t);
+        ec_jacobian_to_affine(&secp256r1, &t, &want);
+        ok = !got.infinity && u256_eq(&got.x, &want.x) && u256_eq(&got.y, &want.y);
+    }
+    {
+        uint256_t zero = {{0}};
+        ec_scalar_multiply(&secp256r1, &secp256r1.n, &secp256r1.G, &got);
+        ok = ok && got.infinity;
+        ec_scalar_multiply(&secp256r1, &zero, &secp256r1.G, &got);
+        ok = ok && got.infinity;
+    }
+    check(ok, "gtable: fixed-base k*G matches the generic ladder");
+}
+
+/* ---------- multi-scalar multiplication ---------- */
+
+/* sum of k[i] * P[i], one multiplication at a time */
+static void msm_reference(const uint256_t *k, const ec_point_t *P, size_t n, ec_point_t *R) {
+    memset(R, 0, sizeof(*R));
+    R->infinity = 1;
+    for (size_t i = 0; i < n; i++) {
+        ec_point_t t, s;
+        ec_scalar_multiply(&secp256r1, &k[i], &P[i], &t);
+        ec_add_point(&secp256r1, R, &t, &s);
+        ec_jacobian_to_affine(&secp256r1, &s, R);
+    }
+}
+
+static int msm_matches(const ec_point_t *got, const ec_point_t *want) {
+    ec_point_t a;
+    ec_jacobian_to_affine(&secp256r1, got, &a);
+    if (a.infinity || want->infinity) return a.infinity == want->infinity;
+    return u256_eq(&a.x, &want->x) && u256_eq(&a.y, &want->y);
+}
+
+static void test_multi_scalar_mult(void) {
+    enum { N = 40 };
+    static const size_t sizes[] = { 0, 1, 2, 5, 16, 17, N };
+    uint256_t k[N];
+    ec_point_t P[N], want, got;
+    int ok_ct = 1, ok_vt = 1;
+
+    /* multiples of G, some Jacobian, one identity; random-ish scalars */
+    P[0] = secp256r1.G;
+    for (size_t i = 1; i < N; i++) {
+        ec_add_point(&secp256r1, &P[i - 1], &secp256r1.G, &P[i]);
+        if (i % 3) ec_jacobian_to_affine(&secp256r1, &P[i], &P[i]);
+    }
+    memset(&P[7], 0, sizeof(P[7]));
+    P[7].infinity = 1;
+    for (size_t i = 0; i < N; i++) {
+        for (int j = 0; j < 4; j++) k[i].limb[j] = test_rand64();
+    }
+    k[3] = secp256r1.n;
+    k[3].limb[0] -= 1;
+    memset(&k[4], 0, sizeof(k[4]));
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t n = sizes[s];
+        msm_reference(k, P, n, &want);
+        ec_multi_scalar_multiply(&secp256r1, k, P, n, &got);
+        ok_ct &= msm_matches(&got, &want);
+        ec_multi_scalar_multiply_vartime(&secp256r1, k, P, n, &got);
+        ok_vt &= msm_matches(&got, &want);
+    }
+    check(ok_ct, "msm: constant-time matches sum of single multiplications");
+    check(ok_vt, "msm: vartime (Straus and Pippenger) matches");
+
+    {
+        /* k * G + (n - k) * G == infinity */
+        uint256_t kk[2];
+        ec_point_t GG[2] = { secp256r1.G, secp256r1.G };
+        kk[0] = k[0];
+        kk[1] = k[0];
+        /* kk[1] = n - k[0] mod n, with k[0] < n */
+        while (uint256_cmp(&kk[0], &secp256r1.n) >= 0) kk[0].limb[3] >>= 1;
+        uint256_sub(&secp256r1.n, &kk[0], &kk[1]);
+        ec_multi_scalar_multiply(&secp256r1, kk, GG, 2, &got);
+        int ok = got.infinity;
+        ec_multi_scalar_multiply_vartime(&secp256r1, kk, GG, 2, &got);
+        check(ok && got.infinity, "msm: cancelling terms give infinity");
+    }
+}
+
+/* ---------- batch scalar multiplication ---------- */
+
+static void test_scalar_mult_batch(void) {
+    uint256_t k[5];
+    ec_point_t P[5], R[5], single;
+    int ok = 1;
+
+    k[0] = u256("0000000000000000000000000000000000000000000000000000000000000002");
+    k[1] = u256("7d7dc5f71eb29ddaf80d6214632eeae03d9058af1fb6d22ed80badb62bc1a534");
+    k[2] = u256("ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632550");
+    k[3] = u256("0000000000000000000000000000000000000000000000000000000000000005");
+    k[4] = k[1];
+    P[0] = secp256r1.G;
+    P[1] = secp256r1.G;
+    ec_double_point(&secp256r1, &secp256r1.G, &P[2]); /* Jacobian input */
+    P[3] = secp256r1.G;
+    memset(&P[4], 0, sizeof(P[4]));                   /* identity input */
+    P[4].infinity = 1;
+
+    ec_scalar_multiply_batch(&secp256r1, k, P, R, 5);
+    for (int i = 0; i < 4 && ok; i++) {
+        ec_scalar_multiply(&secp256r1, &k[i], &P[i], &single);
+        ok = !R[i].infinity && u256_eq(&R[i].x, &single.x) && u256_eq(&R[i].y, &single.y) &&
+             R[i].z.limb[0] == 1;
+    }
+    check(ok, "ecmul: batch matches single");
+    check(R[4].infinity == 1, "ecmul: batch k * infinity == infinity");
+
+    /* in place: keygen-style P == R */
+    for (int i = 0; i < 4; i++) P[i] = secp256r1.G;
+    ec_scalar_multiply_batch(&secp256r1, k, P, P, 4);
+    check(point_eq_affine(&P[3],
+        "51590b7a515140d2d784c85608668fdfef8c82fd1f5be52421554a0dc3d033ed",
+        "e0c17da8904a727d8ae1bf36bf8a79260d012f00d4d80888d1d0bb44fda16da4"),
+        "ecmul: batch in place (P == R)");
+
+    {
+        uint256_t d[3];
+        ec_point_t Q[3], expect;
+        ok = ec3dh_generate_keypairs(&secp256r1, d, Q, 3) == 0;
+        for (int i = 0; i < 3 && ok; i++) {
+            ec_scalar_multiply(&secp256r1, &d[i], &secp256r1.G, &expect);
+            ok = u256_eq(&Q[i].x, &expect.x) && u256_eq(&Q[i].y, &expect.y);
+        }
+        check(ok, "ecdh: batch keypair generation");
+    }
+}
+
+/* Lane ladders against ec_scalar_multiply: 19 points (two full groups of
+ * eight, and a partial group) with random scalars, plus 0, 1 and n - 1. */
+static void test_scalar_mult_lanes_level(int level) {
+    enum { N = 19 };
+    uint256_t k[N], j;
+    ec_point_t P[N], R[N], single;
+    char name[64];
+    int ok = 1;
+
+    ec_lanes_select(level);
+    for (int i = 0; i < N; i++) {
+        for (int w = 0; w < 4; w++) j.limb[w] = test_rand64();
+        j.limb[3] >>= 1;
+        ec_scalar_multiply(&secp256r1, &j, &secp256r1.G, &P[i]);
+        for (int w = 0; w < 4; w++) k[i].limb[w] = test_rand64();
+    }
+    memset(&k[0], 0, sizeof(k[0]));
+    k[1] = u256("0000000000000000000000000000000000000000000000000000000000000001");
+    uint256_sub(&secp256r1.n, &k[1], &k[2]);
+    ec_double_point(&secp256r1, &P[3], &P[3]); /* Jacobian input */
+
+    ec_scalar_multiply_batch(&secp256r1, k, P, R, N);
+    for (int i = 0; i < N; i++) {
+        ec_scalar_multiply(&secp256r1, &k[i], &P[i], &single);
+        ok &= R[i].infinity == single.infinity;
+        ok &= single.infinity || (u256_eq(&R[i].x, &single.x) && u256_eq(&R[i].y, &single.y));
+    }
+    snprintf(name, sizeof(name), "ecmul: batch lanes (%s) match single", ec_lanes_backend());
+    check(ok, name);
+}
+
+static void test_scalar_mult_lanes(void) {
+    test_scalar_mult_lanes_level(0);
+    test_scalar_mult_lanes_level(1);
+    test_scalar_mult_lanes_level(2);
+}
+
+/* ---------- x-only ladder ---------- */
+
+static void test_scalar_mult_x_one(const char *k_hex, const ec_point_t *P, const char *name) {
+    uint256_t k = u256(k_hex), x;
+    ec_point_t R;
+    ec_scalar_multiply(&secp256r1, &k, P, &R);
+    check(ec_scalar_multiply_x(&secp256r1, &k, &P->x, &x) == 0 &&
+          !R.infinity && u256_eq(&x, &R.x), name);
+}
+
+static void test_scalar_mult_x(void) {
+    const ec_point_t *G = &secp256r1.G;
+    ec_point_t negG;
+
+    /* small k: k + n stays below 2^256, so the k + 2n branch is taken */
+    test_scalar_mult_x_one(
+        "0000000000000000000000000000000000000000000000000000000000000001", G,
+        "xladder: 1*G");
+    test_scalar_mult_x_one(
+        "0000000000000000000000000000000000000000000000000000000000000002", G,
+        "xladder: 2*G");
+    test_scalar_mult_x_one(
+        "0000000000000000000000000000000000000000000000000000000000000005", G,
+        "xladder: 5*G");
+    test_scalar_mult_x_one(
+        "00000000ffffffffffffffffffffffffffffffffffffffffffffffffffffffff", G,
+        "xladder: (2^224-1)*G");
+    test_scalar_mult_x_one(
+        "8000000000000000000000000000000000000000000000000000000000000000", G,
+        "xladder: 2^255 * G");
+    /* (n-1)/2 and (n+1)/2: the two ladder points sum to the identity */
+    test_scalar_mult_x_one(
+        "7fffffff800000007fffffffffffffffde737d56d38bcf4279dce5617e3192a8", G,
+        "xladder: ((n-1)/2)*G");
+    test_scalar_mult_x_one(
+        "7fffffff800000007fffffffffffffffde737d56d38bcf4279dce5617e3192a9", G,
+        "xladder: ((n+1)/2)*G");
+    /* n-2, n-1: a ladder point passes through the identity near the end */
+    test_scalar_mult_x_one(
+        "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc63254f", G,
+        "xladder: (n-2)*G");
+    test_scalar_mult_x_one(
+        "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632550", G,
+        "xladder: (n-1)*G");
+
+    /* x(k * -P) == x(k * P) */
+    ec_negate_point(&secp256r1, G, &negG);
+    test_scalar_mult_x_one(
+        "7d7dc5f71eb29ddaf80d6214632eeae03d9058af1fb6d22ed80badb62bc1a534", &negG,
+        "xladder: sign of y is irrelevant");
+
+    {
+        uint256_t zero, x;
+        memset(&zero, 0, sizeof(zero));
+        check(ec_scalar_multiply_x(&secp256r1, &zero, &G->x, &x) < 0 &&
+              ec_scalar_multiply_x(&secp256r1, &secp256r1.n, &G->x, &x) < 0,
+              "xladder: reject k == 0 and k == n");
+    }
+
+    {
+        uint256_t one = u256("0000000000000000000000000000000000000000000000000000000000000001");
+        check(ec_x_on_curve(&secp256r1, &G->x), "xoncurve: G.x accepted");
+        check(!ec_x_on_curve(&secp256r1, &one), "xoncurve: twist x (x = 1) rejected");
+        check(!ec_x_on_curve(&secp256r1, &secp256r1.p), "xoncurve: x == p rejected");
+    }
+}
+
 /* ---------- P-256 point arithmetic ---------- */
 
 static void test_point_arith(void) {
@@ -326,6 +1178,140 @@ static void test_point_arith(void) {
             "07775510db8ed040293d9ac69f7430dbba7dade63ce982299e04b79d227873d2");
         check(!ec_point_on_curve(&secp256r1, &bad), "oncurve: off-curve point rejected");
     }
+
+    /* mixed addition entry point; z == 0 still means affine input */
+    {
+        ec_point_t G0 = secp256r1.G, inf;
+        ec_add_point_mixed(&secp256r1, &twoG, &secp256r1.G, &R);
+        int ok = point_eq_affine(&R,
+            "5ecbe4d1a6330a44c8f7ef951d4bf165e6c6b721efada985fb41661bc6e7fd6c",
+            "8734640c4998ff7e374b06ce1a64a2ecd82ab036384fb83d9a79b127a27d5032");
+        memset(&inf, 0, sizeof(inf));
+        inf.infinity = 1;
+        ec_add_point_mixed(&secp256r1, &inf, &secp256r1.G, &R);
+        ok = ok && point_eq_affine(&R,
+            "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296",
+            "4fe342e2fe1a7f9b8ee7eb4a7c0f9e162bce33576b315ececbb6406837bf51f5");
+        check(ok, "ecadd: mixed 2G + G == 3G, O + G == G");
+
+        memset(&G0.z, 0, sizeof(G0.z));
+        ec_add_point(&secp256r1, &twoG, &G0, &R);
+        check(point_eq_affine(&R,
+            "5ecbe4d1a6330a44c8f7ef951d4bf165e6c6b721efada985fb41661bc6e7fd6c",
+            "8734640c4998ff7e374b06ce1a64a2ecd82ab036384fb83d9a79b127a27d5032"),
+            "ecadd: z == 0 operand taken as affine");
+    }
+}
+
+static void test_point_types(void) {
+    ec_point_t J, O, back, A1, A2;
+    ec_affine_t a;
+    ec_proj_t q;
+    int ok;
+
+    check(sizeof(ec_affine_t) == 64 && sizeof(ec_proj_t) == 96, "types: affine 64 bytes, projective 96");
+
+    ec_double_point(&secp256r1, &secp256r1.G, &J); /* Jacobian, z != 1 */
+    ec_jacobian_to_affine(&secp256r1, &J, &A1);
+    ok = ec_affine_from_point(&secp256r1, &J, &a) == 0 && u256_eq(&a.x, &A1.x) && u256_eq(&a.y, &A1.y);
+    ec_affine_to_point(&a, &back);
+    ok = ok && back.z.limb[0] == 1 && ec_point_on_curve(&secp256r1, &back);
+    ec_proj_from_point(&secp256r1, &J, &q);
+    ec_proj_to_point(&secp256r1, &q, &back);
+    ec_jacobian_to_affine(&secp256r1, &back, &A2);
+    ok = ok && u256_eq(&A1.x, &A2.x) && u256_eq(&A1.y, &A2.y);
+    check(ok, "types: affine and projective round trips");
+
+    memset(&O, 0, sizeof(O));
+    O.infinity = 1;
+    ok = ec_affine_from_point(&secp256r1, &O, &a) == -1;
+    ec_proj_from_point(&secp256r1, &O, &q);
+    ok = ok && uint256_is_zero(&q.z);
+    ec_proj_to_point(&secp256r1, &q, &back);
+    check(ok && back.infinity, "types: infinity maps to (0 : 1 : 0) and back");
+}
+
+static void test_scalar_mult_proj(void) {
+    uint256_t k1 = u256("7d7dc5f71eb29ddaf80d6214632eeae03d9058af1fb6d22ed80badb62bc1a534");
+    uint256_t k2 = u256("c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721");
+    ec_point_t P2, t1, t2, want, tmp;
+    ec_affine_t a, g;
+    ec_proj_t q, h;
+    int ok;
+
+    /* k2 * (k1 * 2G) + G: affine at every step vs. projective throughout */
+    ec_double_point(&secp256r1, &secp256r1.G, &P2);
+    ec_scalar_multiply(&secp256r1, &k1, &P2, &t1);
+    ec_scalar_multiply(&secp256r1, &k2, &t1, &t2);
+    ec_add_point(&secp256r1, &t2, &secp256r1.G, &tmp);
+    ec_jacobian_to_affine(&secp256r1, &tmp, &want);
+
+    ec_proj_from_point(&secp256r1, &P2, &q);
+    ec_scalar_multiply_proj(&secp256r1, &k1, &q, &q);
+    ec_scalar_multiply_proj(&secp256r1, &k2, &q, &q);
+    ec_affine_from_point(&secp256r1, &secp256r1.G, &g);
+    ec_add_proj_mixed(&secp256r1, &q, &g, &h);
+    ok = ec_proj_to_affine(&secp256r1, &h, &a) == 0 && u256_eq(&a.x, &want.x) && u256_eq(&a.y, &want.y);
+    ec_proj_from_affine(&g, &q);
+    ec_add_proj(&secp256r1, &h, &q, &h);
+    ec_add_point(&secp256r1, &want, &secp256r1.G, &tmp);
+    ec_jacobian_to_affine(&secp256r1, &tmp, &want);
+    ok = ok && ec_proj_to_affine(&secp256r1, &h, &a) == 0 && u256_eq(&a.x, &want.x) &&
+         u256_eq(&a.y, &want.y);
+    check(ok, "ecmul: projective chain matches affine steps");
+
+    /* fixed-base path, identity in and out */
+    ec_proj_from_affine(&g, &q);
+    ec_scalar_multiply_proj(&secp256r1, &k1, &q, &h);
+    ec_scalar_multiply(&secp256r1, &k1, &secp256r1.G, &want);
+    ok = ec_proj_to_affine(&secp256r1, &h, &a) == 0 && u256_eq(&a.x, &want.x) && u256_eq(&a.y, &want.y);
+    ec_scalar_multiply_proj(&secp256r1, &secp256r1.n, &q, &h);
+    ok = ok && ec_proj_to_affine(&secp256r1, &h, &a) == -1;
+    ec_scalar_multiply_proj(&secp256r1, &k1, &h, &q);
+    ok = ok && uint256_is_zero(&q.z);
+    ec_add_proj(&secp256r1, &q, &h, &q);
+    check(ok && uint256_is_zero(&q.z), "ecmul: projective k*G, n*G and k*O");
+}
+
+/* secp256k1 (a = 0) exercises the general-a formulas that P-256 skips. */
+static void test_point_arith_general_a(void) {
+    ec_domain_params_t k1;
+    ec_point_t twoG, fourG, fiveG, A, B;
+    int ok;
+
+    memset(&k1, 0, sizeof(k1));
+    k1.p = u256("fffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f");
+    k1.b = u256("0000000000000000000000000000000000000000000000000000000000000007");
+    k1.n = u256("fffffffffffffffffffffffffffffffebaaedce6af48a03bbfd25e8cd0364141");
+    k1.G = point("79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798",
+                 "483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8");
+    k1.h = 1;
+
+    ec_double_point(&k1, &k1.G, &twoG);
+    ec_double_point(&k1, &twoG, &fourG);
+    ec_add_point(&k1, &fourG, &k1.G, &fiveG);
+
+    ec_jacobian_to_affine(&k1, &twoG, &A);
+    B = point("c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee5",
+              "1ae168fea63dc339a3c58419466ceaeef7f632653266d0e1236431a950cfe52a");
+    ok = u256_eq(&A.x, &B.x) && u256_eq(&A.y, &B.y);
+    ec_jacobian_to_affine(&k1, &fourG, &A);
+    B = point("e493dbf1c10d80f3581e4904930b1404cc6c13900ee0758474fa94abe8c4cd13",
+              "51ed993ea0d455b75642e2098ea51448d967ae33bfbdfe40cfe97bdc47739922");
+    ok = ok && u256_eq(&A.x, &B.x) && u256_eq(&A.y, &B.y);
+    ec_jacobian_to_affine(&k1, &fiveG, &A);
+    B = point("2f8bde4d1a07209355b4a7250a5c5128e88b84bddc619ab7cba8d569b240efe4",
+              "d8ac222636e5e3d6d4dba9dda6c9c426f788271bab0d6840dca87d3aa6ac62d6");
+    ok = ok && u256_eq(&A.x, &B.x) && u256_eq(&A.y, &B.y);
+    check(ok, "ecadd: secp256k1 2G, 4G, 5G (a = 0 doubling)");
+
+    {
+        uint256_t k = u256("7d7dc5f71eb29ddaf80d6214632eeae03d9058af1fb6d22ed80badb62bc1a534");
+        ec_scalar_multiply(&k1, &k, &k1.G, &A);
+        ec_scalar_multiply_vartime(&k1, &k, &k1.G, &B);
+        check(u256_eq(&A.x, &B.x) && u256_eq(&A.y, &B.y),
+              "ecmul: secp256k1 vartime matches constant-time ladder");
+    }
 }
 
 /* ---------- ECDH (NIST CAVP ECC CDH, P-256, vector 0) ---------- */
@@ -369,6 +1355,16 @@ static void test_ecdh(void) {
         check(memcmp(mac, expected, 32) == 0, "ecdh: derived MAC key");
     }
 
+    /* x-only entry point gives the same keys from just the peer's x */
+    {
+        uint8_t enc[32], mac[32], enc_x[32], mac_x[32];
+        uint256_t peer_x = u256(CAVP_PEER_X);
+        check(ec3dh_compute_shared_secret_dk(&secp256r1, &d, &peer, enc, 32, mac, 32) == 0 &&
+              ec3dh_compute_shared_secret_x_dk(&secp256r1, &d, &peer_x, enc_x, 32, mac_x, 32) == 0 &&
+              memcmp(enc, enc_x, 32) == 0 && memcmp(mac, mac_x, 32) == 0,
+              "ecdh: x-only API matches full-point API");
+    }
+
     /* round trip with random keys */
     {
         uint256_t da, db;
@@ -386,6 +1382,365 @@ static void test_ecdh(void) {
     }
 }
 
+/* ---------- ECDSA ---------- */
+
+static void test_scalar(void) {
+    const scalar_mont_t *m = &secp256r1.consts->n_mont;
+    uint256_t a = u256("c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721");
+    uint256_t b = u256("efd48b2aacb6a8fd1140dd9cd45e81d69d2c877b56aaf991c34d0ea84eaf3716");
+    uint256_t all = u256("ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
+    uint256_t nm1 = secp256r1.n, am, bm, t;
+    ec_curve_consts_t c;
+    int ok;
+
+    ec_curve_consts_init(&secp256r1, &c);
+    ok = u256_eq(&c.b3, &secp256r1.consts->b3) &&
+         u256_eq(&c.sqrt_exp, &secp256r1.consts->sqrt_exp) &&
+         u256_eq(&c.n_mont.n, &m->n) && u256_eq(&c.n_mont.rr, &m->rr) &&
+         c.n_mont.n0 == m->n0 && c.a_is_minus3 == secp256r1.consts->a_is_minus3;
+    check(ok, "consts: static secp256r1 block matches computed one");
+
+    {
+        /* modified copies that still point at the secp256r1 block fall
+         * back to computed constants, and compute what a copy without a
+         * block computes */
+        ec_domain_params_t stale = secp256r1, fresh, stale_n = secp256r1;
+        ec_curve_consts_t tmp;
+        ec_point_t A, B;
+
+        stale.b.limb[0] ^= 1;
+        fresh = stale;
+        fresh.consts = NULL;
+        stale_n.n.limb[0] -= 2;
+        ok = ec_curve_consts(&secp256r1, &c) == secp256r1.consts &&
+             ec_curve_consts(&stale, &tmp) == &tmp && ec_curve_consts_lookup(&stale) == NULL &&
+             ec_curve_consts_lookup(&stale_n) == NULL;
+        ec_curve_consts_init(&stale, &c);
+        ok = ok && u256_eq(&tmp.b3, &c.b3) && !u256_eq(&tmp.b3, &secp256r1.consts->b3);
+        ec_scalar_multiply(&stale, &a, &stale.G, &A);
+        ec_scalar_multiply(&fresh, &a, &fresh.G, &B);
+        ok = ok && u256_eq(&A.x, &B.x) && u256_eq(&A.y, &B.y) && A.infinity == B.infinity;
+        check(ok, "consts: stale block on a modified curve copy is ignored");
+    }
+
+    uint256_t want_ab = u256("f711cfe9b732655bd13c0960278063a7fef4ec0e86d6083b22d813fbfb70f6d9");
+    uint256_t want_inv = u256("ff24a4eeb2b46cee2bf82c197f40fc7f2b34205e3cbf997c4a9c6f32ec7e38d4");
+    uint256_t want_red = u256("00000000ffffffff00000000000000004319055258e8617b0c46353d039cdaae");
+    uint256_t want_sub = u256("d9db1eac9903cc1a5a1b43ba935354bc6e0b370d87554005abf71e45bfc3555c");
+    uint256_t want_dbl = u256("ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc63254f");
+
+    scalar_to_mont(m, &a, &am);
+    scalar_to_mont(m, &b, &bm);
+    scalar_mul(m, &am, &bm, &t);
+    scalar_from_mont(m, &t, &t);
+    ok = u256_eq(&t, &want_ab);
+    scalar_inv(m, &am, &t);
+    scalar_from_mont(m, &t, &t);
+    ok = ok && u256_eq(&t, &want_inv);
+    check(ok, "scalar: Montgomery product and inverse mod n");
+
+    /* batched inversion agrees with one inversion per element */
+    {
+        uint256_t in[5], out[5], one;
+        in[0] = am;
+        in[1] = bm;
+        for (int i = 2; i < 5; i++) scalar_mul(m, &in[i - 1], &in[i - 2], &in[i]);
+        scalar_inv_batch(m, in, out, 5);
+        ok = 1;
+        for (int i = 0; i < 5; i++) {
+            scalar_mul(m, &in[i], &out[i], &t);
+            scalar_from_mont(m, &t, &t);
+            memset(&one, 0, sizeof(one));
+            one.limb[0] = 1;
+            ok = ok && u256_eq(&t, &one);
+        }
+        check(ok, "scalar: batched inverse");
+    }
+
+    scalar_reduce(m, &all, &t);
+    ok = u256_eq(&t, &want_red);
+    scalar_sub(m, &a, &b, &t);
+    ok = ok && u256_eq(&t, &want_sub);
+    scalar_add(m, &t, &b, &t);
+    ok = ok && u256_eq(&t, &a);
+    nm1.limb[0] -= 1;
+    scalar_add(m, &nm1, &nm1, &t); /* carries out of 256 bits */
+    ok = ok && u256_eq(&t, &want_dbl);
+    check(ok, "scalar: reduce, add and sub wrap around n");
+}
+
+static void test_ecdsa(void) {
+    const uint8_t msg[] = "sample";
+    uint256_t d = u256("c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721");
+    ec_point_t Q = point("60fed4ba255a9d31c961eb74c6356d68c049b8923b61fa6ce669622e60f29fb6",
+                         "7903fe1008b8bc99a41ae9e95628bc64f2f1b20c2d7e9f5177a3c294d4462299");
+    uint8_t r[32], s[32], want_r[32], want_s[32];
+
+    hex_to_bytes("efd48b2aacb6a8fd1140dd9cd45e81d69d2c877b56aaf991c34d0ea84eaf3716", want_r, 32);
+    hex_to_bytes("f7cb1c942d657c41d436c7a1b6e29f65f3e900dbb9aff4064dc4ab2f843acda8", want_s, 32);
+
+    check(ecdsa_sign(&secp256r1, &d, msg, 6, r, s) == 0 &&
+          memcmp(r, want_r, 32) == 0 && memcmp(s, want_s, 32) == 0,
+          "ecdsa: RFC 6979 A.2.5 signature");
+    check(ecdsa_verify(&secp256r1, &Q, msg, 6, want_r, want_s) == 1, "ecdsa: RFC 6979 verify");
+    check(ecdsa_verify(&secp256r1, &Q, (const uint8_t *)"samplf", 6, want_r, want_s) == 0,
+          "ecdsa: wrong message rejected");
+    s[31] ^= 1;
+    check(ecdsa_verify(&secp256r1, &Q, msg, 6, want_r, s) == 0, "ecdsa: modified s rejected");
+
+    /* A signature whose R has x >= n, so r = x - n and only the r + n
+     * candidate matches. Pick such an R, set s = 1 and solve for the
+     * public key: Q = r^-1 (R - e G) makes u1 G + u2 Q = e G + r Q = R. */
+    {
+        const uint256_t *n = &secp256r1.n, *p = &secp256r1.p;
+        uint256_t x = *n, one = {{1, 0, 0, 0}}, e, rr, rinv, neg_e;
+        uint8_t enc[33], hash[32];
+        ec_point_t R, eG, T, Qc;
+
+        while (!ec_x_on_curve(&secp256r1, &x)) uint256_add(&x, &one, &x);
+        enc[0] = 0x02;
+        ec_scalar_to_bytes(&x, enc + 1);
+        int ok = uint256_cmp(&x, p) < 0 && ec_point_from_bytes(&secp256r1, enc, 33, &R) == 0;
+
+        uint256_sub(&x, n, &rr);
+        sha256(msg, 6, hash);
+        ec_scalar_from_bytes(&secp256r1, hash, &e); /* < n for this message */
+        mod_sub(n, &e, n, &neg_e);
+        mod_inv(&rr, n, &rinv);
+        ec_scalar_multiply(&secp256r1, &neg_e, &secp256r1.G, &eG);
+        ec_add_point(&secp256r1, &R, &eG, &T);
+        ec_scalar_multiply(&secp256r1, &rinv, &T, &Qc);
+
+        ec_scalar_to_bytes(&rr, r);
+        memset(s, 0, 32);
+        s[31] = 1;
+        ok = ok && ecdsa_verify(&secp256r1, &Qc, msg, 6, r, s) == 1;
+        check(ok, "ecdsa: verify accepts r = x(R) - n");
+    }
+}
+
+static void test_ecdsa_stream(void) {
+    const uint8_t msg[] = "sample";
+    uint256_t d = u256("c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721");
+    ec_point_t Q = point("60fed4ba255a9d31c961eb74c6356d68c049b8923b61fa6ce669622e60f29fb6",
+                         "7903fe1008b8bc99a41ae9e95628bc64f2f1b20c2d7e9f5177a3c294d4462299");
+    uint8_t want_r[32], want_s[32], r[32], s[32], digest[32];
+    SHA256_ctx_t ctx;
+
+    hex_to_bytes("efd48b2aacb6a8fd1140dd9cd45e81d69d2c877b56aaf991c34d0ea84eaf3716", want_r, 32);
+    hex_to_bytes("f7cb1c942d657c41d436c7a1b6e29f65f3e900dbb9aff4064dc4ab2f843acda8", want_s, 32);
+
+    sha256(msg, 6, digest);
+    check(ecdsa_sign_digest(&secp256r1, &d, digest, r, s) == 0 &&
+          memcmp(r, want_r, 32) == 0 && memcmp(s, want_s, 32) == 0 &&
+          ecdsa_verify_digest(&secp256r1, &Q, digest, r, s) == 1,
+          "ecdsa digest: RFC 6979 A.2.5 sign and verify");
+    digest[0] ^= 1;
+    check(ecdsa_verify_digest(&secp256r1, &Q, digest, r, s) == 0,
+          "ecdsa digest: wrong digest rejected");
+
+    ecdsa_sign_init(&ctx);
+    ecdsa_sign_update(&ctx, msg, 2);
+    ecdsa_sign_update(&ctx, msg + 2, 0);
+    ecdsa_sign_update(&ctx, msg + 2, 4);
+    check(ecdsa_sign_final(&ctx, &secp256r1, &d, r, s) == 0 &&
+          memcmp(r, want_r, 32) == 0 && memcmp(s, want_s, 32) == 0,
+          "ecdsa stream: signature matches one-shot");
+
+    ecdsa_verify_init(&ctx);
+    ecdsa_verify_update(&ctx, msg, 5);
+    ecdsa_verify_update(&ctx, msg + 5, 1);
+    check(ecdsa_verify_final(&ctx, &secp256r1, &Q, r, s) == 1, "ecdsa stream: verify");
+    ecdsa_verify_init(&ctx);
+    ecdsa_verify_update(&ctx, msg, 5);
+    check(ecdsa_verify_final(&ctx, &secp256r1, &Q, r, s) == 0,
+          "ecdsa stream: truncated message rejected");
+}
+
+static void test_ecdsa_batch(void) {
+    enum { N = 20 }; /* more than one internal group */
+    uint256_t d = u256("c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721");
+    uint8_t bufs[N][8], r[N][32], s[N][32], r1[32], s1[32];
+    const uint8_t *msgs[N];
+    size_t lens[N];
+    int ok;
+
+    for (int i = 0; i < N; i++) {
+        memset(bufs[i], 'a' + i, sizeof(bufs[i]));
+        msgs[i] = bufs[i];
+        lens[i] = (size_t)(i % 9);
+    }
+    ok = ecdsa_sign_batch(&secp256r1, &d, msgs, lens, N, r, s) == 0;
+    for (int i = 0; i < N && ok; i++) {
+        ok = ecdsa_sign(&secp256r1, &d, msgs[i], lens[i], r1, s1) == 0 &&
+             memcmp(r[i], r1, 32) == 0 && memcmp(s[i], s1, 32) == 0;
+    }
+    check(ok, "ecdsa batch: matches ecdsa_sign across groups");
+    check(ecdsa_sign_batch(&secp256r1, &d, msgs, lens, 0, r, s) == 0 &&
+          ecdsa_sign_batch(&secp256r1, &secp256r1.n, msgs, lens, 1, r, s) == -1,
+          "ecdsa batch: empty batch accepted, bad key rejected");
+}
+
+static void test_ecdsa_signing_key(void) {
+    const uint8_t *msgs[3] = {(const uint8_t *)"sample", (const uint8_t *)"test",
+                              (const uint8_t *)""};
+    const size_t lens[3] = {6, 4, 0};
+    uint256_t d = u256("c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721");
+    uint256_t bad = secp256r1.n;
+    ecdsa_signing_key_t *key = NULL;
+    uint8_t r[3][32], s[3][32], r1[32], s1[32], digest[32];
+    int ok;
+
+    check(ecdsa_signing_key_new(&key, &secp256r1, &bad) == -1 && !key,
+          "ecdsa key: out-of-range private key rejected");
+    if (ecdsa_signing_key_new(&key, &secp256r1, &d) != 0) {
+        check(0, "ecdsa key: create");
+        return;
+    }
+
+    /* deterministic, so every path must give ecdsa_sign's exact bytes */
+    ok = ecdsa_signing_key_sign_batch(key, msgs, lens, 3, r, s) == 0;
+    for (int i = 0; i < 3 && ok; i++) {
+        ok = ecdsa_sign(&secp256r1, &d, msgs[i], lens[i], r1, s1) == 0 &&
+             memcmp(r[i], r1, 32) == 0 && memcmp(s[i], s1, 32) == 0;
+    }
+    check(ok, "ecdsa key: batch matches ecdsa_sign");
+
+    sha256(msgs[0], lens[0], digest);
+    ok = ecdsa_signing_key_sign(key, msgs[0], lens[0], r1, s1) == 0 &&
+         memcmp(r1, r[0], 32) == 0 && memcmp(s1, s[0], 32) == 0 &&
+         ecdsa_signing_key_sign_digest(key, digest, r1, s1) == 0 &&
+         memcmp(r1, r[0], 32) == 0 && memcmp(s1, s[0], 32) == 0;
+    check(ok, "ecdsa key: message and digest signing match");
+
+    ecdsa_signing_key_free(key);
+}
+
+static void test_ecdsa_pool(void) {
+    const uint8_t msg[] = "sample";
+    uint256_t d = u256("c9afa9d845ba75166b5c215767b1d6934e50c3db36e89b127b8a622b120f6721");
+    ec_point_t Q = point("60fed4ba255a9d31c961eb74c6356d68c049b8923b61fa6ce669622e60f29fb6",
+                         "7903fe1008b8bc99a41ae9e95628bc64f2f1b20c2d7e9f5177a3c294d4462299");
+    ecdsa_nonce_pool_t *pool = NULL;
+    uint8_t r1[32], s1[32], r2[32], s2[32];
+    int ok = 1;
+
+    check(ecdsa_nonce_pool_start(&pool, &secp256r1, 4, 4, 1) == -1 && !pool,
+          "ecdsa pool: bad parameters rejected");
+    if (ecdsa_nonce_pool_start(&pool, &secp256r1, 2, 8, 2) != 0) {
+        check(0, "ecdsa pool: start");
+        return;
+    }
+    for (int i = 0; i < 5000 && ecdsa_nonce_pool_available(pool) < 8; i++) sleep_ms(1);
+    check(ecdsa_nonce_pool_available(pool) == 8, "ecdsa pool: fills to the high water mark");
+
+    /* drain past empty, so the inline fallback signs too */
+    for (int i = 0; i < 12 && ok; i++) {
+        ok = ecdsa_sign_pooled(pool, &d, msg, 6, r1, s1) == 0 &&
+             ecdsa_verify(&secp256r1, &Q, msg, 6, r1, s1) == 1;
+    }
+    check(ok, "ecdsa pool: signatures verify");
+
+    ok = ecdsa_sign_pooled(pool, &d, msg, 6, r2, s2) == 0 && memcmp(r1, r2, 32) != 0;
+    check(ok, "ecdsa pool: nonces are not reused");
+    check(ecdsa_verify(&secp256r1, &Q, (const uint8_t *)"samplf", 6, r2, s2) == 0,
+          "ecdsa pool: wrong message rejected");
+
+    ecdsa_nonce_pool_stop(pool);
+}
+
+static void test_keystore(void) {
+    enum { N = 20 };
+    const char *path = "kat_keystore.tmp";
+    const uint8_t msg[] = "sample";
+    uint256_t d[N];
+    ec_point_t Q[N];
+    uint8_t r[32], s[32], k1[32], k2[32], m1[32], m2[32];
+    ec_keystore_t ks;
+    int ok = 1;
+
+    for (size_t i = 0; i < N; i++) {
+        d[i].limb[0] = test_rand64();
+        d[i].limb[1] = test_rand64();
+        d[i].limb[2] = test_rand64();
+        d[i].limb[3] = test_rand64() >> 1; /* < n */
+        ec_scalar_multiply(&secp256r1, &d[i], &secp256r1.G, &Q[i]);
+    }
+    ec_double_point(&secp256r1, &Q[0], &Q[1]); /* Jacobian input */
+    d[1] = d[0];
+    uint256_add(&d[1], &d[0], &d[1]);
+
+    check(ec_keystore_write(path, &secp256r1, Q, N) == EC_KEYSTORE_OK, "keystore: write");
+    check(ec_keystore_open(path, &secp256r1, 0, &ks) == EC_KEYSTORE_OK && ks.count == N,
+          "keystore: open and checksum");
+
+    for (size_t i = 0; i < N && ok && ks.keys; i++) {
+        ec_point_t A;
+        ec_jacobian_to_affine(&secp256r1, &Q[i], &A);
+        ok = u256_eq(&ks.keys[i].x, &A.x) && u256_eq(&ks.keys[i].y, &A.y) &&
+             ((uintptr_t)&ks.keys[i] % _Alignof(ec_affine_t)) == 0;
+    }
+    check(ok, "keystore: records are the affine keys");
+
+    ok = ks.keys != NULL;
+    if (ok) {
+        ec_point_t P3;
+        ec_affine_to_point(&ks.keys[3], &P3);
+        ok = ec3dh_compute_shared_secret_dk(&secp256r1, &d[2], &P3, k1, 32, m1, 32) == 0 &&
+             ec3dh_compute_shared_secret_trusted_dk(&secp256r1, &d[3], &ks.keys[2],
+                                                    k2, 32, m2, 32) == 0 &&
+             memcmp(k1, k2, 32) == 0 && memcmp(m1, m2, 32) == 0;
+        ok = ok && ecdsa_sign(&secp256r1, &d[5], msg, 6, r, s) == 0 &&
+             ecdsa_verify_trusted(&secp256r1, &ks.keys[5], msg, 6, r, s) == 1 &&
+             ecdsa_verify_trusted(&secp256r1, &ks.keys[6], msg, 6, r, s) == 0;
+    }
+    check(ok, "keystore: mapped keys work for ECDH and ECDSA");
+    ec_keystore_close(&ks);
+
+    {
+        /* flip one record byte: checksum fails unless skipped */
+        FILE *f = fopen(path, "r+b");
+        uint8_t b = 0;
+        ok = f && fseek(f, EC_KEYSTORE_HEADER_LEN + 5, SEEK_SET) == 0 && fread(&b, 1, 1, f) == 1;
+        b ^= 1;
+        ok = ok && fseek(f, EC_KEYSTORE_HEADER_LEN + 5, SEEK_SET) == 0 && fwrite(&b, 1, 1, f) == 1;
+        if (f) fclose(f);
+        ok = ok && ec_keystore_open(path, &secp256r1, 0, &ks) == EC_KEYSTORE_ERR_CHECKSUM &&
+             ks.keys == NULL;
+        ok = ok && ec_keystore_open(path, &secp256r1, EC_KEYSTORE_NO_CHECKSUM, &ks) == EC_KEYSTORE_OK;
+        ec_keystore_close(&ks);
+        check(ok, "keystore: corrupted record detected");
+    }
+
+    {
+        /* truncated file, invalid key, missing file */
+        FILE *f = fopen(path, "wb");
+        ok = f && fwrite("EC3DHKS1", 8, 1, f) == 1;
+        if (f) fclose(f);
+        ok = ok && ec_keystore_open(path, &secp256r1, 0, &ks) == EC_KEYSTORE_ERR_FORMAT;
+
+        ec_point_t bad = Q[4];
+        bad.y.limb[0] ^= 1;
+        ok = ok && ec_keystore_write(path, &secp256r1, &bad, 1) == EC_KEYSTORE_ERR_KEY;
+        ok = ok && ec_keystore_open(path, &secp256r1, 0, &ks) == EC_KEYSTORE_ERR_FORMAT;
+#ifndef _WIN32
+        {
+            /* the writer's temporary file is gone again */
+            DIR *dir = opendir(".");
+            struct dirent *ent;
+            size_t plen = strlen(path);
+            while (dir && (ent = readdir(dir)) != NULL) {
+                ok = ok && !(strncmp(ent->d_name, path, plen) == 0 && ent->d_name[plen] == '.');
+            }
+            if (dir) closedir(dir);
+        }
+#endif
+        remove(path);
+        ok = ok && ec_keystore_open(path, &secp256r1, 0, &ks) == EC_KEYSTORE_ERR_IO;
+        check(ok, "keystore: truncated file, invalid key and missing file rejected");
+    }
+}
+
 /* ---------- SEC1 codec ---------- */
 
 #define G_X "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296"
@@ -442,6 +1797,39 @@ static void test_codec(void) {
               "codec: Jacobian and affine 2G encode identically");
     }
 
+    /* batch encode: mixed affine/Jacobian input, one shared inversion,
+     * must match the per-point encoder byte for byte */
+    {
+        ec_point_t pts[3];
+        uint8_t batch[3 * 65], single[65];
+        int ok;
+        pts[0] = secp256r1.G;
+        ec_double_point(&secp256r1, &secp256r1.G, &pts[1]); /* Jacobian, Z != 1 */
+        pts[2] = point(G3_X, G3_Y);
+
+        ok = ec_points_to_bytes(&secp256r1, pts, 3, 0, batch, sizeof(batch)) == 0;
+        for (int i = 0; i < 3 && ok; i++) {
+            ok = ec_point_to_bytes(&secp256r1, &pts[i], 0, single, sizeof(single)) == 65 &&
+                 memcmp(batch + i * 65, single, 65) == 0;
+        }
+        check(ok, "codec: batch encode uncompressed matches single");
+
+        ok = ec_points_to_bytes(&secp256r1, pts, 3, 1, batch, 3 * 33) == 0;
+        for (int i = 0; i < 3 && ok; i++) {
+            ok = ec_point_to_bytes(&secp256r1, &pts[i], 1, single, sizeof(single)) == 33 &&
+                 memcmp(batch + i * 33, single, 33) == 0;
+        }
+        check(ok, "codec: batch encode compressed matches single");
+
+        check(ec_points_to_bytes(&secp256r1, pts, 3, 1, batch, 3 * 33 - 1) < 0,
+              "codec: batch encode refuses short output buffer");
+
+        memset(&pts[1], 0, sizeof(pts[1]));
+        pts[1].infinity = 1;
+        check(ec_points_to_bytes(&secp256r1, pts, 3, 0, batch, sizeof(batch)) < 0,
+              "codec: batch encode refuses infinity");
+    }
+
     /* rejections */
     {
         ec_point_t inf;
@@ -518,6 +1906,144 @@ static void test_codec(void) {
                  memcmp(ea, eb, 32) == 0 && memcmp(ma, mb, 32) == 0;
         check(ok, "codec: full serialized key exchange agrees");
     }
+
+    /* x-only decode: compressed keys go straight into the x-only ladder */
+    {
+        uint256_t da, db, xa, xb;
+        ec_point_t Qa, Qb;
+        uint8_t pa[33], pb[65];
+        uint8_t ea[32], ma[32], eb[32], mb[32];
+        int ok = ec3dh_generate_keypair(&secp256r1, &da, &Qa) == 0 &&
+                 ec3dh_generate_keypair(&secp256r1, &db, &Qb) == 0 &&
+                 ec_point_to_bytes(&secp256r1, &Qa, 1, pa, sizeof(pa)) == 33 &&
+                 ec_point_to_bytes(&secp256r1, &Qb, 0, pb, sizeof(pb)) == 65 &&
+                 ec_point_x_from_bytes(&secp256r1, pa, 33, &xa) == 0 &&
+                 ec_point_x_from_bytes(&secp256r1, pb, 65, &xb) == 0 &&
+                 ec3dh_compute_shared_secret_x_dk(&secp256r1, &db, &xa, eb, 32, mb, 32) == 0 &&
+                 ec3dh_compute_shared_secret_dk(&secp256r1, &da, &Qb, ea, 32, ma, 32) == 0 &&
+                 memcmp(ea, eb, 32) == 0 && memcmp(ma, mb, 32) == 0;
+        check(ok, "codec: x-only decode and exchange agrees");
+
+        memset(pa + 1, 0, 32);
+        pa[32] = 1; /* x = 1 lies on the twist */
+        check(ec_point_x_from_bytes(&secp256r1, pa, 33, &xa) < 0,
+              "codec: x-only decode rejects twist x");
+    }
+}
+
+/* ---------- keypair pool ---------- */
+
+#if !defined(_WIN32)
+#include <pthread.h>
+
+enum { POOL_TAKERS = 4, POOL_TAKES = 25 };
+
+typedef struct {
+    ec3dh_pool_t *pool;
+    uint256_t d[POOL_TAKES];
+    ec_point_t Q[POOL_TAKES];
+    int ok;
+} pool_taker_t;
+
+static void *pool_taker(void *arg) {
+    pool_taker_t *t = (pool_taker_t *)arg;
+    t->ok = 1;
+    for (int i = 0; i < POOL_TAKES; i++) {
+        t->ok &= ec3dh_take_keypair(t->pool, &t->d[i], &t->Q[i]) == EC3DH_OK;
+    }
+    return NULL;
+}
+#endif
+
+/* an RNG source that is down, counting how often it is asked */
+static int count_failures(void *ctx, uint8_t *buf, size_t len) {
+    (void)buf;
+    (void)len;
+    atomic_fetch_add((atomic_int *)ctx, 1);
+    return -1;
+}
+
+/* poll until the pool holds at least n keypairs; 0 on timeout */
+static int pool_wait_for(ec3dh_pool_t *pool, size_t n) {
+    for (int i = 0; i < 5000; i++) {
+        if (ec3dh_pool_available(pool) >= n) return 1;
+        sleep_ms(1);
+    }
+    return 0;
+}
+
+static void test_keypool(void) {
+    ec3dh_pool_t *pool = NULL;
+
+    check(ec3dh_pool_start(&pool, &secp256r1, 8, 8, 1) == EC3DH_ERR_POOL && !pool &&
+          ec3dh_pool_start(&pool, &secp256r1, 0, 8, 0) == EC3DH_ERR_POOL &&
+          ec3dh_pool_start(&pool, NULL, 0, 8, 1) == EC3DH_ERR_POOL,
+          "keypool: bad parameters rejected");
+
+    if (ec3dh_pool_start(&pool, &secp256r1, 4, 16, 2) != EC3DH_OK) {
+        check(0, "keypool: start");
+        return;
+    }
+    check(pool_wait_for(pool, 16) && ec3dh_pool_available(pool) <= 16,
+          "keypool: fills to the high water mark");
+
+    /* drain below low: the producers wake up and refill */
+    {
+        uint256_t d;
+        ec_point_t Q, want;
+        int ok = 1;
+        for (int i = 0; i < 14; i++) {
+            ok &= ec3dh_take_keypair(pool, &d, &Q) == EC3DH_OK;
+        }
+        ec_scalar_multiply(&secp256r1, &d, &secp256r1.G, &want);
+        ok = ok && !Q.infinity && u256_eq(&Q.x, &want.x) && u256_eq(&Q.y, &want.y);
+        check(ok, "keypool: taken keypair is consistent");
+        check(pool_wait_for(pool, 16), "keypool: refills after crossing the low mark");
+    }
+
+#if !defined(_WIN32)
+    /* concurrent takers never receive the same keypair */
+    {
+        static pool_taker_t t[POOL_TAKERS];
+        pthread_t th[POOL_TAKERS];
+        int ok = 1;
+
+        for (int i = 0; i < POOL_TAKERS; i++) {
+            t[i].pool = pool;
+            ok &= pthread_create(&th[i], NULL, pool_taker, &t[i]) == 0;
+        }
+        for (int i = 0; i < POOL_TAKERS; i++) {
+            pthread_join(th[i], NULL);
+            ok &= t[i].ok;
+        }
+        for (int a = 0; a < POOL_TAKERS * POOL_TAKES && ok; a++) {
+            for (int b = a + 1; b < POOL_TAKERS * POOL_TAKES; b++) {
+                const uint256_t *da = &t[a / POOL_TAKES].d[a % POOL_TAKES];
+                const uint256_t *db = &t[b / POOL_TAKES].d[b % POOL_TAKES];
+                if (u256_eq(da, db)) ok = 0;
+            }
+        }
+        check(ok, "keypool: concurrent takes hand out distinct keypairs");
+    }
+#endif
+
+    ec3dh_pool_stop(pool);
+
+    /* a failing source makes the producers back off, not spin */
+    {
+        static atomic_int calls;
+        int started;
+
+        ec_rng_set_callback(count_failures, &calls);
+        started = ec3dh_pool_start(&pool, &secp256r1, 2, 8, 2) == EC3DH_OK;
+        if (started) {
+            sleep_ms(300);
+            ec3dh_pool_stop(pool);
+        }
+        ec_rng_set_callback(NULL, NULL);
+        check(started && atomic_load(&calls) > 0 && atomic_load(&calls) < 50,
+              "keypool: producers back off while the RNG fails");
+    }
 }
 
 /* ---------- negative tests ---------- */
@@ -553,6 +2079,15 @@ static void test_rejections(void) {
               "reject: off-curve peer pubkey");
     }
 
+    /* x-only: twist point */
+    {
+        uint256_t d = u256(CAVP_D);
+        uint256_t x = u256("0000000000000000000000000000000000000000000000000000000000000001");
+        check(ec3dh_compute_shared_secret_x_dk(&secp256r1, &d, &x, enc, 32, mac, 32)
+                  == EC3DH_ERR_PUBKEY_INVALID,
+              "reject: x-only peer on the twist");
+    }
+
     /* peer public key = point at infinity */
     {
         uint256_t d = u256(CAVP_D);
@@ -565,15 +2100,151 @@ static void test_rejections(void) {
     }
 }
 
+/* ---------- heap use ---------- */
+
+/* Public entry points keep all state on the stack or in caller buffers.
+ * The test binary replaces the process allocator (which also catches
+ * calls made from inside libmodplus) and counts calls while alloc_watch
+ * is set. glibc exports the real allocator as __libc_*; on other C
+ * libraries the check is skipped. */
+#if defined(__GLIBC__)
+#define HAVE_ALLOC_HOOK 1
+
+extern void *__libc_malloc(size_t n);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *p, size_t n);
+extern void *__libc_memalign(size_t align, size_t n);
+extern void __libc_free(void *p);
+
+static volatile int alloc_watch = 0;
+static volatile unsigned long alloc_calls = 0;
+
+void *malloc(size_t n) {
+    if (alloc_watch) alloc_calls++;
+    return __libc_malloc(n);
+}
+
+void *calloc(size_t n, size_t size) {
+    if (alloc_watch) alloc_calls++;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t n) {
+    if (alloc_watch) alloc_calls++;
+    return __libc_realloc(p, n);
+}
+
+void *aligned_alloc(size_t align, size_t n) {
+    if (alloc_watch) alloc_calls++;
+    return __libc_memalign(align, n);
+}
+
+void free(void *p) {
+    if (alloc_watch && p) alloc_calls++;
+    __libc_free(p);
+}
+#endif
+
+static void test_no_heap(void) {
+#if defined(HAVE_ALLOC_HOOK)
+    const uint8_t msg[] = "sample";
+    const uint8_t *msgs[3] = {msg, msg, msg};
+    const size_t lens[3] = {6, 3, 0};
+    uint8_t rb[3][32], sb[3][32];
+    uint256_t d = u256(CAVP_D), d2[4], k, peer_x = u256(CAVP_PEER_X);
+    ec_point_t peer = point(CAVP_PEER_X, CAVP_PEER_Y), Q, Q2[4], P;
+    uint8_t enc[32], mac[32], r[32], s[32], buf[4 * EC_POINT_UNCOMPRESSED_LEN], okm[64];
+    int ok = 1;
+
+    /* the hook itself must see allocations, or the check below is vacuous */
+    {
+        void *(*volatile m)(size_t) = malloc;
+        alloc_calls = 0;
+        alloc_watch = 1;
+        free(m(16));
+        alloc_watch = 0;
+        check(alloc_calls == 2, "heap: allocator hook is active");
+    }
+
+    /* the pool allocates when started, not when taken from */
+    ec3dh_pool_t *pool = NULL;
+    ecdsa_nonce_pool_t *npool = NULL;
+    ok &= ec3dh_pool_start(&pool, &secp256r1, 1, 4, 1) == EC3DH_OK && pool_wait_for(pool, 4);
+    ok &= ecdsa_nonce_pool_start(&npool, &secp256r1, 1, 4, 1) == 0;
+    ecdsa_signing_key_t *skey = NULL;
+    ok &= ecdsa_signing_key_new(&skey, &secp256r1, &d) == 0;
+
+    alloc_calls = 0;
+    alloc_watch = 1;
+
+    ok &= ec3dh_generate_keypair(&secp256r1, &k, &Q) == 0;
+    ok &= pool && ec3dh_take_keypair(pool, &k, &Q) == 0;
+    ok &= ec3dh_generate_keypairs(&secp256r1, d2, Q2, 4) == 0;
+    ok &= ec3dh_compute_shared_secret_dk(&secp256r1, &d, &peer, enc, 32, mac, 32) == 0;
+    ok &= ec3dh_compute_shared_secret_x_dk(&secp256r1, &d, &peer_x, enc, 32, mac, 32) == 0;
+
+    ok &= npool && ecdsa_sign_pooled(npool, &d, msg, 6, r, s) == 0;
+    ok &= skey && ecdsa_signing_key_sign(skey, msg, 6, r, s) == 0;
+    ok &= ecdsa_sign(&secp256r1, &d, msg, 6, r, s) == 0;
+    ok &= ecdsa_sign_batch(&secp256r1, &d, msgs, lens, 3, rb, sb) == 0;
+    ok &= skey && ecdsa_signing_key_sign_batch(skey, msgs, lens, 3, rb, sb) == 0;
+    ec_scalar_multiply(&secp256r1, &d, &secp256r1.G, &Q);
+    ok &= ecdsa_verify(&secp256r1, &Q, msg, 6, r, s) == 1;
+
+    ok &= ec_point_to_bytes(&secp256r1, &Q, 1, buf, sizeof(buf)) == EC_POINT_COMPRESSED_LEN;
+    ok &= ec_point_from_bytes(&secp256r1, buf, EC_POINT_COMPRESSED_LEN, &P) == 0;
+    ok &= ec_point_x_from_bytes(&secp256r1, buf, EC_POINT_COMPRESSED_LEN, &peer_x) == 0;
+    ok &= ec_points_to_bytes(&secp256r1, Q2, 4, 0, buf, sizeof(buf)) == 0;
+    ok &= ec_point_from_bytes(&secp256r1, buf, EC_POINT_UNCOMPRESSED_LEN, &P) == 0;
+    ec_scalar_to_bytes(&d, r);
+    ok &= ec_scalar_from_bytes(&secp256r1, r, &k) == 0;
+
+    ok &= hkdf(r, 32, s, 32, msg, 6, okm, sizeof(okm)) == 0;
+    ok &= ecdh_derive_key(&d, "encryption", okm, 32) == 0;
+
+    alloc_watch = 0;
+    ec3dh_pool_stop(pool);
+    ecdsa_nonce_pool_stop(npool);
+    ecdsa_signing_key_free(skey);
+    check(ok, "heap: entry points succeed under the allocator hook");
+    check(alloc_calls == 0, "heap: keygen, pool take, ECDH, ECDSA (plain, batch and pooled), codec and KDF never allocate");
+#else
+    printf("skip  heap: no allocator hook for this C library\n");
+#endif
+}
+
 int main(void) {
     test_sha256();
+    test_sha256_lanes();
     test_hmac();
     test_hkdf();
+    test_csprng();
+    test_pool_fork();
+    test_field();
+    test_table_select();
     test_scalar_mult();
+    test_scalar_mult_vartime();
+    test_gtable();
+    test_scalar_mult_batch();
+    test_scalar_mult_lanes();
+    test_multi_scalar_mult();
+    test_scalar_mult_x();
     test_point_arith();
+    test_point_types();
+    test_scalar_mult_proj();
+    test_point_arith_general_a();
     test_ecdh();
+    test_scalar();
+    test_ecdsa();
+    test_ecdsa_stream();
+    test_ecdsa_batch();
+    test_ecdsa_signing_key();
+    test_ecdsa_pool();
+    test_keystore();
     test_codec();
+    test_keypool();
     test_rejections();
+    test_no_heap();
 
     printf("\n%d/%d tests passed\n", tests_run - tests_failed, tests_run);
     return tests_failed ? 1 : 0;
@@ -0,0 +1,100 @@
+/*
+ * gen_gtable.c
+ *
+ * Build-time generator for the secp256r1 fixed-base table (see
+ * inc/gtable.h). Writes a C source file to stdout. It builds from
+ * curve_params.c and libmodplus alone and uses plain affine arithmetic, so it
+ * does not depend on the library code that consumes the table.
+ */
+
+#include "ec.h"
+#include "curve_params.h"
+#include "gtable.h"
+
+#include <modplus.h>
+#include <stdio.h>
+
+static const ec_domain_params_t *curve = &secp256r1;
+
+/* R = P + Q for P != +-Q, neither the identity */
+static void affine_add(const ec_point_t *P, const ec_point_t *Q, ec_point_t *R) {
+    uint256_t dx, dy, lambda, l2, x3, y3;
+
+    mod_sub(&Q->x, &P->x, &curve->p, &dx);
+    mod_sub(&Q->y, &P->y, &curve->p, &dy);
+    mod_inv(&dx, &curve->p, &dx);
+    mod_mul(&dy, &dx, &curve->p, &lambda);
+
+    mod_mul(&lambda, &lambda, &curve->p, &l2);
+    mod_sub(&l2, &P->x, &curve->p, &x3);
+    mod_sub(&x3, &Q->x, &curve->p, &x3);
+    mod_sub(&P->x, &x3, &curve->p, &y3);
+    mod_mul(&lambda, &y3, &curve->p, &y3);
+    mod_sub(&y3, &P->y, &curve->p, &y3);
+
+    R->x = x3;
+    R->y = y3;
+}
+
+/* R = 2P, P not the identity */
+static void affine_double(const ec_point_t *P, ec_point_t *R) {
+    uint256_t num, den, lambda, l2, x3, y3;
+
+    mod_mul(&P->x, &P->x, &curve->p, &num);
+    mod_add(&num, &num, &curve->p, &l2);
+    mod_add(&l2, &num, &curve->p, &num);
+    mod_add(&num, &curve->a, &curve->p, &num);
+    mod_add(&P->y, &P->y, &curve->p, &den);
+    mod_inv(&den, &curve->p, &den);
+    mod_mul(&num, &den, &curve->p, &lambda);
+
+    mod_mul(&lambda, &lambda, &curve->p, &l2);
+    mod_sub(&l2, &P->x, &curve->p, &x3);
+    mod_sub(&x3, &P->x, &curve->p, &x3);
+    mod_sub(&P->x, &x3, &curve->p, &y3);
+    mod_mul(&lambda, &y3, &curve->p, &y3);
+    mod_sub(&y3, &P->y, &curve->p, &y3);
+
+    R->x = x3;
+    R->y = y3;
+}
+
+static void print_u256(const uint256_t *v) {
+    for (int i = 0; i < 4; i++) {
+        printf(" 0x%016llxULL,", (unsigned long long)v->limb[i]);
+    }
+}
+
+int main(void) {
+    ec_point_t base = curve->G, e;
+
+    printf("/* Generated by tools/gen_gtable.c; do not edit. */\n\n");
+    printf("#include \"gtable.h\"\n\n");
+    printf("const ec_affine_t p256_gtable[P256_GTABLE_WINDOWS][P256_GTABLE_ENTRIES] = {\n");
+
+    for (int i = 0; i < P256_GTABLE_WINDOWS; i++) {
+        printf("    { /* 16^%d G */\n", i);
+        e = base;
+        for (int j = 0; j < P256_GTABLE_ENTRIES; j++) {
+            printf("        { {{");
+            print_u256(&e.x);
+            printf(" }},\n          {{");
+            print_u256(&e.y);
+            printf(" }} },\n");
+
+            if (j == 0) {
+                affine_double(&base, &e);
+            } else {
+                affine_add(&e, &base, &e);
+            }
+        }
+        printf("    },\n");
+
+        for (int d = 0; d < 4; d++) {
+            affine_double(&base, &base);
+        }
+    }
+
+    printf("};\n");
+    return 0;
+}